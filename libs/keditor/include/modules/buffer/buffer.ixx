@@ -4,14 +4,24 @@
 //
 
 module;
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <optional>
 #include <raylib.h>
+#include <rlgl.h>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 export module keditor.buffer.buffer;
 
 import keditor.core.types;
+import keditor.core.line_metrics;
+import keditor.core.fold_map;
+import keditor.core.gap_vector;
 import keditor.buffer.piece_table;
 import plastic;
 import keditor.buffer.traits;
@@ -32,7 +42,13 @@ export namespace keditor
             Position cursor_{};
             Selection selection_{};
             std::size_t composition_timeout_ms_{500};
+            /// Lines longer than this are sized from the character grid instead of being measured.
+            Column measure_column_limit_{256};
             std::shared_ptr<plastic::Font> font_{};
+            /// When set, glyphs come from this atlas instead of font_, so any codepoint can be shown
+            std::shared_ptr<plastic::GlyphAtlas> atlas_{};
+            /// When set, font_ is its distance-field font and text is shaded through its shader
+            std::shared_ptr<plastic::SdfFont> sdf_font_{};
 
             struct CompositionState {
                 string_type buffer_{};
@@ -42,6 +58,10 @@ export namespace keditor
                 std::chrono::steady_clock::time_point last_input_;
                 bool force_commit_{false};
 
+                [[nodiscard]] bool is_active() const {
+                    return is_active_;
+                }
+
                 void reset() {
                     buffer_.clear();
                     is_active_ = false;
@@ -51,11 +71,30 @@ export namespace keditor
                 }
             } composition_;
 
+            /// @brief Text events received since the last frame, ingested together on the next layout.
+            struct PendingInput {
+                string_type text_{};
+                std::size_t event_count_{0};
+                std::chrono::steady_clock::time_point first_input_;
+
+                [[nodiscard]] bool empty() const {
+                    return event_count_ == 0;
+                }
+
+                void reset() {
+                    text_.clear();
+                    event_count_ = 0;
+                }
+            } pending_input_;
+
             struct VisualState {
                 float scroll_x_{0.0f};
                 float scroll_y_{0.0f};
                 bool cursor_visible_{true};
                 float cursor_blink_timer_{0.0f};
+                float cursor_blink_rate_{0.53f};
+                /// @brief GetTime() at the last blink update, negative before the first
+                double blink_clock_{-1.0};
                 plastic::TransitionProperty<float> cursor_opacity_{1.0f};
 
                 float line_height_{0.0f};
@@ -81,25 +120,172 @@ export namespace keditor
             struct LineCache {
                 struct Line {
                     string_type text_{};
+                    /// Horizontal offset only; the vertical placement comes from the fold map
                     plastic::Point<float> position_{};
                     plastic::Size<float> size_{};
                     bool is_dirty_{true};
+                    /// Bumped whenever text_ changes; cached glyph runs are keyed by it
+                    std::uint64_t version_{0};
+                    /// Glyph quads of the last column window painted, reused while the key matches
+                    mutable plastic::GlyphRun run_{};
                 };
-                std::vector<Line> lines_;
+                /// @brief Lines replaced by one edit, in the line numbering left by the edits before it.
+                struct Splice {
+                    keditor::Line first_{0};
+                    keditor::Line removed_{0};
+                    keditor::Line added_{0};
+                };
+
+                /// Kept in a gap vector so splicing lines in at the cursor does not shift the whole document
+                GapVector<Line> lines_;
                 bool is_dirty_{true};
+                /// Edits since the last layout, applied in order
+                std::vector<Splice> splices_{};
+                std::uint64_t next_version_{0};
+
+                /// Per-line widths, so the content size never has to walk every line.
+                LineMetrics metrics_{};
 
                 void invalidate() {
                     is_dirty_ = true;
-                    for (auto& line : lines_) {
-                        line.is_dirty_ = true;
+                    splices_.clear();
+                    for (std::size_t i = 0; i < lines_.size(); ++i) {
+                        lines_[i].is_dirty_ = true;
                     }
                 }
 
+                /// @brief Records an edit that replaced `removed` lines at `first` with `added` lines.
+                /// Every edit of a frame is queued and patched in place on the next layout.
+                void mark_edit(keditor::Line first, keditor::Line removed, keditor::Line added) {
+                    if (is_dirty_) {
+                        return;
+                    }
+                    splices_.push_back(Splice{first, removed, added});
+                }
+
+                [[nodiscard]] bool needs_update() const {
+                    return is_dirty_ || !splices_.empty();
+                }
+
                 [[nodiscard]] bool empty() const {
                     return lines_.empty();
                 }
             } line_cache_;
 
+            /// @brief Pending composition applied to the cursor line only.
+            /// The piece table and the rest of the line cache are untouched until the composition commits.
+            struct CompositionOverlay {
+                Line index_{0};
+                Column start_col_{0};
+                typename LineCache::Line line_{};
+                bool is_active_{false};
+                bool is_dirty_{false};
+
+                [[nodiscard]] bool covers(Line line) const {
+                    return is_active_ && index_ == line;
+                }
+
+                void reset() {
+                    line_.text_.clear();
+                    is_active_ = false;
+                    is_dirty_ = false;
+                }
+            } overlay_;
+
+            /// @brief Text rendered in tiles of a band of rows by a viewport-wide span of content
+            /// columns, each into its own texture. Tiles are placed in content space, so a tile is
+            /// re-rendered only when the lines it shows or the text style change; scrolling either
+            /// way costs one textured quad per visible tile.
+            struct TileCache {
+                static constexpr Line rows_per_tile_{32};
+                static constexpr Line no_band_{static_cast<Line>(-1)};
+
+                struct Tile {
+                    RenderTexture2D texture_{};
+                    Line band_{no_band_};
+                    /// Span of content x this tile covers, in tile widths
+                    std::size_t column_{0};
+                    /// Versions of the lines drawn, in row order; folds and edits both change it
+                    std::vector<std::uint64_t> versions_{};
+                    std::uint64_t last_used_{0};
+                };
+
+                /// Everything besides line contents that a rendered tile depends on
+                struct Key {
+                    std::uint64_t font_{0};
+                    float font_size_{0.0f};
+                    float letter_spacing_{0.0f};
+                    float line_height_{0.0f};
+                    unsigned char r_{0}, g_{0}, b_{0}, a_{0};
+
+                    bool operator==(const Key&) const = default;
+                };
+
+                std::vector<Tile> tiles_{};
+                std::vector<std::uint64_t> scratch_{};
+                Key key_{};
+                int width_{0};
+                int height_{0};
+                std::uint64_t frame_{0};
+                bool enabled_{true};
+
+                TileCache() = default;
+                // Textures are owned by one buffer; a copy starts with an empty cache
+                TileCache(const TileCache& other) : enabled_(other.enabled_) {}
+                TileCache& operator=(const TileCache& other) {
+                    if (this != &other) {
+                        release();
+                        enabled_ = other.enabled_;
+                    }
+                    return *this;
+                }
+                ~TileCache() {
+                    release();
+                }
+
+                void release() {
+                    for (auto& tile : tiles_) {
+                        if (tile.texture_.id != 0) {
+                            UnloadRenderTexture(tile.texture_);
+                        }
+                    }
+                    tiles_.clear();
+                }
+
+                [[nodiscard]] Tile* find(Line band, std::size_t column) {
+                    for (auto& tile : tiles_) {
+                        if (tile.band_ == band && tile.column_ == column) {
+                            return &tile;
+                        }
+                    }
+                    return nullptr;
+                }
+
+                /// @brief Tile at `band` and `column`, recycling the least recently used one once `capacity` tiles exist
+                Tile& acquire(Line band, std::size_t column, std::size_t capacity) {
+                    Tile* tile = find(band, column);
+                    if (!tile) {
+                        if (tiles_.size() < capacity) {
+                            tiles_.push_back({LoadRenderTexture(width_, height_)});
+                            tile = &tiles_.back();
+                        } else {
+                            tile = &*std::ranges::min_element(tiles_, {}, &Tile::last_used_);
+                        }
+                        tile->band_ = band;
+                        tile->column_ = column;
+                        tile->versions_.clear();
+                    }
+                    tile->last_used_ = frame_;
+                    return *tile;
+                }
+            };
+            mutable TileCache tiles_;
+
+            /// Collapsed regions; maps buffer lines to visual rows
+            FoldMap folds_{};
+            /// Returns the last line of the region starting at a line, if it can be folded
+            std::function<std::optional<Line>(Line)> fold_provider_{};
+
             std::function<void()> on_text_changed_;
             std::function<void()> on_cursor_moved_;
             std::function<void()> on_selection_changed_;
@@ -130,27 +316,27 @@ export namespace keditor
 
         public:
             explicit Buffer(string_type initial = {}) : buffer_(std::move(initial)) {
+                watch_buffer_edits();
                 font_ = plastic::font::get_default();
+                update_metrics();
                 update_line_cache();
             }
 
             void layout(plastic::Context* cx) override {
-                if (line_cache_.is_dirty_) {
+                flush_pending_input();
+                update_metrics();
+
+                if (line_cache_.needs_update()) {
                     update_line_cache();
                 }
+                if (overlay_.is_dirty_) {
+                    update_composition_overlay();
+                }
 
                 visual_.content_size_ = calc_content_size();
 
                 visual_.viewport_size_ = plastic::Size<float>{bounds.width(), bounds.height()};
-
-                if (font_) {
-                    // Measure "M" for approximating character width
-                    auto m_size = font_->measure_text(Traits::to_string("M"), style_.font_size_,
-                                                       style_.letter_spacing_);
-                    visual_.char_width_ = m_size.width();
-
-                    visual_.line_height_ = m_size.height() * style_.line_height_factor_;
-                }
+                update_cursor_blink(cx);
             }
 
 
@@ -159,7 +345,6 @@ export namespace keditor
                 if (buffer_.can_undo()) {
                     buffer_.undo();
                     update_cursor_position();
-                    line_cache_.invalidate();
                     if (on_text_changed_) {
                         on_text_changed_();
                     }
@@ -171,7 +356,6 @@ export namespace keditor
                 if (buffer_.can_redo()) {
                     buffer_.redo();
                     update_cursor_position();
-                    line_cache_.invalidate();
                     if (on_text_changed_) {
                         on_text_changed_();
                     }
@@ -184,29 +368,21 @@ export namespace keditor
             }
 
             void paint(plastic::Context* cx) const override {
-                BeginScissorMode(
-                    static_cast<int>(bounds.x()),
-                    static_cast<int>(bounds.y()),
-                    static_cast<int>(bounds.width()),
-                    static_cast<int>(bounds.height())
-                );
+                // Stale tiles are rendered first, so batching into them never interleaves with the screen
+                const bool tiled = tiles_.enabled_ && prepare_tiles();
+
+                bounds.apply_scissor();
 
                 if (selection_.is_active()) {
                     draw_selection();
                 }
 
-                for (const auto& line : line_cache_.lines_) {
-                    if (!is_line_visible(line)) {
-                        continue;
-                    }
-
-                    plastic::Point<float> draw_pos = get_screen_position(line.position_);
-
-                    // Convert to std::string for rendering
-                    // In production, have proper UTF-8 rendering
-                    std::string display_text = utf8_display(line.text_);
-
-                    font_->draw_text(display_text, draw_pos, style_.font_size_, style_.letter_spacing_, style_.text_color_);
+                if (tiled) {
+                    draw_tiles();
+                } else {
+                    auto [first_row, last_row] = visible_rows();
+                    draw_rows(first_row, last_row, {bounds.x() - visual_.scroll_x_, bounds.y() - visual_.scroll_y_},
+                              visual_.scroll_x_);
                 }
                 if (visual_.cursor_visible_) {
                     draw_cursor();
@@ -214,7 +390,7 @@ export namespace keditor
                 if (composition_.is_active_ && !composition_.buffer_.empty()) {
                     draw_composition();
                 }
-                EndScissorMode();
+                plastic::Rect<float>::stop_scissor();
             }
 
             bool process_event(const plastic::events::Event& event, plastic::Context* cx) override {
@@ -225,6 +401,7 @@ export namespace keditor
 
             void set_text(const string_type& text) {
                 buffer_ = keditor::piece::Table<CharT>(text);
+                watch_buffer_edits();
                 // might need to remove the reference Position constructor
                 Index idx(0);
                 Line line(0);
@@ -232,7 +409,11 @@ export namespace keditor
                 cursor_ = Position(idx, line, col);
                 selection_ = Selection();
                 composition_.reset();
+                pending_input_.reset();
+                overlay_.reset();
                 line_cache_.invalidate();
+                // A new document: folds of the old one mean nothing
+                folds_.reset(buffer_.line_count());
 
                 if (on_text_changed_) {
                     on_text_changed_();
@@ -245,10 +426,13 @@ export namespace keditor
             }
 
             void insert_text(const string_type& text) {
+                Range replaced{cursor_.index(), cursor_.index()};
                 if (selection_.is_active() && !selection_.is_empty()) {
-                    Range range = selection_.range();
-                    buffer_.remove(range.start(), range.end());
-                    cursor_.index(range.start());
+                    replaced = selection_.range();
+                }
+                if (!replaced.is_empty()) {
+                    buffer_.remove(replaced.start(), replaced.end());
+                    cursor_.index(replaced.start());
                 }
                 buffer_.insert(cursor_.index(), text);
                 cursor_.index(cursor_.index() + text.length());
@@ -260,7 +444,6 @@ export namespace keditor
                     on_text_changed_();
                 }
 
-                line_cache_.invalidate();
                 ensure_cursor_visible();
                 invalidate();
             }
@@ -280,11 +463,39 @@ export namespace keditor
                     on_text_changed_();
                 }
 
-                line_cache_.invalidate();
                 ensure_cursor_visible();
                 invalidate();
             }
 
+            /// @brief Draws through an atlas that rasterizes glyphs on demand, e.g.
+            /// `FontRegistry::instance().glyph_atlas("Plasevka", font::Weight::Regular, 32)`.
+            /// Pass nullptr to go back to the font's preloaded glyphs.
+            void set_glyph_atlas(std::shared_ptr<plastic::GlyphAtlas> atlas) {
+                atlas_ = std::move(atlas);
+                update_metrics();
+                line_cache_.invalidate();
+                invalidate();
+            }
+
+            /// @brief Draws with a distance-field font, so set_style() can change the size or zoom
+            /// without reloading anything. An atlas set with set_glyph_atlas() takes precedence.
+            void set_sdf_font(std::shared_ptr<plastic::SdfFont> font) {
+                sdf_font_ = std::move(font);
+                font_ = sdf_font_ ? sdf_font_->font() : plastic::font::get_default();
+                update_metrics();
+                line_cache_.invalidate();
+                invalidate();
+            }
+
+            /// @brief Renders the viewport text through cached row bands (on by default)
+            void set_tile_cache_enabled(bool enabled) {
+                tiles_.enabled_ = enabled;
+                if (!enabled) {
+                    tiles_.release();
+                }
+                invalidate();
+            }
+
             void set_style(const TextStyle& style) {
                 style_ = style;
                 line_cache_.invalidate();
@@ -309,6 +520,27 @@ export namespace keditor
                 return selection_;
             }
 
+            /// @brief Maps a screen point to a buffer index.
+            /// @note Only the line under the point is consulted, and its column is derived from
+            /// the character grid, so hit-testing cost does not depend on the line's length.
+            [[nodiscard]] Index index_at(const plastic::Point<float>& point) {
+                if (line_cache_.empty() || visual_.line_height_ <= 0.0f) {
+                    return 0;
+                }
+
+                float local_y = point.y - bounds.y() + visual_.scroll_y_;
+                auto row = static_cast<Line>(std::max(0.0f, local_y / visual_.line_height_));
+                Line line = std::min<Line>(folds_.line_of(row), line_cache_.lines_.size() - 1);
+
+                const auto& line_data = line_cache_.lines_[line];
+                float local_x = point.x - bounds.x() + visual_.scroll_x_ - line_data.position_.x;
+                Column column = visual_.char_width_ > 0.0f
+                    ? static_cast<Column>(std::max(0.0f, std::round(local_x / visual_.char_width_)))
+                    : 0;
+
+                return buffer_.position_to_index(line, std::min<Column>(column, line_data.text_.length()));
+            }
+
             void set_on_text_changed(std::function<void()> handler) {
                 on_text_changed_ = std::move(handler);
             }
@@ -321,6 +553,60 @@ export namespace keditor
                 on_selection_changed_ = std::move(handler);
             }
 
+            /// @brief Overrides how fold ranges are found, e.g. from matching brackets.
+            /// The provider returns the last line to hide below a header, or nothing if it cannot fold.
+            /// Without one, regions are derived from indentation.
+            void set_fold_provider(std::function<std::optional<Line>(Line)> provider) {
+                fold_provider_ = std::move(provider);
+            }
+
+            /// @brief Collapses the region starting at `header`
+            /// @return False when there is nothing to fold there
+            bool fold(Line header) {
+                if (line_cache_.needs_update()) {
+                    update_line_cache();
+                }
+                const auto last = fold_provider_ ? fold_provider_(header) : indentation_fold_end(header);
+                if (!last || !folds_.fold(header, *last)) {
+                    return false;
+                }
+                // Keep the cursor on screen by moving it onto the header
+                if (folds_.is_hidden(cursor_.line())) {
+                    selection_.is_active(false);
+                    cursor_.index(buffer_.position_to_index(header, 0));
+                    update_cursor_position();
+                    if (on_cursor_moved_) {
+                        on_cursor_moved_();
+                    }
+                }
+                invalidate();
+                return true;
+            }
+
+            bool unfold(Line header) {
+                if (!folds_.unfold(header)) {
+                    return false;
+                }
+                invalidate();
+                return true;
+            }
+
+            bool toggle_fold(Line header) {
+                return folds_.fold_at(header) ? unfold(header) : fold(header);
+            }
+
+            void unfold_all() {
+                if (!folds_.empty()) {
+                    folds_.unfold_all();
+                    invalidate();
+                }
+            }
+
+            /// @return Folded regions and the line <-> row mapping, for the gutter and scrollbars
+            [[nodiscard]] const FoldMap& folds() const {
+                return folds_;
+            }
+
             void move_cursor_left() {
                 if (composition_.is_active_) {
                     composition_.force_commit_ = true;
@@ -355,8 +641,8 @@ export namespace keditor
                 if (composition_.is_active_) {
                     composition_.force_commit_ = true;
                 }
-                if (cursor_.index() > 0) {
-                    Line prev_line = cursor_.line() - 1;
+                if (cursor_.line() > 0) {
+                    Line prev_line = previous_visible_line(cursor_.line());
                     cursor_.index(buffer_.position_to_index(prev_line, cursor_.col()));
                     update_cursor_position();
 
@@ -372,7 +658,7 @@ export namespace keditor
                 if (composition_.is_active_) {
                     composition_.force_commit_ = true;
                 }
-                Line next_line = cursor_.line() + 1;
+                Line next_line = next_visible_line(cursor_.line());
                 if (next_line < buffer_.line_count()) {
                     cursor_.index(buffer_.position_to_index(next_line, cursor_.col()));
                     update_cursor_position();
@@ -387,6 +673,9 @@ export namespace keditor
         protected:
             bool handle_event_impl(const plastic::events::KeyPressEvent& event, plastic::Context* cx) {
                 if (event.pressed) {
+                    // Keys must see the text typed before them in the same frame
+                    flush_pending_input();
+
                     visual_.cursor_visible_ = true;
                     visual_.cursor_blink_timer_ = 0.0f;
 
@@ -445,6 +734,20 @@ export namespace keditor
                             }
                             return true;
 
+                        case plastic::events::KeyboardKey::KEY_LEFT_BRACKET:
+                            if (event.ctrl.value_or(false) && event.shift.value_or(false)) {
+                                fold(cursor_.line());
+                                return true;
+                            }
+                            return false;
+
+                        case plastic::events::KeyboardKey::KEY_RIGHT_BRACKET:
+                            if (event.ctrl.value_or(false) && event.shift.value_or(false)) {
+                                unfold(cursor_.line());
+                                return true;
+                            }
+                            return false;
+
                         case plastic::events::KeyboardKey::KEY_BACKSPACE:
                             handle_backspace();
                             return true;
@@ -475,9 +778,61 @@ export namespace keditor
                 return false;
             }
 
-            bool handle_event_impl(plastic::events::TextInputEvent& event, plastic::Context* cx) {
-                auto now = std::chrono::steady_clock::now();
+            bool handle_event_impl(const plastic::events::MouseButtonEvent& event, plastic::Context* cx) {
+                plastic::Point<float> point{event.position.width(), event.position.height()};
+                if (!event.pressed || event.button != MOUSE_BUTTON_LEFT || !bounds.contains(point)) {
+                    return false;
+                }
+                flush_pending_input();
+                if (composition_.is_active()) {
+                    commit_composition();
+                }
+
+                Index index = index_at(point);
+                if (event.shift) {
+                    if (!selection_.is_active()) {
+                        selection_.is_active(true);
+                        selection_.anchor(cursor_);
+                    }
+                } else {
+                    selection_.is_active(false);
+                }
+
+                cursor_.index(index);
+                update_cursor_position();
+                visual_.cursor_visible_ = true;
+                visual_.cursor_blink_timer_ = 0.0f;
+
+                if (on_cursor_moved_) {
+                    on_cursor_moved_();
+                }
+                ensure_cursor_visible();
+                invalidate();
+                return true;
+            }
+
+            bool handle_event_impl(const plastic::events::TextInputEvent& event, plastic::Context* cx) {
+                // Only queue here; the whole frame's input is ingested at once by flush_pending_input()
+                if (pending_input_.empty()) {
+                    pending_input_.first_input_ = std::chrono::steady_clock::now();
+                    invalidate();
+                }
+                for (char c : event.text) {
+                    pending_input_.text_.push_back(static_cast<char_type>(c));
+                }
+                pending_input_.event_count_++;
+                return true;
+            }
+
+            /// @brief Ingests every text event queued since the last frame.
+            /// A single event keeps going through composition so IME input still previews; a burst
+            /// (paste, key repeat) is committed as one insert with one undo entry.
+            void flush_pending_input() {
+                if (pending_input_.empty()) {
+                    return;
+                }
 
+                auto now = pending_input_.first_input_;
                 if (composition_.is_active()) {
                     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - composition_.last_input_).count();
 
@@ -487,36 +842,35 @@ export namespace keditor
                     }
                 }
 
-                // Rest of the method remains the same
+                if (pending_input_.event_count_ > 1) {
+                    if (composition_.is_active()) {
+                        commit_composition();
+                    }
+                    insert_text(pending_input_.text_);
+                    pending_input_.reset();
+                    return;
+                }
+
                 composition_.is_active_ = true;
                 composition_.last_input_ = now;
                 composition_.force_commit_ = false; // Reset after checking
+                composition_.buffer_ += pending_input_.text_;
+                pending_input_.reset();
 
-
-                string_type input_text;
-                input_text.reserve(event.text.size());
-
-                for (char c : event.text) {
-                    input_text.push_back(static_cast<char_type>(c));
-                }
-                composition_.buffer_ += input_text;
-
-                line_cache_.invalidate();
+                overlay_.is_dirty_ = true;
                 invalidate();
-                return true;
             }
 
             void handle_backspace() {
                 if (composition_.is_active()) {
                     if (!composition_.buffer_.empty()) {
                         composition_.buffer_.pop_back();
-                        composition_.last_input_ = std::chrono::steady_clock::now();
-                        line_cache_.invalidate();
-                        invalidate();
                     } else {
                         composition_.delete_counter_++;
-                        composition_.last_input_ = std::chrono::steady_clock::now();
                     }
+                    composition_.last_input_ = std::chrono::steady_clock::now();
+                    overlay_.is_dirty_ = true;
+                    invalidate();
                     return;
                 }
 
@@ -548,11 +902,11 @@ export namespace keditor
             void commit_composition() {
                 if (!composition_.is_active_) return;
 
-                if (composition_.delete_counter_ > 0) {
-                    Index start = cursor_.index() >= composition_.delete_counter_
-                        ? cursor_.index() - composition_.delete_counter_
-                        : 0;
+                Index start = cursor_.index() >= composition_.delete_counter_
+                    ? cursor_.index() - composition_.delete_counter_
+                    : 0;
 
+                if (composition_.delete_counter_ > 0) {
                     buffer_.remove(start, cursor_.index());
                     cursor_.index(start);
                 }
@@ -565,12 +919,12 @@ export namespace keditor
                 // Update state
                 update_cursor_position();
                 composition_.reset();
+                overlay_.reset();
 
                 if (on_text_changed_) {
                     on_text_changed_();
                 }
 
-                line_cache_.invalidate();
                 ensure_cursor_visible();
                 invalidate();
             }
@@ -627,7 +981,7 @@ export namespace keditor
                 }
 
                 if (cursor_.line() > 0) {
-                    Line prev_line = cursor_.line() - 1;
+                    Line prev_line = previous_visible_line(cursor_.line());
                     cursor_.index(buffer_.position_to_index(prev_line, cursor_.col()));
                     update_cursor_position();
 
@@ -650,7 +1004,7 @@ export namespace keditor
                     selection_.anchor(cursor_);
                 }
 
-                Line next_line = cursor_.line() + 1;
+                Line next_line = next_visible_line(cursor_.line());
                 if (next_line < buffer_.line_count()) {
                     cursor_.index(buffer_.position_to_index(next_line, cursor_.col()));
                     update_cursor_position();
@@ -742,6 +1096,169 @@ export namespace keditor
             void update_cursor_position() {
                 cursor_ = buffer_.index_to_position(cursor_.index());
                 selection_.cursor(cursor_);
+                // The cursor never sits inside a collapsed region
+                if (folds_.line_count() == buffer_.line_count() && folds_.is_hidden(cursor_.line())) {
+                    folds_.reveal(cursor_.line());
+                }
+                if (composition_.is_active_) {
+                    overlay_.is_dirty_ = true;
+                }
+            }
+
+            [[nodiscard]] const typename LineCache::Line& display_line(Line line) const {
+                return overlay_.covers(line) ? overlay_.line_ : line_cache_.lines_[line];
+            }
+
+            /// @brief Draws the text of visual rows [first, last]; `origin` is where row 0, column 0 lands
+            /// @param window_x Content x at the left edge of the area drawn into; columns outside
+            /// one viewport width from there are skipped
+            void draw_rows(Line first, Line last, plastic::Point<float> origin, float window_x) const {
+                const bool sdf = sdf_font_ && !atlas_;
+                if (sdf) {
+                    sdf_font_->begin(plastic::TextEffects{style_.text_color_}, style_.font_size_);
+                }
+                // Only rows asked for are visited, folded lines never are
+                for (Line row = first; row <= last; ++row) {
+                    const Line i = folds_.line_of(row);
+                    if (i >= line_cache_.lines_.size()) {
+                        break;
+                    }
+                    const auto& line = display_line(i);
+
+                    // Only the columns under the viewport are handed to the font
+                    Range columns = visible_columns(line, window_x);
+                    if (columns.is_empty()) {
+                        continue;
+                    }
+
+                    const plastic::Point<float> draw_pos{
+                        origin.x + line.position_.x + static_cast<float>(columns.start()) * visual_.char_width_,
+                        origin.y + row_y(row)
+                    };
+
+                    // Glyphs are laid out once per line version and column window; scrolling only
+                    // translates the cached quads
+                    const plastic::GlyphRun::Key key{
+                        line.version_, font_stamp(), style_.font_size_, style_.letter_spacing_,
+                        columns.start(), columns.end()
+                    };
+                    if (!line.run_.matches(key)) {
+                        std::string display_text = utf8_display(
+                            std::basic_string_view<char_type>(line.text_).substr(columns.start(), columns.length()));
+                        if (atlas_) {
+                            line.run_.build(*atlas_, display_text, style_.font_size_, style_.letter_spacing_, key);
+                        } else {
+                            line.run_.build(*font_, display_text, style_.font_size_, style_.letter_spacing_, key);
+                        }
+                    }
+                    line.run_.draw(draw_pos, style_.text_color_);
+                }
+                if (sdf) {
+                    sdf_font_->end();
+                }
+            }
+
+            /// @brief Re-renders the tiles under the viewport whose lines or style changed.
+            /// @return False when there is nothing to tile, and the text should be drawn directly
+            bool prepare_tiles() const {
+                auto [first_row, last_row] = visible_rows();
+                if (first_row > last_row || visual_.line_height_ <= 0.0f || bounds.width() < 1.0f) {
+                    return false;
+                }
+
+                const auto rows = TileCache::rows_per_tile_;
+                const int width = static_cast<int>(std::ceil(bounds.width()));
+                const int height = static_cast<int>(std::ceil(static_cast<float>(rows) * visual_.line_height_));
+                if (width != tiles_.width_ || height != tiles_.height_) {
+                    tiles_.release();
+                    tiles_.width_ = width;
+                    tiles_.height_ = height;
+                }
+
+                const auto color = style_.text_color_;
+                const typename TileCache::Key key{
+                    font_stamp(), style_.font_size_, style_.letter_spacing_, visual_.line_height_,
+                    color.r, color.g, color.b, color.a
+                };
+                if (!(key == tiles_.key_)) {
+                    tiles_.key_ = key;
+                    for (auto& tile : tiles_.tiles_) {
+                        tile.versions_.clear();
+                    }
+                }
+
+                // Every tile on screen, up to two columns per band, plus a few kept warm for scrolling back
+                const auto [first_column, last_column] = visible_tile_columns();
+                const std::size_t capacity = 2 * static_cast<std::size_t>(std::ceil(bounds.height() / static_cast<float>(height))) + 6;
+                const Line row_count = folds_.row_count();
+                ++tiles_.frame_;
+                for (Line band = first_row / rows; band <= last_row / rows; ++band) {
+                    for (std::size_t column = first_column; column <= last_column; ++column) {
+                        auto& tile = tiles_.acquire(band, column, capacity);
+
+                        auto& versions = tiles_.scratch_;
+                        versions.clear();
+                        const Line band_last = std::min((band + 1) * rows, row_count);
+                        for (Line row = band * rows; row < band_last; ++row) {
+                            versions.push_back(display_line(folds_.line_of(row)).version_);
+                        }
+                        if (!tile.versions_.empty() && tile.versions_ == versions) {
+                            continue;
+                        }
+                        tile.versions_.swap(versions);
+
+                        plastic::begin_render_target(tile.texture_);
+                        ClearBackground(BLANK);
+                        // Blending into a transparent target leaves premultiplied colour with the glyph's
+                        // own alpha, so the tile composites exactly like text drawn straight to the screen
+                        rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA,
+                                                  RL_FUNC_ADD, RL_FUNC_ADD);
+                        BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+                        const float column_x = static_cast<float>(column) * static_cast<float>(tiles_.width_);
+                        draw_rows(band * rows, band_last == 0 ? 0 : band_last - 1,
+                                  {-column_x, -row_y(band * rows)}, column_x);
+                        EndBlendMode();
+                        plastic::end_render_target();
+                    }
+                }
+                return true;
+            }
+
+            /// @brief First and last tile column under the viewport
+            [[nodiscard]] std::pair<std::size_t, std::size_t> visible_tile_columns() const {
+                const auto width = static_cast<float>(tiles_.width_);
+                const float left = std::max(0.0f, visual_.scroll_x_);
+                const auto first = static_cast<std::size_t>(left / width);
+                const auto last = static_cast<std::size_t>((left + bounds.width() - 1.0f) / width);
+                return {first, std::max(first, last)};
+            }
+
+            void draw_tiles() const {
+                auto [first_row, last_row] = visible_rows();
+                const auto rows = TileCache::rows_per_tile_;
+                const auto [first_column, last_column] = visible_tile_columns();
+                BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+                for (Line band = first_row / rows; band <= last_row / rows; ++band) {
+                    for (std::size_t column = first_column; column <= last_column; ++column) {
+                        const auto* tile = tiles_.find(band, column);
+                        if (!tile) {
+                            continue;
+                        }
+                        // Render textures are stored upside down; whole pixels keep the glyphs sharp
+                        const Rectangle source{0.0f, 0.0f, static_cast<float>(tiles_.width_), -static_cast<float>(tiles_.height_)};
+                        const Vector2 position{
+                            std::round(bounds.x() + static_cast<float>(column * tiles_.width_) - visual_.scroll_x_),
+                            std::round(bounds.y() + row_y(band * rows) - visual_.scroll_y_)
+                        };
+                        DrawTextureRec(tile->texture_.texture, source, position, WHITE);
+                    }
+                }
+                EndBlendMode();
+            }
+
+            /// @brief Identifies the glyph source; changes when the font does or the atlas evicts a page
+            [[nodiscard]] std::uint64_t font_stamp() const {
+                return atlas_ ? atlas_->stamp() : font_->font_.texture.id;
             }
 
             void draw_cursor() const {
@@ -769,29 +1286,40 @@ export namespace keditor
                     draw_selection_line(start.line(), start.col(), end.col());
                     return;
                 }
-                draw_selection_line(start.line(), start.col(), static_cast<Index>(-1));
 
-                for (Line line = start.line() + 1; line < end.line(); ++line) {
-                    draw_selection_line(line, 0, static_cast<Index>(-1));
+                // Only the rows on screen are drawn, however many lines the selection spans
+                auto [first_row, last_row] = visible_rows();
+                first_row = std::max(first_row, folds_.row_of(start.line()));
+                last_row = std::min(last_row, folds_.row_of(end.line()));
+                for (Line row = first_row; row <= last_row && row < folds_.row_count(); ++row) {
+                    const Line line = folds_.line_of(row);
+                    if (line == start.line()) {
+                        draw_selection_line(line, start.col(), static_cast<Index>(-1));
+                    } else if (line == end.line()) {
+                        draw_selection_line(line, 0, end.col());
+                    } else if (line > start.line() && line < end.line()) {
+                        draw_selection_line(line, 0, static_cast<Index>(-1));
+                    }
                 }
-
-                // Draw the last line (partially)
-                draw_selection_line(end.line(), 0, end.col());
             }
 
             void draw_selection_line(Line line, Column start_col, Column end_col) const {
-                if (line >= line_cache_.lines_.size()) {
+                if (line >= line_cache_.lines_.size() || folds_.is_hidden(line)) {
                     return;
                 }
                 const auto& line_data = line_cache_.lines_[line];
-                string_type line_text = line_data.text_;
                 if (end_col == static_cast<Column>(-1)) {
-                    end_col = line_text.length();
+                    end_col = line_data.text_.length();
                 }
 
-                float x1 = line_data.position_.x() + start_col * visual_.char_width_;
-                float x2 = line_data.position_.x() + end_col * visual_.char_width_;
-                float y = line_data.position_.y();
+                // Clamp to the visible column window so a selection on a huge line stays cheap
+                Range columns = visible_columns(line_data);
+                start_col = std::max(start_col, columns.start());
+                end_col = std::min(end_col, std::max(columns.end(), start_col));
+
+                float x1 = line_data.position_.x + start_col * visual_.char_width_;
+                float x2 = line_data.position_.x + end_col * visual_.char_width_;
+                float y = line_y(line);
 
                 plastic::Point<float> pos1 = get_screen_position({x1, y});
                 plastic::Point<float> pos2 = get_screen_position({x2, y});
@@ -809,29 +1337,24 @@ export namespace keditor
                 if (!composition_.is_active_ || composition_.buffer_.empty()) {
                     return;
                 }
-                auto cursor_pos = get_cursor_screen_pos();
-                if (!cursor_pos) {
+                if (!overlay_.covers(cursor_.line())) {
                     return;
                 }
-                std::string display_text(composition_.buffer_.begin(), composition_.buffer_.end());
-                font_->draw_text(
-                    display_text, *cursor_pos,
-                    style_.font_size_,
-                    style_.letter_spacing_,
-                    style_.text_color_
-                    );
 
-                // Draw underline
-                float width = font_->measure_text(
-                    display_text,
-                    style_.font_size_,
-                    style_.letter_spacing_).width();
+                // The composed text itself is painted as part of the overlay line; only underline it here
+                const auto& line = overlay_.line_;
+                plastic::Point<float> start_pos{
+                    line.position_.x + static_cast<float>(overlay_.start_col_) * visual_.char_width_,
+                    line_y(overlay_.index_)
+                };
+                plastic::Point<float> pos = get_screen_position(start_pos);
+                float width = static_cast<float>(composition_.buffer_.length()) * visual_.char_width_;
 
                 DrawLine(
-                    static_cast<int>(cursor_pos->x()),
-                    static_cast<int>(cursor_pos->y() + visual_.line_height_ - 2),
-                    static_cast<int>(cursor_pos->x() + width),
-                    static_cast<int>(cursor_pos->y() + visual_.line_height_ - 2),
+                    static_cast<int>(pos.x),
+                    static_cast<int>(pos.y + visual_.line_height_ - 2),
+                    static_cast<int>(pos.x + width),
+                    static_cast<int>(pos.y + visual_.line_height_ - 2),
                     style_.text_color_.rl()
                 );
             }
@@ -841,13 +1364,17 @@ export namespace keditor
                     return std::nullopt;
                 }
                 const auto& line = line_cache_.lines_[cursor_.line()];
-                float x = line.position_.x();
+                float x = line.position_.x;
 
-                if (cursor_.col() > 0) {
-                    x += cursor_.col() * visual_.char_width_;
+                // While composing, the caret sits after the pending text
+                Column col = overlay_.covers(cursor_.line())
+                    ? overlay_.start_col_ + composition_.buffer_.length()
+                    : cursor_.col();
+                if (col > 0) {
+                    x += col * visual_.char_width_;
                 }
                 return plastic::Point<float>(bounds.x() + x - visual_.scroll_x_,
-                    bounds.y() + line.position_.y() - visual_.scroll_y_);
+                    bounds.y() + line_y(cursor_.line()) - visual_.scroll_y_);
             }
 
             plastic::Point<float> get_screen_position(plastic::Point<float>& pos) const {
@@ -857,22 +1384,150 @@ export namespace keditor
                 );
             }
 
-            bool is_line_visible(const typename LineCache::Line& line) const {
-                float screen_y = bounds.y() + line.position_.y - visual_.scroll_y_;
-                return screen_y + visual_.line_height_ >= bounds.y() &&
-                       screen_y <= bounds.y() + bounds.height();
+            /// @brief Visual rows intersecting the viewport, as an inclusive range
+            [[nodiscard]] std::pair<Line, Line> visible_rows() const {
+                const Line rows = folds_.row_count();
+                if (rows == 0 || visual_.line_height_ <= 0.0f) {
+                    return {1, 0};
+                }
+                auto first = static_cast<Line>(std::max(0.0f, std::floor(visual_.scroll_y_ / visual_.line_height_)));
+                auto last = static_cast<Line>(std::max(0.0f, (visual_.scroll_y_ + bounds.height()) / visual_.line_height_));
+                return {std::min(first, rows - 1), std::min(last, rows - 1)};
+            }
+
+            [[nodiscard]] float row_y(Line row) const {
+                return static_cast<float>(row) * visual_.line_height_;
+            }
+
+            [[nodiscard]] float line_y(Line line) const {
+                return row_y(folds_.row_of(line));
+            }
+
+            [[nodiscard]] Line previous_visible_line(Line line) const {
+                const Line row = folds_.row_of(line);
+                return row == 0 ? 0 : folds_.line_of(row - 1);
+            }
+
+            /// @return The first visible line after `line`, or the line count when there is none
+            [[nodiscard]] Line next_visible_line(Line line) const {
+                const Line row = folds_.row_of(line) + 1;
+                return row < folds_.row_count() ? folds_.line_of(row) : buffer_.line_count();
+            }
+
+            /// @brief Default fold range: the lines below `header` indented deeper than it
+            [[nodiscard]] std::optional<Line> indentation_fold_end(Line header) const {
+                const auto& lines = line_cache_.lines_;
+                const auto indent_of = [](const string_type& text) -> std::optional<Column> {
+                    for (Column i = 0; i < text.length(); ++i) {
+                        if (text[i] != ' ' && text[i] != '\t') {
+                            return i;
+                        }
+                    }
+                    return std::nullopt; // blank lines belong to whatever surrounds them
+                };
+
+                const auto base = header < lines.size() ? indent_of(lines[header].text_) : std::nullopt;
+                if (!base) {
+                    return std::nullopt;
+                }
+                std::optional<Line> last;
+                for (Line i = header + 1; i < lines.size(); ++i) {
+                    const auto indent = indent_of(lines[i].text_);
+                    if (!indent) {
+                        continue;
+                    }
+                    if (*indent <= *base) {
+                        break;
+                    }
+                    last = i;
+                }
+                return last;
+            }
+
+            /// @brief Column window of a line that intersects the viewport horizontally.
+            [[nodiscard]] Range visible_columns(const typename LineCache::Line& line) const {
+                return visible_columns(line, visual_.scroll_x_);
+            }
+
+            /// @brief Columns of `line` within one viewport width of content x `window_x`
+            [[nodiscard]] Range visible_columns(const typename LineCache::Line& line, float window_x) const {
+                const Column length = line.text_.length();
+                if (visual_.char_width_ <= 0.0f) {
+                    return {0, length};
+                }
+
+                float offset = window_x - line.position_.x;
+                auto first = static_cast<Column>(std::max(0.0f, std::floor(offset / visual_.char_width_)));
+                // One extra column on each side keeps partially visible glyphs on screen
+                auto count = static_cast<Column>(std::ceil(bounds.width() / visual_.char_width_)) + 2;
+
+                first = std::min(first, length);
+                if constexpr (std::is_same_v<char_type, char8_t>) {
+                    // Never start the window in the middle of a UTF-8 sequence
+                    while (first > 0 && first < length && utf8_helpers::is_continuation(line.text_[first])) {
+                        --first;
+                    }
+                }
+                return {first, std::min(length, first + count)};
             }
 
             plastic::Size<float> calc_content_size() const {
-                float max_width = 0;
-                float total_height = 0;
+                float max_width = line_cache_.metrics_.max_width();
+                if (overlay_.is_active_) {
+                    max_width = std::max(max_width, overlay_.line_.size_.width());
+                }
+                return plastic::Size<float>(max_width, row_y(folds_.row_count()));
+            }
+
+            void update_metrics() {
+                if (!font_) {
+                    return;
+                }
+                // Measure "M" for approximating character width
+                auto m_size = atlas_
+                    ? atlas_->measure_text("M", style_.font_size_, style_.letter_spacing_)
+                    : font_->measure_text("M", style_.font_size_, style_.letter_spacing_);
+                visual_.char_width_ = m_size.width();
+                visual_.line_height_ = m_size.height() * style_.line_height_factor_;
+            }
+
+            /// @brief Advances the caret blink, repainting only the caret when it flips, and asks an
+            /// idle loop to wake for the next flip instead of drawing every frame
+            void update_cursor_blink(plastic::Context* cx) {
+                const double now = GetTime();
+                const double elapsed = visual_.blink_clock_ < 0.0 ? 0.0 : now - visual_.blink_clock_;
+                visual_.blink_clock_ = now;
+                if (!is_focused()) {
+                    // Losing focus repainted the whole element, so the caret can settle unseen
+                    visual_.cursor_visible_ = true;
+                    visual_.cursor_blink_timer_ = 0.0f;
+                    return;
+                }
 
-                for (const auto& line : line_cache_.lines_) {
-                    max_width = std::max(max_width, line.position_.x + line.size_.width());
-                    total_height = std::max(total_height, line.position_.y + line.size_.height());
+                visual_.cursor_blink_timer_ += static_cast<float>(elapsed);
+                if (visual_.cursor_blink_timer_ >= visual_.cursor_blink_rate_) {
+                    visual_.cursor_blink_timer_ = std::fmod(visual_.cursor_blink_timer_, visual_.cursor_blink_rate_);
+                    visual_.cursor_visible_ = !visual_.cursor_visible_;
+                    if (auto pos = get_cursor_screen_pos(); pos && cx) {
+                        // draw_cursor truncates to whole pixels, so cover one extra column
+                        cx->add_damage(plastic::Rect<float>{std::floor(pos->x), std::floor(pos->y), 3.0f, visual_.line_height_ + 1.0f});
+                    }
+                }
+                if (cx) {
+                    cx->wake_after(visual_.cursor_blink_rate_ - visual_.cursor_blink_timer_);
                 }
+            }
 
-                return plastic::Size<float>(max_width, total_height);
+            /// @brief Size of a single line, measured exactly only when it is short.
+            [[nodiscard]] plastic::Size<float> measure_line(const string_type& line) const {
+                float height = visual_.line_height_ / style_.line_height_factor_;
+                if (line.length() > measure_column_limit_) {
+                    return plastic::Size<float>(static_cast<float>(line.length()) * visual_.char_width_, height);
+                }
+                if (atlas_) {
+                    return atlas_->measure_text(utf8_display(line), style_.font_size_, style_.letter_spacing_);
+                }
+                return font_->measure_text(utf8_display(line), style_.font_size_, style_.letter_spacing_);
             }
 
             void ensure_cursor_visible() {
@@ -928,69 +1583,152 @@ export namespace keditor
                 visual_.scroll_y_animation_.start();
             }
 
+            /// @brief Rebuilds the overlay line from the cursor line's cached text and the pending composition.
+            void update_composition_overlay() {
+                overlay_.is_dirty_ = false;
+                if (!composition_.is_active_ || cursor_.line() >= line_cache_.lines_.size()) {
+                    overlay_.reset();
+                    return;
+                }
+
+                const auto& source = line_cache_.lines_[cursor_.line()];
+                Column col = std::min<Column>(cursor_.col(), source.text_.length());
+                // Pending deletes are only previewed up to the start of the line
+                Column erase = std::min<Column>(composition_.delete_counter_, col);
+
+                overlay_.index_ = cursor_.line();
+                overlay_.start_col_ = col - erase;
+                overlay_.line_.text_.assign(source.text_, 0, overlay_.start_col_);
+                overlay_.line_.text_ += composition_.buffer_;
+                overlay_.line_.text_.append(source.text_, col, string_type::npos);
+                overlay_.line_.position_ = source.position_;
+                overlay_.line_.size_ = measure_line(overlay_.line_.text_);
+                overlay_.line_.is_dirty_ = false;
+                overlay_.line_.version_ = ++line_cache_.next_version_;
+                overlay_.is_active_ = true;
+            }
+
+            /// @brief Routes every piece table edit, undo and redo included, into the line cache.
+            void watch_buffer_edits() {
+                buffer_.edit_listener([this](Range range, const string_type& text) {
+                    mark_lines_edited(range, text);
+                });
+            }
+
+            /// @brief Records which cached lines an edit of `range` into `text` will replace.
+            /// Runs from the piece table's edit listener, before the table is modified.
+            void mark_lines_edited(Range range, const string_type& text) {
+                Line first = buffer_.index_to_position(range.start()).line();
+                Line last = range.is_empty() ? first : buffer_.index_to_position(range.end()).line();
+                Line added = 1;
+                for (auto c : text) {
+                    if (Traits::is_newline(c)) {
+                        ++added;
+                    }
+                }
+                line_cache_.mark_edit(first, last - first + 1, added);
+                folds_.splice(first, last - first + 1, added);
+            }
+
             void update_line_cache() {
-                string_type text = buffer_.text();
+                if (!line_cache_.is_dirty_ && !line_cache_.splices_.empty()) {
+                    splice_line_cache();
+                } else {
+                    rebuild_line_cache();
+                }
+                line_cache_.metrics_.line_height(visual_.line_height_);
+                line_cache_.is_dirty_ = false;
+                line_cache_.splices_.clear();
 
-                string_type display_text = text;
+                // The overlay borrows the cursor line's text, so rebuild it against the new cache
                 if (composition_.is_active_) {
-                    // Apply any pending delete
-                    if (composition_.delete_counter_ > 0 && cursor_.index() >= composition_.delete_counter_) {
-                        Index start = cursor_.index() - composition_.delete_counter_;
-                        display_text.erase(start, composition_.delete_counter_);
+                    overlay_.is_dirty_ = true;
+                }
+            }
+
+            /// @brief Re-reads and re-measures only the lines touched by this frame's edits.
+            /// The queued splices are replayed in order on the line structure first; only the
+            /// lines they leave behind are then read from the piece table, which is final by now.
+            void splice_line_cache() {
+                auto& lines = line_cache_.lines_;
+                auto& metrics = line_cache_.metrics_;
+
+                // Ranges [first, last) of lines still to read, kept in the numbering after each splice
+                std::vector<std::pair<Line, Line>> stale;
+                for (const auto& splice : line_cache_.splices_) {
+                    if (splice.first_ + splice.removed_ > lines.size()) {
+                        rebuild_line_cache();
+                        return;
                     }
+                    const Line removed_end = splice.first_ + splice.removed_;
+                    std::vector<std::pair<Line, Line>> next;
+                    next.reserve(stale.size() + 1);
+                    for (const auto [first, last] : stale) {
+                        if (first < splice.first_) {
+                            next.emplace_back(first, std::min(last, splice.first_));
+                        }
+                        if (last > removed_end) {
+                            next.emplace_back(std::max(first, removed_end) + splice.added_ - splice.removed_,
+                                              last + splice.added_ - splice.removed_);
+                        }
+                    }
+                    next.emplace_back(splice.first_, splice.first_ + splice.added_);
+                    stale = std::move(next);
+
+                    lines.splice(splice.first_, splice.removed_, std::vector<typename LineCache::Line>(splice.added_));
+                    metrics.splice(splice.first_, splice.removed_, std::vector<float>(splice.added_, 0.0f));
+                }
 
-                    // Insert composition buffer
-                    display_text.insert(cursor_.index(), composition_.buffer_);
+                for (const auto [first, last] : stale) {
+                    for (Line i = first; i < last; ++i) {
+                        string_type text = buffer_.line(i);
+                        plastic::Size<float> line_size = measure_line(text);
+                        metrics.set(i, line_size.width());
+                        lines[i] = {std::move(text), plastic::Point<float>(0, 0), line_size, false,
+                                    ++line_cache_.next_version_};
+                    }
                 }
+            }
+
+            void rebuild_line_cache() {
+                const string_type display_text = buffer_.text();
 
                 line_cache_.lines_.clear();
-                float y = 0;
+                std::vector<float> widths;
 
-                // Split text into lines
+                // Split text into lines; a trailing newline yields a final empty line like the piece table does
                 Index pos = 0;
-                while (pos < display_text.length()) {
+                while (true) {
                     Index line_end = display_text.find(Traits::to_string("\n")[0], pos);
-                    if (line_end == string_type::npos) {
+                    bool is_last = line_end == string_type::npos;
+                    if (is_last) {
                         line_end = display_text.length();
                     }
 
                     string_type line = display_text.substr(pos, line_end - pos);
 
                     // Calculate line metrics
-                    std::string display_line(line.begin(), line.end());
-                    plastic::Size<float> line_size = font_->measure_text(
-                        display_line,
-                        style_.font_size_,
-                        style_.letter_spacing_
-                    );
+                    plastic::Size<float> line_size = measure_line(line);
+                    widths.push_back(line_size.width());
 
-                    line_cache_.lines_.push_back({
-                        line,
-                        plastic::Point<float>(0, y),
-                        line_size,
-                        false
-                    });
+                    line_cache_.lines_.push_back({std::move(line), plastic::Point<float>(0, 0), line_size, false,
+                                                  ++line_cache_.next_version_});
 
-                    y += line_size.height() * style_.line_height_factor_;
+                    if (is_last) {
+                        break;
+                    }
                     pos = line_end + 1;
                 }
+                line_cache_.metrics_.assign(widths);
 
-                // Ensure we have at least one line
-                if (line_cache_.empty()) {
-                    plastic::Size<float> line_size = font_->measure_text(
-                        "",
-                        style_.font_size_,
-                        style_.letter_spacing_
-                    );
-
-                    line_cache_.lines_.push_back({
-                        string_type(),
-                        plastic::Point<float>(0, 0),
-                        line_size,
-                        false
-                    });
+                // Every edit, undo and redo included, already spliced the folds, so a rebuild (font or
+                // style change) keeps them. Only a count that drifted anyway is patched, at the end.
+                const Line count = line_cache_.lines_.size();
+                if (folds_.line_count() < count) {
+                    folds_.splice(folds_.line_count(), 0, count - folds_.line_count());
+                } else if (folds_.line_count() > count) {
+                    folds_.splice(count, folds_.line_count() - count, 0);
                 }
-                line_cache_.is_dirty_ = false;
             }
         };
     }
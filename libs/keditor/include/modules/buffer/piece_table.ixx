@@ -2,11 +2,14 @@
 /// @brief Piece Table implementation for keditor
 
 module;
+#include <algorithm>
+#include <functional>
 #include <stack>
 #include <string>
 #include <vector>
 export module keditor.buffer.piece_table;
 import keditor.core.types;
+import keditor.core.line_starts;
 import keditor.buffer.traits;
 import plastic.command;
 
@@ -107,33 +110,31 @@ export namespace keditor::piece
         std::vector<Piece> pieces_{};  ///< The list of pieces in the piece table.
         plastic::CommandManager command_manager_{}; ///< Manages undo/redo commands.
 
+        /// @brief Called with the replaced range and new text right before any edit, undo and redo included.
+        std::function<void(Range, const string_type&)> edit_listener_{};
+
+        void notify_edit(Range range, const string_type& text) const {
+            if (edit_listener_) {
+                edit_listener_(range, text);
+            }
+        }
+
     public:
         /**
          * @brief Represents a cache for line information.
          *
-         * The line cache stores the starting indices of lines in the text
-         * and provides efficient access to line-related information.
+         * The line cache keeps the length of every line in a LineStarts tree, so offset <-> line
+         * lookups are O(log n) and edits patch only the lines they touch instead of rescanning the text.
          */
         struct LineCache {
-            std::vector<Index> line_starts_{}; ///< The starting indices of lines.
         protected:
-            bool is_dirty_{true};              ///< Indicates if the cache is dirty.
+            LineStarts lines_{};  ///< Length of every line, trailing newline included.
+            bool is_dirty_{true}; ///< Indicates if the cache is dirty.
 
         public:
-            /// @return The starting indices of lines.
-            [[nodiscard]] std::vector<Index> line_starts() const { return line_starts_; }
-
             /// @return True if the cache is dirty, false otherwise.
             [[nodiscard]] bool is_dirty() const { return is_dirty_; }
 
-            /// @brief Sets the starting indices of lines.
-            /// @param starts The starting indices.
-            /// @return Reference to the current LineCache object.
-            LineCache& line_starts(const std::vector<Index>& starts) {
-                line_starts_ = starts;
-                return *this;
-            }
-
             /// @brief Sets the dirty state of the cache.
             /// @param dirty True if the cache is dirty.
             /// @return Reference to the current LineCache object.
@@ -148,7 +149,7 @@ export namespace keditor::piece
             }
 
             /**
-             * @brief Updates the line cache based on the given text.
+             * @brief Rebuilds the line cache from the given text.
              * @param text The text to analyze for line starts.
              */
             void update(const string_type& text) {
@@ -156,54 +157,98 @@ export namespace keditor::piece
                     return;
                 }
 
-                line_starts_.clear();
-                line_starts_.push_back(0); // First line always starts at 0
-
+                std::vector<Index> lengths;
+                Index line_start = 0;
                 for (Index i = 0; i < text.length(); ++i) {
                     if (Traits::is_newline(text[i])) {
-                        line_starts_.push_back(i+1);
+                        lengths.push_back(i + 1 - line_start);
+                        line_start = i + 1;
                     }
                 }
+                lengths.push_back(text.length() - line_start);
+                lines_.assign(lengths);
 
                 is_dirty_ = false;
             }
 
+            /**
+             * @brief Patches the lines touched by inserting `text` at `pos`.
+             * @param pos Position of the insertion, already clamped to the text length.
+             * @param text The inserted text.
+             */
+            void insert(Index pos, const string_type& text) {
+                if (is_dirty_) {
+                    return;
+                }
+
+                const Line line = lines_.line_of(pos);
+                const Index start = lines_.line_start(line);
+                const Index length = lines_.line_length(line);
+                const Index column = pos - start;
+
+                // The first new line keeps the head of the split line, the last one its tail
+                std::vector<Index> added;
+                Index segment_start = 0;
+                for (Index i = 0; i < text.length(); ++i) {
+                    if (Traits::is_newline(text[i])) {
+                        added.push_back(i + 1 - segment_start);
+                        segment_start = i + 1;
+                    }
+                }
+                added.push_back(text.length() - segment_start);
+                added.front() += column;
+                added.back() += length - column;
+                lines_.splice(line, 1, added);
+            }
+
+            /**
+             * @brief Patches the lines touched by removing [start, end).
+             * @param start Start of the removed range.
+             * @param end End of the removed range, already clamped to the text length.
+             */
+            void erase(Index start, Index end) {
+                if (is_dirty_ || start >= end) {
+                    return;
+                }
+
+                const Line first = lines_.line_of(start);
+                const Line last = lines_.line_of(end);
+                const Index joined = lines_.line_start(last) + lines_.line_length(last)
+                    - lines_.line_start(first) - (end - start);
+                lines_.splice(first, last - first + 1, {joined});
+            }
+
             /// @return The number of lines in the text.
             [[nodiscard]] Index line_count() const {
-                return line_starts_.size();
+                return lines_.line_count();
             }
 
             /**
              * @brief Retrieves the starting index of a specific line.
              * @param line The line number.
-             * @return The starting index of the line.
+             * @return The starting index of the line, or the text length past the last line.
              */
             [[nodiscard]] Index line_start(Index line) const {
-                return line < line_starts_.size()
-                    ? line_starts_[line]
-                    : line_starts_.empty() ? 0 : line_starts_.back();
+                return lines_.line_start(line);
             }
 
             /**
              * @brief Converts a character index to a line and column position.
              * @param index The character index.
-             * @param text The text buffer.
              * @return The position (line and column) corresponding to the index.
              */
-            [[nodiscard]] Position index_to_position(Index index, const string_type& text) const {
-                // Binary search to find line containing the index
-                auto it = std::upper_bound(line_starts_.begin(), line_starts_.end(), index);
-                Line line = std::distance(line_starts_.begin(), it) - 1;
+            [[nodiscard]] Position index_to_position(Index index) const {
+                Line line = lines_.line_of(index);
 
                 // Column is offset from the start of the line
-                Column column = index - line_starts_[line];
+                Column column = index - lines_.line_start(line);
 
                 return Position(index, line, column);
             }
         };
 
     protected:
-        LineCache line_cache_; ///< Cache for line-related information.
+        mutable LineCache line_cache_; ///< Cache for line-related information.
 
     public:
 
@@ -226,6 +271,14 @@ export namespace keditor::piece
         /// @return The command manager for undo/redo operations.
         plastic::CommandManager& command_manager() { return command_manager_; }
 
+        /// @brief Sets a callback run before every edit, while offsets still map to the old lines.
+        /// @param listener Receives the replaced range and the text that replaces it.
+        /// @return Reference to the current Table object.
+        Table& edit_listener(std::function<void(Range, const string_type&)> listener) {
+            edit_listener_ = std::move(listener);
+            return *this;
+        }
+
         /// @brief Sets the original text buffer.
         /// @param buffer The original text buffer.
         /// @return Reference to the current Table object.
@@ -288,7 +341,7 @@ export namespace keditor::piece
          * @param text The text to be inserted.
          */
         InsertCommand(Table& table, Index pos, const string_type& text)
-            : table_(table), pos_(pos), text_(text), old_pieces_(table.pieces()), old_add_buffer_size_(table.add_buffer().length()) {}
+            : table_(table), pos_(std::min(pos, table.length())), text_(text), old_pieces_(table.pieces()), old_add_buffer_size_(table.add_buffer().length()) {}
 
         /// @return Reference to the piece table.
         Table& table() { return table_; }
@@ -312,8 +365,10 @@ export namespace keditor::piece
 
         /// @brief Undoes the insert command.
         void undo() override {
+            table_.notify_edit({pos_, pos_ + text_.length()}, {});
             table_.pieces(old_pieces_);
             table_.add_buffer_.resize(old_add_buffer_size_);
+            table_.line_cache_.erase(pos_, pos_ + text_.length());
         }
 
         /// @return The name of the command.
@@ -356,7 +411,9 @@ export namespace keditor::piece
 
         /// @brief Undoes the delete command.
         void undo() override {
+            table_.notify_edit({start_, start_}, delete_text_);
             table_.pieces(old_pieces_);
+            table_.line_cache_.insert(start_, delete_text_);
         };
 
         /// @return The name of the command.
@@ -373,6 +430,7 @@ export namespace keditor::piece
     void insert_without_undo(Index pos, const string_type& text) {
         if (text.empty()) { return; }
         pos = std::min(pos, length());
+        notify_edit({pos, pos}, text);
 
         Index current_pos = 0;
         size_t piece_idx = 0;
@@ -408,8 +466,8 @@ export namespace keditor::piece
                 new_pieces.emplace_back(current.is_original(), current.start() + offset, current.length() - offset);
             }
 
-            // Copy remaining pieces
-            for (size_t i = piece_idx; i < pieces_.size(); ++i) {
+            // Copy remaining pieces; the split piece itself was re-emitted above
+            for (size_t i = piece_idx + 1; i < pieces_.size(); ++i) {
                 new_pieces.push_back(pieces_[i]);
             }
         } else {
@@ -419,7 +477,7 @@ export namespace keditor::piece
 
         add_buffer_ += text;
         pieces_ = std::move(new_pieces);
-        line_cache_.invalidate();
+        line_cache_.insert(pos, text);
     }
 
     /**
@@ -430,6 +488,7 @@ export namespace keditor::piece
     void remove_without_undo(Index start, Index end) {
         if (start >= end || start >= length()) return;
         end = std::min(end, length());
+        notify_edit({start, end}, {});
 
         // Find pieces that contain the range to remove
         std::vector<Piece> new_pieces;
@@ -463,7 +522,7 @@ export namespace keditor::piece
             current_pos = piece_end;
         }
         pieces_ = std::move(new_pieces);
-        line_cache_.invalidate();
+        line_cache_.erase(start, end);
     }
 
 public:
@@ -558,10 +617,12 @@ public:
             Index piece_end = current_pos + piece.length();
 
             if (current_pos < end && piece_end > start) {
-                Index piece_start = std::max(start - current_pos, Index{0});
+                Index piece_start = start > current_pos ? start - current_pos : 0;
                 Index piece_length = std::min(piece.length() - piece_start, end - (current_pos + piece_start));
 
-                result += piece.get_text(original_buffer_, add_buffer_).substr(piece_start, piece_length);
+                // Append straight from the source buffer; copying the whole piece first is O(document) for the original
+                const auto& source = piece.is_original() ? original_buffer_ : add_buffer_;
+                result.append(source, piece.start() + piece_start, piece_length);
             }
             current_pos = piece_end;
             if (current_pos >= end) break;
@@ -575,7 +636,7 @@ private:
      *
      * This method updates the line cache if it is marked as dirty.
      */
-    void ensure_line_cache_updated() {
+    void ensure_line_cache_updated() const {
         if (line_cache_.is_dirty()) {
             line_cache_.update(text());
         }
@@ -599,7 +660,7 @@ public:
      */
     [[nodiscard]] Position index_to_position(Index index) const {
         ensure_line_cache_updated();
-        return line_cache_.index_to_position(index, text());
+        return line_cache_.index_to_position(index);
     }
 
     /**
@@ -662,7 +723,6 @@ public:
     void undo() {
         if (command_manager_.can_undo()) {
             command_manager_.undo();
-            line_cache_.invalidate();
         }
     }
 
@@ -672,7 +732,6 @@ public:
     void redo() {
         if (command_manager_.can_redo()) {
             command_manager_.redo();
-            line_cache_.invalidate();
         }
     }
 
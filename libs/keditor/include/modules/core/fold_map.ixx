@@ -0,0 +1,402 @@
+/// @file fold_map.ixx
+/// @brief Mapping between buffer lines and visual rows under folded regions
+
+module;
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/// @brief Fold map module for keditor
+export module keditor.core.fold_map;
+
+import keditor.core.types;
+
+export namespace keditor
+{
+    /// @brief A collapsed region: `header` stays visible, lines (header, last] are hidden
+    struct Fold {
+        Line header{0};
+        Line last{0};
+
+        [[nodiscard]] bool hides(Line line) const {
+            return line > header && line <= last;
+        }
+    };
+
+    /// @brief Tracks which lines are hidden by folds and maps lines to visual rows
+    /// @note Every line carries the number of folds hiding it in an implicit treap, with a lazy
+    /// add for whole ranges. Folding or unfolding any region, row <-> line lookups and splicing
+    /// lines after an edit are all O(log n); the fold list itself is only walked on edits.
+    /// @note Only keditor::text::Buffer folds (Ctrl+Shift+[ and ]). The app still runs the legacy
+    /// kupui::TextArea, which has no folding, so the app itself does not fold yet.
+    struct FoldMap {
+    private:
+        static constexpr std::uint32_t nil_ = 0xFFFFFFFFu;
+
+        struct Node {
+            /// @brief Number of folds hiding this line
+            int hidden{0};
+            /// @brief Add still owed to both children
+            int lazy{0};
+            /// @brief Smallest `hidden` in the subtree and how many lines share it
+            int min{0};
+            Line min_count{1};
+            Line count{1};
+            std::uint32_t priority{0};
+            std::uint32_t left{nil_};
+            std::uint32_t right{nil_};
+        };
+
+        std::vector<Node> nodes_{};
+        std::vector<std::uint32_t> free_{};
+        std::uint32_t root_{nil_};
+        std::uint32_t seed_{0x1B873593u};
+
+        /// @brief Active folds, sorted by header
+        std::vector<Fold> folds_{};
+
+        std::uint32_t next_priority() {
+            seed_ ^= seed_ << 13;
+            seed_ ^= seed_ >> 17;
+            seed_ ^= seed_ << 5;
+            return seed_;
+        }
+
+        [[nodiscard]] Line count_of(std::uint32_t n) const {
+            return n == nil_ ? 0 : nodes_[n].count;
+        }
+
+        /// @brief Visible lines under `n`, given `add` still owed to it by its ancestors
+        [[nodiscard]] Line visible_of(std::uint32_t n, int add) const {
+            return n != nil_ && nodes_[n].min + add == 0 ? nodes_[n].min_count : 0;
+        }
+
+        void apply(std::uint32_t n, int delta) {
+            if (n == nil_) {
+                return;
+            }
+            nodes_[n].hidden += delta;
+            nodes_[n].min += delta;
+            nodes_[n].lazy += delta;
+        }
+
+        void push(std::uint32_t n) {
+            if (nodes_[n].lazy != 0) {
+                apply(nodes_[n].left, nodes_[n].lazy);
+                apply(nodes_[n].right, nodes_[n].lazy);
+                nodes_[n].lazy = 0;
+            }
+        }
+
+        void pull(std::uint32_t n) {
+            Node& node = nodes_[n];
+            node.count = 1 + count_of(node.left) + count_of(node.right);
+            node.min = node.hidden;
+            node.min_count = 1;
+            for (const auto child : {node.left, node.right}) {
+                if (child == nil_) {
+                    continue;
+                }
+                if (nodes_[child].min < node.min) {
+                    node.min = nodes_[child].min;
+                    node.min_count = nodes_[child].min_count;
+                } else if (nodes_[child].min == node.min) {
+                    node.min_count += nodes_[child].min_count;
+                }
+            }
+        }
+
+        std::uint32_t make_node(std::uint32_t priority) {
+            std::uint32_t n;
+            if (!free_.empty()) {
+                n = free_.back();
+                free_.pop_back();
+                nodes_[n] = Node{};
+            } else {
+                n = static_cast<std::uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+            nodes_[n].priority = priority;
+            return n;
+        }
+
+        void release(std::uint32_t n) {
+            if (n == nil_) {
+                return;
+            }
+            release(nodes_[n].left);
+            release(nodes_[n].right);
+            free_.push_back(n);
+        }
+
+        void split(std::uint32_t n, Line k, std::uint32_t& left, std::uint32_t& right) {
+            if (n == nil_) {
+                left = right = nil_;
+                return;
+            }
+            push(n);
+            if (count_of(nodes_[n].left) < k) {
+                split(nodes_[n].right, k - count_of(nodes_[n].left) - 1, nodes_[n].right, right);
+                left = n;
+            } else {
+                split(nodes_[n].left, k, left, nodes_[n].left);
+                right = n;
+            }
+            pull(n);
+        }
+
+        std::uint32_t merge(std::uint32_t left, std::uint32_t right) {
+            if (left == nil_) {
+                return right;
+            }
+            if (right == nil_) {
+                return left;
+            }
+            if (nodes_[left].priority > nodes_[right].priority) {
+                push(left);
+                nodes_[left].right = merge(nodes_[left].right, right);
+                pull(left);
+                return left;
+            }
+            push(right);
+            nodes_[right].left = merge(left, nodes_[right].left);
+            pull(right);
+            return right;
+        }
+
+        /// @brief Balanced subtree of `count` visible lines; priorities shrink with depth to keep the heap order
+        std::uint32_t build(Line count, std::uint32_t depth) {
+            if (count == 0) {
+                return nil_;
+            }
+            const Line half = count / 2;
+            const std::uint32_t n = make_node(0xFFFFFFFFu - depth * (1u << 26) - (next_priority() >> 8));
+            const std::uint32_t left = build(half, depth + 1);
+            const std::uint32_t right = build(count - half - 1, depth + 1);
+            nodes_[n].left = left;
+            nodes_[n].right = right;
+            pull(n);
+            return n;
+        }
+
+        /// @brief Adds `delta` to the hide count of lines [first, last]
+        void add_range(Line first, Line last, int delta) {
+            std::uint32_t left, middle, right;
+            split(root_, first, left, right);
+            split(right, last - first + 1, middle, right);
+            apply(middle, delta);
+            root_ = merge(merge(left, middle), right);
+        }
+
+        void remove_fold(std::vector<Fold>::iterator it) {
+            add_range(it->header + 1, it->last, -1);
+            folds_.erase(it);
+        }
+
+    public:
+        /// @brief Default constructor
+        FoldMap() = default;
+
+        /// @brief Forgets every fold and tracks `line_count` visible lines
+        void reset(Line line_count) {
+            nodes_.clear();
+            free_.clear();
+            folds_.clear();
+            root_ = build(line_count, 0);
+        }
+
+        /// @return Number of lines tracked, hidden or not
+        [[nodiscard]] Line line_count() const {
+            return count_of(root_);
+        }
+
+        /// @return Number of visual rows, i.e. lines not hidden by any fold
+        [[nodiscard]] Line row_count() const {
+            return visible_of(root_, 0);
+        }
+
+        [[nodiscard]] const std::vector<Fold>& folds() const {
+            return folds_;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return folds_.empty();
+        }
+
+        /// @return True when `line` is inside a collapsed region
+        [[nodiscard]] bool is_hidden(Line line) const {
+            int add = 0;
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Line left_count = count_of(nodes_[n].left);
+                if (line == left_count) {
+                    return nodes_[n].hidden + add > 0;
+                }
+                add += nodes_[n].lazy;
+                if (line < left_count) {
+                    n = nodes_[n].left;
+                } else {
+                    line -= left_count + 1;
+                    n = nodes_[n].right;
+                }
+            }
+            return false;
+        }
+
+        /// @return Visual row of `line`; a hidden line maps to the row after the last visible line above it
+        [[nodiscard]] Line row_of(Line line) const {
+            Line rows = 0;
+            int add = 0;
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Node& node = nodes_[n];
+                const Line left_count = count_of(node.left);
+                const int child_add = add + node.lazy;
+                if (line < left_count) {
+                    n = node.left;
+                } else {
+                    rows += visible_of(node.left, child_add);
+                    if (line == left_count) {
+                        return rows;
+                    }
+                    rows += node.hidden + add == 0 ? 1 : 0;
+                    line -= left_count + 1;
+                    n = node.right;
+                }
+                add = child_add;
+            }
+            return rows;
+        }
+
+        /// @return Buffer line shown on visual row `row`, clamped to the last visible line
+        [[nodiscard]] Line line_of(Line row) const {
+            const Line rows = row_count();
+            if (rows == 0) {
+                return 0;
+            }
+            row = std::min(row, rows - 1);
+
+            Line base = 0;
+            int add = 0;
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Node& node = nodes_[n];
+                const int child_add = add + node.lazy;
+                const Line left_visible = visible_of(node.left, child_add);
+                if (row < left_visible) {
+                    n = node.left;
+                    add = child_add;
+                    continue;
+                }
+                row -= left_visible;
+                if (node.hidden + add == 0) {
+                    if (row == 0) {
+                        return base + count_of(node.left);
+                    }
+                    --row;
+                }
+                base += count_of(node.left) + 1;
+                n = node.right;
+                add = child_add;
+            }
+            return base;
+        }
+
+        /// @return The fold whose header is `header`, if that line is collapsed
+        [[nodiscard]] std::optional<Fold> fold_at(Line header) const {
+            const auto it = std::ranges::lower_bound(folds_, header, {}, &Fold::header);
+            if (it != folds_.end() && it->header == header) {
+                return *it;
+            }
+            return std::nullopt;
+        }
+
+        /// @brief Collapses lines (header, last]
+        /// @return False when the range is empty, out of bounds, already folded at `header`,
+        /// or would partially overlap an existing fold
+        bool fold(Line header, Line last) {
+            if (last <= header || last >= line_count() || fold_at(header)) {
+                return false;
+            }
+            // Folds nest or stay apart; partial overlaps would leave lines nobody can unfold
+            for (const auto& other : folds_) {
+                const bool disjoint = other.last < header || last < other.header;
+                const bool inside = other.header <= header && last <= other.last;
+                const bool outside = header <= other.header && other.last <= last;
+                if (!disjoint && !inside && !outside) {
+                    return false;
+                }
+            }
+            add_range(header + 1, last, 1);
+            folds_.insert(std::ranges::upper_bound(folds_, header, {}, &Fold::header), Fold{header, last});
+            return true;
+        }
+
+        /// @brief Expands the fold whose header is `header`
+        bool unfold(Line header) {
+            const auto it = std::ranges::lower_bound(folds_, header, {}, &Fold::header);
+            if (it == folds_.end() || it->header != header) {
+                return false;
+            }
+            remove_fold(it);
+            return true;
+        }
+
+        /// @brief Expands every fold hiding `line`, e.g. when the cursor moves into one
+        bool reveal(Line line) {
+            bool changed = false;
+            for (auto it = folds_.begin(); it != folds_.end() && it->header < line;) {
+                if (it->hides(line)) {
+                    remove_fold(it);
+                    changed = true;
+                    // remove_fold erased the element, `it` already points at the next one
+                    continue;
+                }
+                ++it;
+            }
+            return changed;
+        }
+
+        void unfold_all() {
+            reset(line_count());
+        }
+
+        /// @brief Replaces `removed` lines at `first` with `added` visible lines.
+        /// Folds touched by the edit are expanded first, except when only a header line was
+        /// rewritten in place; folds below shift with the edit.
+        void splice(Line first, Line removed, Line added) {
+            first = std::min(first, line_count());
+            removed = std::min(removed, line_count() - first);
+            const bool in_place = removed == 1 && added == 1;
+            const Line edit_last = first + std::max<Line>(removed, 1) - 1;
+
+            for (auto it = folds_.begin(); it != folds_.end();) {
+                const bool touched = it->header <= edit_last && first <= it->last;
+                if (touched && !(in_place && first == it->header)) {
+                    remove_fold(it);
+                    continue;
+                }
+                ++it;
+            }
+
+            std::uint32_t left, middle, right;
+            split(root_, first, left, right);
+            split(right, removed, middle, right);
+            release(middle);
+            middle = nil_;
+            for (Line i = 0; i < added; ++i) {
+                middle = merge(middle, make_node(next_priority()));
+            }
+            root_ = merge(merge(left, middle), right);
+
+            for (auto& fold : folds_) {
+                if (fold.header >= first + removed) {
+                    fold.header = fold.header + added - removed;
+                    fold.last = fold.last + added - removed;
+                }
+            }
+        }
+    };
+}
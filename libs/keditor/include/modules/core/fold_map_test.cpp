@@ -0,0 +1,85 @@
+// Checks FoldMap's row <-> line mapping against the hidden lines implied by its own fold list.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+import keditor.core.types;
+import keditor.core.fold_map;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+static int check_consistent(const keditor::FoldMap& folds) {
+    keditor::Line row = 0;
+    for (keditor::Line line = 0; line < folds.line_count(); ++line) {
+        bool hidden = false;
+        for (const auto& fold : folds.folds()) {
+            hidden = hidden || fold.hides(line);
+        }
+        CHECK(folds.is_hidden(line) == hidden);
+        CHECK(folds.row_of(line) == row);
+        if (!hidden) {
+            CHECK(folds.line_of(row) == line);
+            ++row;
+        }
+    }
+    CHECK(folds.row_count() == row);
+    return 0;
+}
+
+int main() {
+    keditor::FoldMap folds;
+    folds.reset(10);
+    CHECK(folds.row_count() == 10);
+
+    CHECK(folds.fold(2, 6));
+    CHECK(folds.fold(3, 4));      // nested inside the first
+    CHECK(!folds.fold(5, 8));     // overlaps without nesting
+    CHECK(!folds.fold(2, 3));     // header already folded
+    CHECK(folds.row_count() == 6);
+    CHECK(folds.line_of(3) == 7);
+    CHECK(check_consistent(folds) == 0);
+
+    // Moving into a fold expands every fold around the line
+    CHECK(folds.reveal(4));
+    CHECK(folds.empty());
+    CHECK(folds.row_count() == 10);
+
+    // Edits above a fold shift it; an edit inside expands it
+    CHECK(folds.fold(5, 7));
+    folds.splice(1, 0, 2);
+    CHECK(folds.fold_at(7) && folds.fold_at(7)->last == 9);
+    folds.splice(8, 1, 0);
+    CHECK(folds.empty());
+
+    std::mt19937 rng(3);
+    folds.reset(40);
+    for (int step = 0; step < 2000; ++step) {
+        const auto lines = folds.line_count();
+        switch (rng() % 4) {
+            case 0:
+            case 1:
+                if (lines > 1) {
+                    const keditor::Line header = rng() % (lines - 1);
+                    folds.fold(header, header + 1 + rng() % std::min<keditor::Line>(6, lines - header - 1));
+                }
+                break;
+            case 2:
+                if (!folds.empty()) {
+                    folds.unfold(folds.folds()[rng() % folds.folds().size()].header);
+                }
+                break;
+            default: {
+                const keditor::Line first = rng() % (lines + 1);
+                const keditor::Line removed = std::min<keditor::Line>(rng() % 3, lines - first);
+                folds.splice(first, removed, rng() % 3);
+                break;
+            }
+        }
+        if (check_consistent(folds) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/// @file gap_vector.ixx
+/// @brief Sequence with a movable gap, for edits that cluster around one spot
+
+module;
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// @brief Gap vector module for keditor
+export module keditor.core.gap_vector;
+
+export namespace keditor
+{
+    /// @brief A vector with a hole of unused slots that follows the last edit
+    /// @note Replacing elements costs O(k) plus moving the gap, which is O(distance from the
+    /// previous edit). Typing in one place therefore never shifts the rest of the sequence.
+    /// @tparam T Element type; must be default constructible and movable
+    template <typename T>
+    struct GapVector {
+    private:
+        /// @brief Elements live in [0, gap_begin_) and [gap_end_, data_.size())
+        std::vector<T> data_{};
+        std::size_t gap_begin_{0};
+        std::size_t gap_end_{0};
+
+        [[nodiscard]] std::size_t gap_size() const {
+            return gap_end_ - gap_begin_;
+        }
+
+        void move_gap(std::size_t pos) {
+            if (gap_size() == 0) {
+                // Nothing to shift; moving elements onto themselves would empty them
+                gap_begin_ = gap_end_ = pos;
+            } else if (pos < gap_begin_) {
+                const std::size_t count = gap_begin_ - pos;
+                std::move_backward(data_.begin() + static_cast<std::ptrdiff_t>(pos),
+                                   data_.begin() + static_cast<std::ptrdiff_t>(gap_begin_),
+                                   data_.begin() + static_cast<std::ptrdiff_t>(gap_end_));
+                gap_begin_ -= count;
+                gap_end_ -= count;
+            } else if (pos > gap_begin_) {
+                const std::size_t count = pos - gap_begin_;
+                std::move(data_.begin() + static_cast<std::ptrdiff_t>(gap_end_),
+                          data_.begin() + static_cast<std::ptrdiff_t>(gap_end_ + count),
+                          data_.begin() + static_cast<std::ptrdiff_t>(gap_begin_));
+                gap_begin_ += count;
+                gap_end_ += count;
+            }
+        }
+
+        /// @brief Grows the gap so it holds at least `count` slots
+        void reserve_gap(std::size_t count) {
+            if (gap_size() >= count) {
+                return;
+            }
+            const std::size_t tail = data_.size() - gap_end_;
+            const std::size_t capacity = std::max(data_.size() * 2, size() + count + 16);
+            std::vector<T> data(capacity);
+            std::move(data_.begin(), data_.begin() + static_cast<std::ptrdiff_t>(gap_begin_), data.begin());
+            std::move(data_.begin() + static_cast<std::ptrdiff_t>(gap_end_), data_.end(),
+                      data.end() - static_cast<std::ptrdiff_t>(tail));
+            data_ = std::move(data);
+            gap_end_ = data_.size() - tail;
+        }
+
+    public:
+        /// @brief Default constructor
+        GapVector() = default;
+
+        [[nodiscard]] std::size_t size() const {
+            return data_.size() - gap_size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
+        }
+
+        T& operator[](std::size_t i) {
+            return data_[i < gap_begin_ ? i : i + gap_size()];
+        }
+
+        const T& operator[](std::size_t i) const {
+            return data_[i < gap_begin_ ? i : i + gap_size()];
+        }
+
+        void clear() {
+            data_.clear();
+            gap_begin_ = gap_end_ = 0;
+        }
+
+        void push_back(T value) {
+            move_gap(size());
+            reserve_gap(1);
+            data_[gap_begin_++] = std::move(value);
+        }
+
+        /// @brief Replaces `removed` elements at `first` with `added`
+        void splice(std::size_t first, std::size_t removed, std::vector<T>&& added) {
+            first = std::min(first, size());
+            removed = std::min(removed, size() - first);
+            move_gap(first);
+            // The removed elements join the gap; reset them so they do not hold on to resources
+            for (std::size_t i = 0; i < removed; ++i) {
+                data_[gap_end_ + i] = T{};
+            }
+            gap_end_ += removed;
+            reserve_gap(added.size());
+            std::move(added.begin(), added.end(), data_.begin() + static_cast<std::ptrdiff_t>(gap_begin_));
+            gap_begin_ += added.size();
+        }
+    };
+}
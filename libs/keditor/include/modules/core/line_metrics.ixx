@@ -0,0 +1,241 @@
+/// @file line_metrics.ixx
+/// @brief Per-line width tracking for scroll extents
+
+module;
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Line metrics module for keditor
+export module keditor.core.line_metrics;
+
+import keditor.core.types;
+
+export namespace keditor
+{
+    /// @brief Keeps the measured width of every line in an implicit treap holding the subtree maximum
+    /// @note Widest line and total height are O(1). Changing a line's width is O(log n), and so is
+    /// splicing lines in or out after an edit, plus O(k) for k new lines; nothing is re-measured.
+    struct LineMetrics {
+    private:
+        static constexpr std::uint32_t nil_ = 0xFFFFFFFFu;
+
+        struct Node {
+            float width{0.0f};
+            /// @brief Widest line in the subtree
+            float max_width{0.0f};
+            Line count{1};
+            std::uint32_t priority{0};
+            std::uint32_t left{nil_};
+            std::uint32_t right{nil_};
+        };
+
+        std::vector<Node> nodes_{};
+        std::vector<std::uint32_t> free_{};
+        std::uint32_t root_{nil_};
+        std::uint32_t seed_{0xC2B2AE35u};
+
+        /// @brief Height shared by every line
+        float line_height_{0.0f};
+
+        std::uint32_t next_priority() {
+            seed_ ^= seed_ << 13;
+            seed_ ^= seed_ >> 17;
+            seed_ ^= seed_ << 5;
+            return seed_;
+        }
+
+        [[nodiscard]] Line count_of(std::uint32_t n) const {
+            return n == nil_ ? 0 : nodes_[n].count;
+        }
+
+        [[nodiscard]] float max_of(std::uint32_t n) const {
+            return n == nil_ ? 0.0f : nodes_[n].max_width;
+        }
+
+        void pull(std::uint32_t n) {
+            Node& node = nodes_[n];
+            node.count = 1 + count_of(node.left) + count_of(node.right);
+            node.max_width = std::max(node.width, std::max(max_of(node.left), max_of(node.right)));
+        }
+
+        std::uint32_t make_node(float width, std::uint32_t priority) {
+            std::uint32_t n;
+            if (!free_.empty()) {
+                n = free_.back();
+                free_.pop_back();
+                nodes_[n] = Node{};
+            } else {
+                n = static_cast<std::uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+            nodes_[n].width = width;
+            nodes_[n].max_width = width;
+            nodes_[n].priority = priority;
+            return n;
+        }
+
+        void release(std::uint32_t n) {
+            if (n == nil_) {
+                return;
+            }
+            release(nodes_[n].left);
+            release(nodes_[n].right);
+            free_.push_back(n);
+        }
+
+        void split(std::uint32_t n, Line k, std::uint32_t& left, std::uint32_t& right) {
+            if (n == nil_) {
+                left = right = nil_;
+                return;
+            }
+            if (count_of(nodes_[n].left) < k) {
+                split(nodes_[n].right, k - count_of(nodes_[n].left) - 1, nodes_[n].right, right);
+                left = n;
+            } else {
+                split(nodes_[n].left, k, left, nodes_[n].left);
+                right = n;
+            }
+            pull(n);
+        }
+
+        std::uint32_t merge(std::uint32_t left, std::uint32_t right) {
+            if (left == nil_) {
+                return right;
+            }
+            if (right == nil_) {
+                return left;
+            }
+            if (nodes_[left].priority > nodes_[right].priority) {
+                nodes_[left].right = merge(nodes_[left].right, right);
+                pull(left);
+                return left;
+            }
+            nodes_[right].left = merge(left, nodes_[right].left);
+            pull(right);
+            return right;
+        }
+
+        /// @brief Balanced subtree over widths[first, first + count); priorities shrink with depth
+        std::uint32_t build(const std::vector<float>& widths, Line first, Line count, std::uint32_t depth) {
+            if (count == 0) {
+                return nil_;
+            }
+            const Line half = count / 2;
+            const std::uint32_t n = make_node(widths[first + half],
+                                              0xFFFFFFFFu - depth * (1u << 26) - (next_priority() >> 8));
+            const std::uint32_t left = build(widths, first, half, depth + 1);
+            const std::uint32_t right = build(widths, first + half + 1, count - half - 1, depth + 1);
+            nodes_[n].left = left;
+            nodes_[n].right = right;
+            pull(n);
+            return n;
+        }
+
+        /// @brief Sets the width of `line` under `n` and refreshes the maxima on the way back up
+        void set(std::uint32_t n, Line line, float width) {
+            const Line left_count = count_of(nodes_[n].left);
+            if (line < left_count) {
+                set(nodes_[n].left, line, width);
+            } else if (line > left_count) {
+                set(nodes_[n].right, line - left_count - 1, width);
+            } else {
+                nodes_[n].width = width;
+            }
+            pull(n);
+        }
+
+    public:
+        /// @brief Default constructor
+        LineMetrics() = default;
+
+        /// @brief Replaces every width at once
+        /// @param widths Width of each line, in line order
+        void assign(const std::vector<float>& widths) {
+            nodes_.clear();
+            free_.clear();
+            nodes_.reserve(widths.size());
+            root_ = build(widths, 0, widths.size(), 0);
+        }
+
+        /// @brief Updates the width of a single line
+        /// @param line Line to update
+        /// @param width New measured width
+        void set(Line line, float width) {
+            if (line >= count_of(root_)) {
+                return;
+            }
+            set(root_, line, width);
+        }
+
+        /// @brief Replaces `removed` lines starting at `first` with lines of the given widths
+        /// @param first First line affected by the edit
+        /// @param removed Number of lines the edit replaced
+        /// @param added Widths of the lines that replace them
+        void splice(Line first, Line removed, const std::vector<float>& added) {
+            first = std::min(first, count_of(root_));
+            removed = std::min(removed, count_of(root_) - first);
+            if (removed == added.size()) {
+                for (Line i = 0; i < added.size(); ++i) {
+                    set(first + i, added[i]);
+                }
+                return;
+            }
+
+            std::uint32_t left, middle, right;
+            split(root_, first, left, right);
+            split(right, removed, middle, right);
+            release(middle);
+            middle = nil_;
+            for (const float width : added) {
+                middle = merge(middle, make_node(width, next_priority()));
+            }
+            root_ = merge(merge(left, middle), right);
+        }
+
+        /// @return Width of the widest line
+        [[nodiscard]] float max_width() const {
+            return max_of(root_);
+        }
+
+        /// @return Width of a single line
+        [[nodiscard]] float width(Line line) const {
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Line left_count = count_of(nodes_[n].left);
+                if (line == left_count) {
+                    return nodes_[n].width;
+                }
+                if (line < left_count) {
+                    n = nodes_[n].left;
+                } else {
+                    line -= left_count + 1;
+                    n = nodes_[n].right;
+                }
+            }
+            return 0.0f;
+        }
+
+        /// @return Number of tracked lines
+        [[nodiscard]] Line line_count() const {
+            return count_of(root_);
+        }
+
+        /// @return Height of every line
+        [[nodiscard]] float line_height() const {
+            return line_height_;
+        }
+
+        /// @brief Sets the height shared by every line
+        LineMetrics& line_height(float height) {
+            line_height_ = height;
+            return *this;
+        }
+
+        /// @return Height of all lines stacked
+        [[nodiscard]] float total_height() const {
+            return static_cast<float>(count_of(root_)) * line_height_;
+        }
+    };
+}
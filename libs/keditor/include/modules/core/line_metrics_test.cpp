@@ -0,0 +1,54 @@
+// Checks LineMetrics' widest line and per-line widths through sets and splices.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+import keditor.core.types;
+import keditor.core.line_metrics;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+int main() {
+    using keditor::Line;
+
+    keditor::LineMetrics metrics;
+    metrics.line_height(10.0f);
+    std::vector<float> widths{5.0f, 40.0f, 12.0f};
+    metrics.assign(widths);
+    CHECK(metrics.line_count() == 3);
+    CHECK(metrics.max_width() == 40.0f);
+    CHECK(metrics.total_height() == 30.0f);
+
+    // Shrinking the widest line hands the maximum to the next one
+    metrics.set(1, 1.0f);
+    widths[1] = 1.0f;
+    CHECK(metrics.max_width() == 12.0f);
+
+    std::mt19937 rng(5);
+    for (int step = 0; step < 2000; ++step) {
+        if (!widths.empty() && rng() % 3 == 0) {
+            const Line line = rng() % widths.size();
+            widths[line] = static_cast<float>(rng() % 100);
+            metrics.set(line, widths[line]);
+        } else {
+            const Line first = rng() % (widths.size() + 1);
+            const Line removed = std::min<Line>(rng() % 3, widths.size() - first);
+            std::vector<float> added(rng() % 3);
+            for (auto& width : added) {
+                width = static_cast<float>(rng() % 100);
+            }
+            widths.erase(widths.begin() + first, widths.begin() + first + removed);
+            widths.insert(widths.begin() + first, added.begin(), added.end());
+            metrics.splice(first, removed, added);
+        }
+
+        CHECK(metrics.line_count() == widths.size());
+        CHECK(metrics.max_width() == (widths.empty() ? 0.0f : *std::ranges::max_element(widths)));
+        for (Line line = 0; line < widths.size(); ++line) {
+            CHECK(metrics.width(line) == widths[line]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+/// @file line_starts.ixx
+/// @brief Offset <-> line mapping that follows edits without rescanning the text
+
+module;
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief Line starts module for keditor
+export module keditor.core.line_starts;
+
+import keditor.core.types;
+
+export namespace keditor
+{
+    /// @brief Keeps the length of every line, trailing newline included, in an implicit treap
+    /// @note Line starts are prefix sums of the lengths, so offset -> line and line -> offset are
+    /// O(log n), and an edit only replaces the lengths of the lines it touched: O(log n + k) for
+    /// k new lines, instead of rescanning the whole text.
+    struct LineStarts {
+    private:
+        static constexpr std::uint32_t nil_ = 0xFFFFFFFFu;
+
+        struct Node {
+            /// @brief Length of this line, including its newline
+            Index length{0};
+            /// @brief Total length of the subtree
+            Index sum{0};
+            Line count{1};
+            std::uint32_t priority{0};
+            std::uint32_t left{nil_};
+            std::uint32_t right{nil_};
+        };
+
+        std::vector<Node> nodes_{};
+        std::vector<std::uint32_t> free_{};
+        std::uint32_t root_{nil_};
+        std::uint32_t seed_{0x85EBCA6Bu};
+
+        std::uint32_t next_priority() {
+            seed_ ^= seed_ << 13;
+            seed_ ^= seed_ >> 17;
+            seed_ ^= seed_ << 5;
+            return seed_;
+        }
+
+        [[nodiscard]] Line count_of(std::uint32_t n) const {
+            return n == nil_ ? 0 : nodes_[n].count;
+        }
+
+        [[nodiscard]] Index sum_of(std::uint32_t n) const {
+            return n == nil_ ? 0 : nodes_[n].sum;
+        }
+
+        void pull(std::uint32_t n) {
+            Node& node = nodes_[n];
+            node.count = 1 + count_of(node.left) + count_of(node.right);
+            node.sum = node.length + sum_of(node.left) + sum_of(node.right);
+        }
+
+        std::uint32_t make_node(Index length, std::uint32_t priority) {
+            std::uint32_t n;
+            if (!free_.empty()) {
+                n = free_.back();
+                free_.pop_back();
+                nodes_[n] = Node{};
+            } else {
+                n = static_cast<std::uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+            nodes_[n].length = length;
+            nodes_[n].sum = length;
+            nodes_[n].priority = priority;
+            return n;
+        }
+
+        void release(std::uint32_t n) {
+            if (n == nil_) {
+                return;
+            }
+            release(nodes_[n].left);
+            release(nodes_[n].right);
+            free_.push_back(n);
+        }
+
+        void split(std::uint32_t n, Line k, std::uint32_t& left, std::uint32_t& right) {
+            if (n == nil_) {
+                left = right = nil_;
+                return;
+            }
+            if (count_of(nodes_[n].left) < k) {
+                split(nodes_[n].right, k - count_of(nodes_[n].left) - 1, nodes_[n].right, right);
+                left = n;
+            } else {
+                split(nodes_[n].left, k, left, nodes_[n].left);
+                right = n;
+            }
+            pull(n);
+        }
+
+        std::uint32_t merge(std::uint32_t left, std::uint32_t right) {
+            if (left == nil_) {
+                return right;
+            }
+            if (right == nil_) {
+                return left;
+            }
+            if (nodes_[left].priority > nodes_[right].priority) {
+                nodes_[left].right = merge(nodes_[left].right, right);
+                pull(left);
+                return left;
+            }
+            nodes_[right].left = merge(left, nodes_[right].left);
+            pull(right);
+            return right;
+        }
+
+        /// @brief Balanced subtree over lengths[first, first + count); priorities shrink with depth
+        std::uint32_t build(const std::vector<Index>& lengths, Line first, Line count, std::uint32_t depth) {
+            if (count == 0) {
+                return nil_;
+            }
+            const Line half = count / 2;
+            const std::uint32_t n = make_node(lengths[first + half],
+                                              0xFFFFFFFFu - depth * (1u << 26) - (next_priority() >> 8));
+            const std::uint32_t left = build(lengths, first, half, depth + 1);
+            const std::uint32_t right = build(lengths, first + half + 1, count - half - 1, depth + 1);
+            nodes_[n].left = left;
+            nodes_[n].right = right;
+            pull(n);
+            return n;
+        }
+
+        [[nodiscard]] const Node* node_at(Line line) const {
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Line left_count = count_of(nodes_[n].left);
+                if (line == left_count) {
+                    return &nodes_[n];
+                }
+                if (line < left_count) {
+                    n = nodes_[n].left;
+                } else {
+                    line -= left_count + 1;
+                    n = nodes_[n].right;
+                }
+            }
+            return nullptr;
+        }
+
+    public:
+        /// @brief Default constructor
+        LineStarts() = default;
+
+        /// @brief Replaces every line at once
+        /// @param lengths Length of each line including its newline; the last line has none
+        void assign(const std::vector<Index>& lengths) {
+            nodes_.clear();
+            free_.clear();
+            nodes_.reserve(lengths.size());
+            root_ = build(lengths, 0, lengths.size(), 0);
+        }
+
+        /// @return Number of lines tracked
+        [[nodiscard]] Line line_count() const {
+            return count_of(root_);
+        }
+
+        /// @return Total length of the text
+        [[nodiscard]] Index length() const {
+            return sum_of(root_);
+        }
+
+        /// @return Length of `line` including its newline, 0 when out of range
+        [[nodiscard]] Index line_length(Line line) const {
+            const Node* node = node_at(line);
+            return node ? node->length : 0;
+        }
+
+        /// @return Offset of the first character of `line`; the text length when past the end
+        [[nodiscard]] Index line_start(Line line) const {
+            Index start = 0;
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Line left_count = count_of(nodes_[n].left);
+                if (line <= left_count) {
+                    if (line == left_count) {
+                        return start + sum_of(nodes_[n].left);
+                    }
+                    n = nodes_[n].left;
+                } else {
+                    start += sum_of(nodes_[n].left) + nodes_[n].length;
+                    line -= left_count + 1;
+                    n = nodes_[n].right;
+                }
+            }
+            return start;
+        }
+
+        /// @return Line containing `offset`; an offset just past a newline belongs to the next line,
+        /// offsets at or past the end belong to the last line
+        [[nodiscard]] Line line_of(Index offset) const {
+            if (root_ == nil_) {
+                return 0;
+            }
+            if (offset >= length()) {
+                return line_count() - 1;
+            }
+            Line line = 0;
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const Node& node = nodes_[n];
+                const Index left_sum = sum_of(node.left);
+                if (offset < left_sum) {
+                    n = node.left;
+                    continue;
+                }
+                offset -= left_sum;
+                if (offset < node.length) {
+                    return line + count_of(node.left);
+                }
+                offset -= node.length;
+                line += count_of(node.left) + 1;
+                n = node.right;
+            }
+            return line_count() - 1;
+        }
+
+        /// @brief Replaces `removed` lines at `first` with lines of the given lengths
+        void splice(Line first, Line removed, const std::vector<Index>& added) {
+            first = std::min(first, line_count());
+            removed = std::min(removed, line_count() - first);
+
+            std::uint32_t left, middle, right;
+            split(root_, first, left, right);
+            split(right, removed, middle, right);
+            release(middle);
+            middle = nil_;
+            for (const Index length : added) {
+                middle = merge(middle, make_node(length, next_priority()));
+            }
+            root_ = merge(merge(left, middle), right);
+        }
+    };
+}
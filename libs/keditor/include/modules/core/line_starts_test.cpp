@@ -0,0 +1,52 @@
+// Checks LineStarts against a plain vector of line lengths through random splices.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+import keditor.core.types;
+import keditor.core.line_starts;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+int main() {
+    using keditor::Index;
+    using keditor::Line;
+
+    // "ab\ncde\n\nf"
+    keditor::LineStarts starts;
+    std::vector<Index> lengths{3, 4, 1, 1};
+    starts.assign(lengths);
+    CHECK(starts.line_count() == 4);
+    CHECK(starts.length() == 9);
+    CHECK(starts.line_start(2) == 7);
+    CHECK(starts.line_of(0) == 0);
+    CHECK(starts.line_of(3) == 1);
+    CHECK(starts.line_of(7) == 2);
+    CHECK(starts.line_of(100) == 3);
+
+    std::mt19937 rng(11);
+    for (int step = 0; step < 2000; ++step) {
+        const Line first = rng() % (lengths.size() + 1);
+        const Line removed = std::min<Line>(rng() % 3, lengths.size() - first);
+        std::vector<Index> added(rng() % 3);
+        for (auto& length : added) {
+            length = rng() % 6 + 1;
+        }
+        lengths.erase(lengths.begin() + first, lengths.begin() + first + removed);
+        lengths.insert(lengths.begin() + first, added.begin(), added.end());
+        starts.splice(first, removed, added);
+
+        CHECK(starts.line_count() == lengths.size());
+        Index start = 0;
+        for (Line line = 0; line < lengths.size(); ++line) {
+            CHECK(starts.line_start(line) == start);
+            CHECK(starts.line_length(line) == lengths[line]);
+            CHECK(starts.line_of(start) == line || lengths[line] == 0);
+            start += lengths[line];
+        }
+        CHECK(starts.length() == start);
+    }
+    return 0;
+}
@@ -5,6 +5,10 @@
 export module keditor;
 
 export import keditor.core.types;
+export import keditor.core.line_metrics;
+export import keditor.core.fold_map;
+export import keditor.core.line_starts;
+export import keditor.core.gap_vector;
 export import keditor.buffer.traits;
 export import keditor.buffer.piece_table;
 export import keditor.buffer.buffer;
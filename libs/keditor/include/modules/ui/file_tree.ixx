@@ -106,7 +106,10 @@ export namespace kdtr::ui
         float font_size_{14.0f};
 
     public:
-        FileTree() = default;
+        /// The tree only changes on clicks, scrolling and reloads, so it is drawn from a cached layer
+        FileTree() {
+            set_layered(true);
+        }
 
         void set_root(const std::string& path) {
             nodes_.clear();
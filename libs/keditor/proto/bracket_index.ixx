@@ -0,0 +1,456 @@
+//
+// Incremental bracket nesting index.
+//
+
+module;
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+export module editor.bracket_index;
+export namespace editor
+{
+    struct Bracket {
+        std::uint32_t column{0};
+        char ch{'\0'};
+
+        [[nodiscard]] bool is_open() const {
+            return ch == '(' || ch == '[' || ch == '{';
+        }
+
+        [[nodiscard]] int delta() const {
+            return is_open() ? 1 : -1;
+        }
+    };
+
+    [[nodiscard]] inline bool is_bracket(char c) {
+        return c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}';
+    }
+
+    [[nodiscard]] inline char bracket_partner(char c) {
+        switch (c) {
+            case '(': return ')';
+            case ')': return '(';
+            case '[': return ']';
+            case ']': return '[';
+            case '{': return '}';
+            case '}': return '{';
+            default: return '\0';
+        }
+    }
+
+    /// @brief A bracket found by a query, with its nesting depth.
+    /// The depth is the number of brackets open around it: 0 for a top-level pair.
+    struct BracketLocation {
+        std::size_t line{0};
+        std::size_t column{0};
+        char ch{'\0'};
+        int depth{0};
+        bool mismatched{false}; ///< The partner found by depth has a different bracket type
+    };
+
+    /// @brief Brackets of every line kept in an implicit treap keyed by line number.
+    ///
+    /// Each subtree stores the net depth change of its lines and the lowest depth reached
+    /// before and after any of its brackets. That is enough to find the partner of a bracket,
+    /// or the pair enclosing a position, by descending the tree in O(log n); only the line the
+    /// answer lies on is scanned. Splicing lines in or out after an edit is O(log n) as well.
+    ///
+    /// @note Prototype: only SyntaxHighlighter keeps one up to date, and the highlighter itself is
+    /// not attached to any text view yet, so matching and rainbow brackets are not drawn anywhere.
+    class BracketIndex {
+    private:
+        static constexpr std::uint32_t nil_ = 0xFFFFFFFFu;
+        static constexpr int none_ = std::numeric_limits<int>::max() / 2;
+
+        struct Summary {
+            int delta{0};
+            int min_before{none_}; ///< Lowest depth in front of a bracket, relative to the start
+            int min_after{none_};  ///< Lowest depth right after a bracket, relative to the start
+
+            [[nodiscard]] Summary then(const Summary& next) const {
+                return {
+                    delta + next.delta,
+                    std::min(min_before, delta + next.min_before),
+                    std::min(min_after, delta + next.min_after)
+                };
+            }
+        };
+
+        struct Node {
+            std::vector<Bracket> brackets;
+            Summary line;
+            Summary total;
+            std::size_t count{1};
+            std::uint32_t priority{0};
+            std::uint32_t left{nil_};
+            std::uint32_t right{nil_};
+        };
+
+        std::vector<Node> nodes_{};
+        std::vector<std::uint32_t> free_{};
+        std::uint32_t root_{nil_};
+        std::uint32_t seed_{0x2545F491u};
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        std::uint32_t next_priority() {
+            seed_ ^= seed_ << 13;
+            seed_ ^= seed_ >> 17;
+            seed_ ^= seed_ << 5;
+            return seed_;
+        }
+
+        [[nodiscard]] std::size_t count_of(std::uint32_t n) const {
+            return n == nil_ ? 0 : nodes_[n].count;
+        }
+
+        [[nodiscard]] Summary total_of(std::uint32_t n) const {
+            return n == nil_ ? Summary{} : nodes_[n].total;
+        }
+
+        static Summary summarize(const std::vector<Bracket>& brackets) {
+            Summary summary;
+            for (const auto& bracket : brackets) {
+                summary.min_before = std::min(summary.min_before, summary.delta);
+                summary.delta += bracket.delta();
+                summary.min_after = std::min(summary.min_after, summary.delta);
+            }
+            return summary;
+        }
+
+        void pull(std::uint32_t n) {
+            Node& node = nodes_[n];
+            node.count = 1 + count_of(node.left) + count_of(node.right);
+            node.total = total_of(node.left).then(node.line).then(total_of(node.right));
+        }
+
+        std::uint32_t make_node(std::vector<Bracket> brackets) {
+            std::uint32_t n;
+            if (!free_.empty()) {
+                n = free_.back();
+                free_.pop_back();
+                nodes_[n] = Node{};
+            } else {
+                n = static_cast<std::uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+            nodes_[n].line = summarize(brackets);
+            nodes_[n].total = nodes_[n].line;
+            nodes_[n].brackets = std::move(brackets);
+            nodes_[n].priority = next_priority();
+            return n;
+        }
+
+        void release(std::uint32_t n) {
+            if (n == nil_) {
+                return;
+            }
+            release(nodes_[n].left);
+            release(nodes_[n].right);
+            nodes_[n].brackets = {};
+            free_.push_back(n);
+        }
+
+        void split(std::uint32_t n, std::size_t k, std::uint32_t& left, std::uint32_t& right) {
+            if (n == nil_) {
+                left = right = nil_;
+                return;
+            }
+            if (count_of(nodes_[n].left) < k) {
+                split(nodes_[n].right, k - count_of(nodes_[n].left) - 1, nodes_[n].right, right);
+                left = n;
+            } else {
+                split(nodes_[n].left, k, left, nodes_[n].left);
+                right = n;
+            }
+            pull(n);
+        }
+
+        std::uint32_t merge(std::uint32_t left, std::uint32_t right) {
+            if (left == nil_) {
+                return right;
+            }
+            if (right == nil_) {
+                return left;
+            }
+            if (nodes_[left].priority > nodes_[right].priority) {
+                nodes_[left].right = merge(nodes_[left].right, right);
+                pull(left);
+                return left;
+            }
+            nodes_[right].left = merge(left, nodes_[right].left);
+            pull(right);
+            return right;
+        }
+
+        void assign_line(std::uint32_t n, std::size_t line, std::vector<Bracket>&& brackets) {
+            const std::size_t left_count = count_of(nodes_[n].left);
+            if (line < left_count) {
+                assign_line(nodes_[n].left, line, std::move(brackets));
+            } else if (line > left_count) {
+                assign_line(nodes_[n].right, line - left_count - 1, std::move(brackets));
+            } else {
+                nodes_[n].line = summarize(brackets);
+                nodes_[n].brackets = std::move(brackets);
+            }
+            pull(n);
+        }
+
+        [[nodiscard]] const Node* node_at(std::size_t line) const {
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const std::size_t left_count = count_of(nodes_[n].left);
+                if (line < left_count) {
+                    n = nodes_[n].left;
+                } else if (line == left_count) {
+                    return &nodes_[n];
+                } else {
+                    line -= left_count + 1;
+                    n = nodes_[n].right;
+                }
+            }
+            return nullptr;
+        }
+
+        /// @brief First line at or after `from` with a bracket that leaves the depth below `threshold`
+        [[nodiscard]] std::size_t find_first(std::uint32_t n, std::size_t lo, std::size_t from, int base, int threshold) const {
+            if (n == nil_ || lo + nodes_[n].count <= from) {
+                return npos;
+            }
+            if (lo >= from && base + nodes_[n].total.min_after >= threshold) {
+                return npos;
+            }
+            const Node& node = nodes_[n];
+            const std::size_t at = lo + count_of(node.left);
+            if (const auto found = find_first(node.left, lo, from, base, threshold); found != npos) {
+                return found;
+            }
+            base += total_of(node.left).delta;
+            if (at >= from && base + node.line.min_after < threshold) {
+                return at;
+            }
+            return find_first(node.right, at + 1, from, base + node.line.delta, threshold);
+        }
+
+        /// @brief Last line before `to` with a bracket in front of which the depth is below `threshold`
+        [[nodiscard]] std::size_t find_last(std::uint32_t n, std::size_t lo, std::size_t to, int base, int threshold) const {
+            if (n == nil_ || lo >= to) {
+                return npos;
+            }
+            if (lo + nodes_[n].count <= to && base + nodes_[n].total.min_before >= threshold) {
+                return npos;
+            }
+            const Node& node = nodes_[n];
+            const std::size_t at = lo + count_of(node.left);
+            const int node_base = base + total_of(node.left).delta;
+            if (const auto found = find_last(node.right, at + 1, to, node_base + node.line.delta, threshold); found != npos) {
+                return found;
+            }
+            if (at < to && node_base + node.line.min_before < threshold) {
+                return at;
+            }
+            return find_last(node.left, lo, to, base, threshold);
+        }
+
+        [[nodiscard]] std::optional<BracketLocation> forward(std::size_t line, std::size_t skip, int depth, int threshold) const {
+            // Rest of the starting line first, then jump straight to the line holding the answer
+            if (const Node* node = node_at(line)) {
+                for (std::size_t i = skip; i < node->brackets.size(); ++i) {
+                    depth += node->brackets[i].delta();
+                    if (depth < threshold) {
+                        return BracketLocation{line, node->brackets[i].column, node->brackets[i].ch, depth};
+                    }
+                }
+            }
+            const std::size_t found = find_first(root_, 0, line + 1, 0, threshold);
+            if (found == npos) {
+                return std::nullopt;
+            }
+            depth = depth_at_line(found);
+            for (const auto& bracket : node_at(found)->brackets) {
+                depth += bracket.delta();
+                if (depth < threshold) {
+                    return BracketLocation{found, bracket.column, bracket.ch, depth};
+                }
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] std::optional<BracketLocation> backward(std::size_t line, std::size_t before, int threshold) const {
+            auto scan = [&](std::size_t l, std::size_t end) -> std::optional<BracketLocation> {
+                const Node* node = node_at(l);
+                int depth = depth_at_line(l);
+                std::optional<BracketLocation> last;
+                for (std::size_t i = 0; i < end; ++i) {
+                    if (depth < threshold) {
+                        last = BracketLocation{l, node->brackets[i].column, node->brackets[i].ch, depth};
+                    }
+                    depth += node->brackets[i].delta();
+                }
+                return last;
+            };
+
+            if (const Node* node = node_at(line)) {
+                if (auto found = scan(line, std::min(before, node->brackets.size()))) {
+                    return found;
+                }
+            }
+            const std::size_t found = find_last(root_, 0, line, 0, threshold);
+            if (found == npos) {
+                return std::nullopt;
+            }
+            return scan(found, node_at(found)->brackets.size());
+        }
+
+    public:
+        BracketIndex() = default;
+
+        /// @brief Collects the brackets of `text` for which `is_code(column)` holds.
+        template<typename IsCode>
+        [[nodiscard]] static std::vector<Bracket> scan(std::string_view text, IsCode&& is_code) {
+            std::vector<Bracket> brackets;
+            for (std::size_t i = 0; i < text.size(); ++i) {
+                if (is_bracket(text[i]) && is_code(i)) {
+                    brackets.push_back({static_cast<std::uint32_t>(i), text[i]});
+                }
+            }
+            return brackets;
+        }
+
+        [[nodiscard]] static std::vector<Bracket> scan(std::string_view text) {
+            return scan(text, [](std::size_t) { return true; });
+        }
+
+        /// @brief Replaces every line.
+        void assign(std::vector<std::vector<Bracket>> lines) {
+            nodes_.clear();
+            free_.clear();
+            root_ = nil_;
+            splice(0, 0, std::move(lines));
+        }
+
+        /// @brief Replaces `removed` lines starting at `first` with `added`.
+        void splice(std::size_t first, std::size_t removed, std::vector<std::vector<Bracket>> added) {
+            first = std::min(first, line_count());
+            removed = std::min(removed, line_count() - first);
+
+            std::uint32_t left, middle, right;
+            split(root_, first, left, right);
+            split(right, removed, middle, right);
+            release(middle);
+
+            middle = nil_;
+            for (auto& brackets : added) {
+                middle = merge(middle, make_node(std::move(brackets)));
+            }
+            root_ = merge(merge(left, middle), right);
+        }
+
+        /// @brief Replaces the brackets of one line, e.g. after it was re-tokenized.
+        void set_line(std::size_t line, std::vector<Bracket> brackets) {
+            if (line < line_count()) {
+                assign_line(root_, line, std::move(brackets));
+            }
+        }
+
+        [[nodiscard]] std::size_t line_count() const {
+            return count_of(root_);
+        }
+
+        /// @return Nesting depth at the start of `line`
+        [[nodiscard]] int depth_at_line(std::size_t line) const {
+            int depth = 0;
+            std::uint32_t n = root_;
+            while (n != nil_) {
+                const std::size_t left_count = count_of(nodes_[n].left);
+                if (line < left_count) {
+                    n = nodes_[n].left;
+                } else {
+                    depth += total_of(nodes_[n].left).delta;
+                    if (line == left_count) {
+                        break;
+                    }
+                    depth += nodes_[n].line.delta;
+                    line -= left_count + 1;
+                    n = nodes_[n].right;
+                }
+            }
+            return depth;
+        }
+
+        /// @return The partner of the bracket at (line, column), if there is a bracket there and it is closed
+        [[nodiscard]] std::optional<BracketLocation> match(std::size_t line, std::size_t column) const {
+            const Node* node = node_at(line);
+            if (!node) {
+                return std::nullopt;
+            }
+            const auto& brackets = node->brackets;
+            const auto it = std::ranges::lower_bound(brackets, column, {}, [](const Bracket& b) { return std::size_t{b.column}; });
+            if (it == brackets.end() || it->column != column) {
+                return std::nullopt;
+            }
+
+            const auto index = static_cast<std::size_t>(it - brackets.begin());
+            int depth = depth_at_line(line);
+            for (std::size_t i = 0; i < index; ++i) {
+                depth += brackets[i].delta();
+            }
+
+            std::optional<BracketLocation> found = it->is_open()
+                ? forward(line, index + 1, depth + 1, depth + 1)
+                : backward(line, index, depth);
+            if (found) {
+                found->depth = it->is_open() ? depth : depth - 1;
+                found->mismatched = found->ch != bracket_partner(it->ch);
+            }
+            return found;
+        }
+
+        /// @return The opening bracket of the innermost pair around (line, column)
+        [[nodiscard]] std::optional<BracketLocation> enclosing(std::size_t line, std::size_t column) const {
+            const Node* node = node_at(line);
+            if (!node) {
+                return std::nullopt;
+            }
+            int depth = depth_at_line(line);
+            std::size_t before = 0;
+            for (const auto& bracket : node->brackets) {
+                if (bracket.column >= column) {
+                    break;
+                }
+                depth += bracket.delta();
+                ++before;
+            }
+            if (depth <= 0) {
+                return std::nullopt;
+            }
+            auto found = backward(line, before, depth);
+            if (found && !Bracket{0, found->ch}.is_open()) {
+                return std::nullopt;
+            }
+            return found;
+        }
+
+        /// @brief Calls `fn(BracketLocation)` for every bracket on lines [first, last], in order.
+        /// Meant for colouring visible brackets by depth.
+        template<typename Fn>
+        void for_each(std::size_t first, std::size_t last, Fn&& fn) const {
+            int depth = depth_at_line(first);
+            for (std::size_t line = first; line <= last && line < line_count(); ++line) {
+                for (const auto& bracket : node_at(line)->brackets) {
+                    if (!bracket.is_open()) {
+                        --depth;
+                    }
+                    fn(BracketLocation{line, bracket.column, bracket.ch, depth});
+                    if (bracket.is_open()) {
+                        ++depth;
+                    }
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,356 @@
+//
+// Table-driven lexer for syntax highlighting.
+//
+
+module;
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+export module editor.dfa_lexer;
+import editor.syntax_highlighter;
+export namespace editor
+{
+    /// @brief Set of bytes a pattern step accepts.
+    using ByteSet = std::bitset<256>;
+
+    [[nodiscard]] inline ByteSet byte_range(unsigned char first, unsigned char last) {
+        ByteSet set;
+        for (unsigned c = first; c <= last; ++c) {
+            set.set(c);
+        }
+        return set;
+    }
+
+    [[nodiscard]] inline ByteSet bytes_of(std::string_view chars) {
+        ByteSet set;
+        for (const char c : chars) {
+            set.set(static_cast<unsigned char>(c));
+        }
+        return set;
+    }
+
+    /// @brief Declarative highlight grammar, compiled once into a DfaLexer.
+    ///
+    /// Tokens are matched longest-first; on equal length the rule added first wins, so keywords
+    /// should be added before the identifier rule. Regions (comments, strings) start with a literal
+    /// and run until their closing literal, or to the end of the line when it is empty. Multi-line
+    /// regions carry over to the next line through the LineState.
+    struct LexerGrammar {
+        struct Run {
+            ByteSet first;
+            ByteSet rest;
+            std::uint16_t style;
+        };
+
+        struct Literal {
+            std::string text;
+            std::uint16_t style;
+            int region{-1}; ///< Region this literal opens, -1 for a plain token
+        };
+
+        struct Region {
+            std::string close;
+            char escape{'\0'};
+            bool multiline{false};
+            std::uint16_t style;
+        };
+
+        std::vector<TokenStyle> styles{};
+        std::vector<Literal> literals{};
+        std::vector<Run> runs{};
+        std::vector<Region> regions{};
+
+        /// @brief Rule order across literals and runs; true selects the next literal
+        std::vector<bool> order{};
+
+        std::uint16_t style(const TokenStyle& style) {
+            styles.push_back(style);
+            return static_cast<std::uint16_t>(styles.size() - 1);
+        }
+
+        LexerGrammar& keywords(std::initializer_list<std::string_view> words, const TokenStyle& style) {
+            const auto id = this->style(style);
+            for (const auto word : words) {
+                literals.push_back({std::string(word), id});
+                order.push_back(true);
+            }
+            return *this;
+        }
+
+        LexerGrammar& symbols(std::initializer_list<std::string_view> symbols, const TokenStyle& style) {
+            return keywords(symbols, style);
+        }
+
+        /// @brief A token of one byte from `first` followed by any number of bytes from `rest`
+        LexerGrammar& run(const ByteSet& first, const ByteSet& rest, const TokenStyle& style) {
+            runs.push_back({first, rest, this->style(style)});
+            order.push_back(false);
+            return *this;
+        }
+
+        LexerGrammar& identifiers(const TokenStyle& style) {
+            const auto head = byte_range('a', 'z') | byte_range('A', 'Z') | bytes_of("_");
+            return run(head, head | byte_range('0', '9'), style);
+        }
+
+        LexerGrammar& numbers(const TokenStyle& style) {
+            return run(byte_range('0', '9'), byte_range('0', '9') | byte_range('a', 'z') | byte_range('A', 'Z') | bytes_of("._'"), style);
+        }
+
+        LexerGrammar& region(std::string_view open, std::string_view close, const TokenStyle& style,
+                             char escape = '\0', bool multiline = false) {
+            auto literal = style;
+            literal.literal = true;
+            const auto id = this->style(literal);
+            regions.push_back({std::string(close), escape, multiline, id});
+            literals.push_back({std::string(open), id, static_cast<int>(regions.size() - 1)});
+            order.push_back(true);
+            return *this;
+        }
+
+        LexerGrammar& line_comment(std::string_view open, const TokenStyle& style) {
+            return region(open, "", style);
+        }
+
+        LexerGrammar& block_comment(std::string_view open, std::string_view close, const TokenStyle& style) {
+            return region(open, close, style, '\0', true);
+        }
+
+        LexerGrammar& string(char quote, const TokenStyle& style, char escape = '\\') {
+            const char q[] = {quote, '\0'};
+            return region(q, q, style, escape);
+        }
+    };
+
+    /// @brief Lexer that scans each line once through a compiled DFA.
+    ///
+    /// The grammar's literals and runs are turned into an NFA and determinized up front; bytes
+    /// are folded into equivalence classes so the transition table stays small. Scanning does
+    /// no allocation: tokens are appended to the caller's vector, which is meant to be reused.
+    class DfaLexer : public Lexer {
+    private:
+        static constexpr std::uint16_t dead_ = 0;
+        static constexpr std::uint16_t start_ = 1;
+
+        struct Accept {
+            std::int32_t rule{-1}; ///< -1 when the state does not accept
+            std::uint16_t style{0};
+            std::int32_t region{-1};
+        };
+
+        struct CompiledRegion {
+            std::string close;
+            char escape;
+            bool multiline;
+            std::uint16_t style;
+        };
+
+        std::vector<TokenStyle> styles_;
+        std::vector<CompiledRegion> regions_;
+        std::array<std::uint8_t, 256> class_of_{};
+        std::size_t class_count_{1};
+        std::vector<std::uint16_t> next_;  ///< next_[state * class_count_ + class]
+        std::vector<Accept> accept_;
+
+        struct NfaState {
+            std::vector<std::pair<ByteSet, std::uint32_t>> edges;
+            Accept accept;
+        };
+
+        void compile(const LexerGrammar& grammar) {
+            // Thompson-style NFA without epsilons: every rule contributes its own entry state
+            std::vector<NfaState> nfa;
+            std::vector<std::uint32_t> entries;
+            std::size_t literal = 0;
+            std::size_t run = 0;
+            for (std::int32_t rule = 0; rule < static_cast<std::int32_t>(grammar.order.size()); ++rule) {
+                auto state = static_cast<std::uint32_t>(nfa.size());
+                entries.push_back(state);
+                nfa.emplace_back();
+                if (grammar.order[rule]) {
+                    const auto& lit = grammar.literals[literal++];
+                    for (const char c : lit.text) {
+                        nfa[state].edges.emplace_back(bytes_of(std::string_view(&c, 1)), state + 1);
+                        nfa.emplace_back();
+                        ++state;
+                    }
+                    nfa[state].accept = {rule, lit.style, lit.region};
+                } else {
+                    const auto& r = grammar.runs[run++];
+                    nfa[state].edges.emplace_back(r.first, state + 1);
+                    nfa.emplace_back();
+                    nfa[state + 1].edges.emplace_back(r.rest, state + 1);
+                    nfa[state + 1].accept = {rule, r.style, -1};
+                }
+            }
+
+            // Bytes that behave the same on every edge share a class
+            std::map<std::vector<bool>, std::uint8_t> signatures;
+            for (unsigned c = 0; c < 256; ++c) {
+                std::vector<bool> signature;
+                for (const auto& state : nfa) {
+                    for (const auto& [set, target] : state.edges) {
+                        signature.push_back(set.test(c));
+                    }
+                }
+                auto [it, inserted] = signatures.try_emplace(signature, static_cast<std::uint8_t>(signatures.size()));
+                class_of_[c] = it->second;
+            }
+            class_count_ = signatures.size();
+            std::vector<unsigned char> representative(class_count_);
+            for (unsigned c = 256; c-- > 0;) {
+                representative[class_of_[c]] = static_cast<unsigned char>(c);
+            }
+
+            // Subset construction; DFA state 0 is the dead state
+            std::map<std::vector<std::uint32_t>, std::uint16_t> ids;
+            std::vector<std::vector<std::uint32_t>> sets{{}, entries};
+            ids[{}] = dead_;
+            ids[entries] = start_;
+            next_.assign(2 * class_count_, dead_);
+            accept_.assign(2, Accept{});
+
+            for (std::size_t d = start_; d < sets.size(); ++d) {
+                for (const auto n : sets[d]) {
+                    const auto& a = nfa[n].accept;
+                    if (a.rule >= 0 && (accept_[d].rule < 0 || a.rule < accept_[d].rule)) {
+                        accept_[d] = a;
+                    }
+                }
+                for (std::size_t cls = 0; cls < class_count_; ++cls) {
+                    std::vector<std::uint32_t> target;
+                    for (const auto n : sets[d]) {
+                        for (const auto& [set, to] : nfa[n].edges) {
+                            if (set.test(representative[cls])) {
+                                target.push_back(to);
+                            }
+                        }
+                    }
+                    std::ranges::sort(target);
+                    target.erase(std::unique(target.begin(), target.end()), target.end());
+
+                    auto [it, inserted] = ids.try_emplace(target, static_cast<std::uint16_t>(sets.size()));
+                    if (inserted) {
+                        sets.push_back(std::move(target));
+                        next_.resize(sets.size() * class_count_, dead_);
+                        accept_.emplace_back();
+                    }
+                    next_[d * class_count_ + cls] = it->second;
+                }
+            }
+        }
+
+        /// @brief Scans a region body starting at `pos`; returns the end of the token
+        /// and sets `closed` when the closing literal was found on this line.
+        [[nodiscard]] std::size_t scan_region(const CompiledRegion& region, std::string_view line,
+                                              std::size_t pos, bool& closed) const {
+            closed = false;
+            if (region.close.empty()) {
+                return line.size();
+            }
+            const char first = region.close.front();
+            while (pos < line.size()) {
+                const char c = line[pos];
+                if (region.escape != '\0' && c == region.escape) {
+                    pos += 2;
+                    continue;
+                }
+                if (c == first && line.substr(pos, region.close.size()) == region.close) {
+                    closed = true;
+                    return pos + region.close.size();
+                }
+                ++pos;
+            }
+            return line.size();
+        }
+
+        /// `base` is where this line's tokens start in `out`; earlier tokens belong to other lines
+        static void emit(std::vector<Token>& out, std::size_t base, std::size_t start, std::size_t end, std::uint16_t style) {
+            if (end <= start) {
+                return;
+            }
+            if (out.size() > base && out.back().style == style && out.back().start + out.back().length == start) {
+                out.back().length += static_cast<std::uint32_t>(end - start);
+                return;
+            }
+            out.push_back({static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(end - start), style});
+        }
+
+    public:
+        explicit DfaLexer(const LexerGrammar& grammar) : styles_(grammar.styles) {
+            for (const auto& region : grammar.regions) {
+                regions_.push_back({region.close, region.escape, region.multiline, region.style});
+            }
+            compile(grammar);
+        }
+
+        /// @brief LineState 0 is plain code, n > 0 means the line starts inside region n - 1.
+        LineState tokenize(std::string_view line, LineState state, std::vector<Token>& out) const override {
+            std::size_t pos = 0;
+            const std::size_t base = out.size();
+            const auto* bytes = reinterpret_cast<const unsigned char*>(line.data());
+
+            if (state != 0 && state <= regions_.size()) {
+                const auto& region = regions_[state - 1];
+                bool closed;
+                pos = scan_region(region, line, 0, closed);
+                emit(out, base, 0, pos, region.style);
+                if (!closed) {
+                    return region.multiline ? state : LineState{0};
+                }
+            }
+
+            while (pos < line.size()) {
+                // Longest match from pos
+                std::uint16_t s = start_;
+                std::size_t end = 0;
+                const Accept* match = nullptr;
+                for (std::size_t i = pos; i < line.size(); ++i) {
+                    s = next_[s * class_count_ + class_of_[bytes[i]]];
+                    if (s == dead_) {
+                        break;
+                    }
+                    if (accept_[s].rule >= 0) {
+                        end = i + 1;
+                        match = &accept_[s];
+                    }
+                }
+
+                if (!match) {
+                    ++pos;
+                    continue;
+                }
+                if (match->region < 0) {
+                    emit(out, base, pos, end, match->style);
+                    pos = end;
+                    continue;
+                }
+
+                const auto& region = regions_[static_cast<std::size_t>(match->region)];
+                bool closed;
+                const std::size_t close = scan_region(region, line, end, closed);
+                emit(out, base, pos, close, region.style);
+                pos = close;
+                if (!closed && region.multiline) {
+                    return static_cast<LineState>(match->region + 1);
+                }
+            }
+            return 0;
+        }
+
+        [[nodiscard]] const std::vector<TokenStyle>& styles() const override {
+            return styles_;
+        }
+
+        /// @return Number of DFA states, including the dead state
+        [[nodiscard]] std::size_t state_count() const {
+            return accept_.size();
+        }
+    };
+}
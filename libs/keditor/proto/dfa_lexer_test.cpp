@@ -0,0 +1,63 @@
+// Checks DfaLexer's longest-match and rule-order tie breaking, regions, escapes and multi-line state.
+
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+import editor.syntax_highlighter;
+import editor.dfa_lexer;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+namespace
+{
+    /// Text of the token covering `offset`, or empty when none does
+    std::string_view token_at(std::string_view line, const std::vector<editor::Token>& tokens, std::size_t offset,
+                              std::uint16_t& style) {
+        for (const auto& token : tokens) {
+            if (offset >= token.start && offset < token.start + token.length) {
+                style = token.style;
+                return line.substr(token.start, token.length);
+            }
+        }
+        return {};
+    }
+}
+
+int main() {
+    editor::LexerGrammar grammar;
+    grammar.keywords({"if", "int"}, {})      // style 0
+        .identifiers({})                     // style 1
+        .numbers({})                         // style 2
+        .line_comment("//", {})              // style 3
+        .block_comment("/*", "*/", {})       // style 4
+        .string('"', {});                    // style 5
+    const editor::DfaLexer lexer(grammar);
+    CHECK(lexer.styles().size() == 6);
+
+    std::vector<editor::Token> tokens;
+    std::uint16_t style = 0;
+
+    // Keywords beat identifiers of the same length, longer identifiers beat keywords
+    const std::string_view code = "if iffy 42 \"a\\\"b\" // tail";
+    CHECK(lexer.tokenize(code, 0, tokens) == 0);
+    CHECK(token_at(code, tokens, 0, style) == "if" && style == 0);
+    CHECK(token_at(code, tokens, 3, style) == "iffy" && style == 1);
+    CHECK(token_at(code, tokens, 8, style) == "42" && style == 2);
+    CHECK(token_at(code, tokens, 11, style) == "\"a\\\"b\"" && style == 5);
+    CHECK(token_at(code, tokens, 18, style) == "// tail" && style == 3);
+
+    // A block comment left open carries its state to the next line, which closes it
+    tokens.clear();
+    const std::string_view open = "int x /* start";
+    const auto state = lexer.tokenize(open, 0, tokens);
+    CHECK(state != 0);
+    CHECK(token_at(open, tokens, 6, style) == "/* start" && style == 4);
+
+    tokens.clear();
+    const std::string_view close = "end */ y";
+    CHECK(lexer.tokenize(close, state, tokens) == 0);
+    CHECK(token_at(close, tokens, 0, style) == "end */" && style == 4);
+    CHECK(token_at(close, tokens, 7, style) == "y" && style == 1);
+    return 0;
+}
@@ -3,21 +3,20 @@
 //
 module;
 #include <raylib.h>
-#include <string>
-#if defined(_WIN32)
-#include <cmath>
-#endif
+#include <array>
+#include <cstddef>
+#include <cstdlib>
 export module line_numbers;
 import plastic.element;
 import plastic.color;
 import plastic.context;
 import plastic.size;
+import keditor.core.fold_map;
 
 
 export namespace editor {
     class LineNumbersWidget : public plastic::Element {
     private:
-        std::string text_content_;
         size_t line_count_{1};
         float line_height_{14.0f};
         int visible_start_{1};
@@ -26,15 +25,95 @@ export namespace editor {
         plastic::Color current_line_color_{plastic::Color::white()};
         int current_line_{1};
         float gutter_width_{40.0f};
+        bool relative_{false};
+        const keditor::FoldMap* folds_{nullptr};
+
+        Font font_{};  // raylib's default font until set_font()
+        float font_size_{12.0f};
+
+        // Digit advances are measured once per font and size; numbers are laid out from them
+        // without building strings
+        mutable std::array<float, 10> digit_advance_{};
+        mutable float glyph_spacing_{0.0f};
+        mutable bool glyphs_measured_{false};
+
+        // Width depends only on the number of digits, so it is only recomputed when that changes
+        size_t digits_{1};
+        mutable float number_width_{0.0f};
+        mutable bool width_dirty_{true};
+
+        static size_t count_digits(size_t value) {
+            size_t digits = 1;
+            while (value >= 10) {
+                value /= 10;
+                ++digits;
+            }
+            return digits;
+        }
+
+        [[nodiscard]] Font font() const {
+            return font_.texture.id != 0 ? font_ : GetFontDefault();
+        }
+
+        void measure_glyphs() const {
+            const Font font = this->font();
+            // DrawText's default font spacing, as raylib computes it
+            glyph_spacing_ = font_size_ / 10.0f;
+            for (int d = 0; d < 10; ++d) {
+                const char digit[2] = {static_cast<char>('0' + d), '\0'};
+                digit_advance_[d] = MeasureTextEx(font, digit, font_size_, 0.0f).x;
+            }
+            glyphs_measured_ = true;
+        }
+
+        void update_number_width() const {
+            if (!glyphs_measured_) {
+                measure_glyphs();
+            }
+            float widest = 0.0f;
+            for (float advance : digit_advance_) {
+                widest = advance > widest ? advance : widest;
+            }
+            number_width_ = static_cast<float>(digits_) * (widest + glyph_spacing_);
+            width_dirty_ = false;
+        }
+
+        /// Draws `number` right-aligned at `right`, one glyph quad per digit; every quad goes into
+        /// the same raylib batch since they share the font texture.
+        void draw_number(size_t number, float right, float y, const plastic::Color& color) const {
+            std::array<unsigned char, 20> digits{};
+            size_t count = 0;
+            float width = 0.0f;
+            do {
+                digits[count] = static_cast<unsigned char>(number % 10);
+                width += digit_advance_[digits[count]] + glyph_spacing_;
+                ++count;
+                number /= 10;
+            } while (number > 0);
+
+            const Font font = this->font();
+            float x = right - width;
+            while (count > 0) {
+                const unsigned char d = digits[--count];
+                DrawTextCodepoint(font, '0' + d, {x, y}, font_size_, color.rl());
+                x += digit_advance_[d] + glyph_spacing_;
+            }
+        }
 
     public:
         void set_line_count(size_t count) {
             if (line_count_ != count) {
                 line_count_ = count;
+                const size_t digits = count_digits(count);
+                if (digits != digits_) {
+                    digits_ = digits;
+                    width_dirty_ = true;
+                }
                 invalidate();
             }
         }
 
+        /// Visible range in rows, 1-based; rows equal lines unless a fold map is attached
         void set_visible_range(int start, int end) {
             if (visible_start_ != start || visible_end_ != end) {
                 visible_start_ = start;
@@ -50,6 +129,28 @@ export namespace editor {
             }
         }
 
+        /// Shows distances from the current line instead of absolute numbers, like vim's relativenumber
+        void set_relative(bool relative) {
+            if (relative_ != relative) {
+                relative_ = relative;
+                invalidate();
+            }
+        }
+
+        /// Numbers follow the buffer's folds: each visible row shows the line it maps to
+        void set_folds(const keditor::FoldMap* folds) {
+            folds_ = folds;
+            invalidate();
+        }
+
+        void set_font(const Font& font, float size) {
+            font_ = font;
+            font_size_ = size;
+            glyphs_measured_ = false;
+            width_dirty_ = true;
+            invalidate();
+        }
+
         void layout(plastic::Context* cx) override {
             // Simple layout just uses the provided bounds
         }
@@ -62,15 +163,27 @@ export namespace editor {
                 DrawRectangleRec({bounds.x(), bounds.y(), bounds.width(), bounds.height()}, bg_color->rl());
             }
 
+            if (!glyphs_measured_) {
+                measure_glyphs();
+            }
+
             // Draw line numbers
+            const float right = bounds.x() + bounds.width() - 10;
             float y = bounds.y();
-            for (int line = visible_start_; line <= visible_end_; ++line) {
-                plastic::Color color = (line == current_line_) ? current_line_color_ : line_color_;
+            for (int row = visible_start_; row <= visible_end_; ++row) {
+                if (folds_ && static_cast<size_t>(row) > folds_->row_count()) {
+                    break;
+                }
+                const int line = folds_ ? static_cast<int>(folds_->line_of(static_cast<size_t>(row - 1))) + 1 : row;
+                if (line < 1 || static_cast<size_t>(line) > line_count_) {
+                    break;
+                }
+                const bool is_current = line == current_line_;
+                const size_t number = relative_ && !is_current
+                    ? static_cast<size_t>(std::abs(line - current_line_))
+                    : static_cast<size_t>(line);
 
-                std::string line_number = std::to_string(line);
-                float x = bounds.x() + bounds.width() - 10 - static_cast<float>(MeasureText(line_number.c_str(), 12));
-
-                DrawText(line_number.c_str(), static_cast<int>(x), static_cast<int>(y), 12, color.rl());
+                draw_number(number, right, y, is_current ? current_line_color_ : line_color_);
 
                 y += line_height_;
                 if (y > bounds.y() + bounds.height()) break;
@@ -78,9 +191,10 @@ export namespace editor {
         }
 
         [[nodiscard]] plastic::Size<float> get_preferred_size() const override {
-            // Calculate width based on line count
-            int digits = static_cast<int>(std::log10(std::max<size_t>(line_count_, 1))) + 1;
-            float preferred_width = gutter_width_ + static_cast<float>(digits) * 8.0f;
+            if (width_dirty_) {
+                update_number_width();
+            }
+            float preferred_width = gutter_width_ + number_width_;
             return plastic::Size<float>{preferred_width, static_cast<float>(line_count_) * line_height_};
         }
 
@@ -89,4 +203,4 @@ export namespace editor {
             invalidate();
         }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,412 @@
+//
+// Minimap drawn from a cached texture of token colours.
+//
+
+module;
+#include <raylib.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+export module editor.minimap;
+import plastic.element;
+import plastic.color;
+import plastic.context;
+import plastic.events;
+import plastic.point;
+import plastic.rect;
+import plastic.render_state;
+import plastic.scrollable;
+import plastic.size;
+import editor.syntax_highlighter;
+
+export namespace editor
+{
+    /// @brief Overview of the whole document next to the text area.
+    ///
+    /// Every line is a thin row of colour runs in a RenderTexture, one pixel per column. The
+    /// texture is only redrawn for rows whose lines changed, as reported by the highlighter. Lines
+    /// inserted or removed scroll the rows below them within the texture, so only the edited rows
+    /// are drawn again. A frame then costs a single textured quad. Documents taller than the texture
+    /// fold several lines into each row; there an insertion redraws everything below it instead.
+    ///
+    /// @note Prototype: the app does not mount one. It needs a SyntaxHighlighter, which no text
+    /// view owns yet, and the legacy editor view only has it commented out.
+    class Minimap : public plastic::Element {
+    private:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// More line insertions or removals than this in one frame redraw everything below the first
+        static constexpr std::size_t max_shifts = 16;
+
+        /// @brief Line changes waiting to be drawn, in the order they happened; shared with the
+        /// highlighter listener, which runs on the highlighter's worker thread
+        struct Dirty : std::enable_shared_from_this<Dirty> {
+            std::mutex mutex;
+            std::vector<LineChange> changes;
+            bool all{false};
+            /// Set while mounted, so changes can ask the UI thread for a repaint
+            plastic::Context* context{nullptr};
+            std::weak_ptr<plastic::Element> owner{};
+            /// A repaint is already queued; later changes ride along with it
+            bool posted{false};
+
+            void mark(const LineChange& change) {
+                std::lock_guard lock(mutex);
+                if (!all) {
+                    changes.push_back(change);
+                }
+                // The worker recolours lines while the app idles, so waking the loop is on us
+                if (context && !posted) {
+                    posted = context->post([owner = owner, dirty = weak_from_this()] {
+                        if (const auto self = dirty.lock()) {
+                            std::lock_guard lock(self->mutex);
+                            self->posted = false;
+                        }
+                        if (const auto element = owner.lock()) {
+                            element->invalidate_paint();
+                        }
+                    });
+                }
+            }
+
+            void mark_all() {
+                std::lock_guard lock(mutex);
+                all = true;
+                changes.clear();
+            }
+        };
+
+        std::shared_ptr<SyntaxHighlighter> highlighter_{};
+        std::size_t listener_{0};
+        std::shared_ptr<Dirty> dirty_{std::make_shared<Dirty>()};
+        std::shared_ptr<plastic::Scrollable> scroll_{};
+
+        float line_height_{16.0f};  ///< Line height of the editor, to map its scroll offset to lines
+        int columns_{120};
+        int row_height_{2};
+        int max_rows_{2048};
+
+        plastic::Color background_{30, 30, 30};
+        plastic::Color text_color_{150, 150, 150};
+        plastic::Color viewport_color_{255, 255, 255, 40};
+
+        mutable RenderTexture2D texture_{};
+        mutable RenderTexture2D scratch_{};     ///< Copy of texture_ while its rows are scrolled
+        mutable bool has_texture_{false};
+        mutable std::vector<LineChange> changes_{};
+        mutable std::size_t lines_per_row_{1};
+        mutable std::size_t rows_{0};
+        bool dragging_{false};
+
+        [[nodiscard]] int texture_height() const {
+            return max_rows_ * row_height_;
+        }
+
+        /// @brief Moves `count` texture rows starting at `from` to start at `to`; rows left
+        /// uncovered at the bottom when moving up are cleared
+        void shift_rows(std::size_t from, std::size_t to, std::size_t count) const {
+            const auto max_rows = static_cast<std::size_t>(max_rows_);
+            if (to >= max_rows || count == 0) {
+                return;
+            }
+            count = std::min(count, max_rows - to);
+            const auto width = static_cast<float>(columns_);
+            const auto height = static_cast<float>(texture_height());
+            const auto row_height = static_cast<float>(row_height_);
+
+            // A texture cannot be drawn onto itself, so copy it aside first.
+            // Render textures are stored upside down, so source rects are flipped
+            plastic::begin_render_target(scratch_);
+            DrawTextureRec(texture_.texture, {0.0f, 0.0f, width, -height}, {0.0f, 0.0f}, WHITE);
+            plastic::end_render_target();
+
+            const float top = static_cast<float>(from) * row_height;
+            const float span = static_cast<float>(count) * row_height;
+            plastic::begin_render_target(texture_);
+            DrawTextureRec(scratch_.texture, {0.0f, height - top - span, width, -span},
+                           {0.0f, static_cast<float>(to) * row_height}, WHITE);
+            if (to < from) {
+                DrawRectangle(0, static_cast<int>(to + count) * row_height_, columns_,
+                              static_cast<int>(from - to) * row_height_, background_.rl());
+            }
+            plastic::end_render_target();
+        }
+
+        /// @brief Redraws the rows of lines that changed since the last frame
+        void refresh() const {
+            if (!highlighter_) {
+                return;
+            }
+            if (!has_texture_) {
+                texture_ = LoadRenderTexture(columns_, texture_height());
+                scratch_ = LoadRenderTexture(columns_, texture_height());
+                has_texture_ = true;
+                dirty_->mark_all();
+            }
+
+            bool all;
+            {
+                std::lock_guard lock(dirty_->mutex);
+                changes_.swap(dirty_->changes);
+                all = std::exchange(dirty_->all, false);
+            }
+
+            const std::size_t lines = highlighter_->line_count();
+            const auto max_rows = static_cast<std::size_t>(max_rows_);
+            const std::size_t per_row = std::max<std::size_t>(1, (lines + max_rows - 1) / max_rows);
+            const std::size_t rows = (lines + per_row - 1) / per_row;
+            if (per_row != lines_per_row_) {
+                lines_per_row_ = per_row;
+                all = true;
+            }
+
+            // Lines to redraw, [first, last) with last == npos for "to the end"
+            std::size_t first = all ? 0 : npos;
+            std::size_t last = all ? npos : 0;
+            std::size_t shown = rows_;      ///< Rows holding drawn lines as the changes are replayed
+            std::size_t extent = rows_;     ///< Rows that may hold stale pixels
+            const bool can_shift = per_row == 1 && changes_.size() <= max_shifts;
+            if (all) {
+                changes_.clear();
+            }
+            for (const auto& change : changes_) {
+                first = std::min(first, change.first);
+                const std::size_t old_end = change.first + change.removed;
+                const std::size_t new_end = change.first + change.added;
+                if (change.removed == change.added) {
+                    last = std::max(last, new_end);
+                    continue;
+                }
+                if (!can_shift) {
+                    last = npos;
+                    continue;
+                }
+
+                // Rows below the edit keep their pixels and move with their lines
+                shift_rows(old_end, new_end, shown > old_end ? shown - old_end : 0);
+                if (last != npos && last > old_end) {
+                    last = last - old_end + new_end;
+                }
+                last = std::max(last, new_end);
+                shown = std::min(max_rows, shown + change.added - std::min(shown, change.removed));
+                extent = std::max(extent, shown);
+            }
+            changes_.clear();
+            if (first == npos) {
+                rows_ = rows;
+                return;
+            }
+
+            // Rows past the new end are cleared when the document shrank
+            const std::size_t row_first = first / per_row;
+            const std::size_t row_end = last == npos
+                ? std::max(rows, extent)
+                : std::min(std::max(rows, extent), (last + per_row - 1) / per_row);
+            rows_ = rows;
+            if (row_first >= row_end) {
+                return;
+            }
+
+            const auto lexer = highlighter_->lexer();
+            plastic::begin_render_target(texture_);
+            DrawRectangle(0, static_cast<int>(row_first) * row_height_, columns_,
+                          static_cast<int>(row_end - row_first) * row_height_, background_.rl());
+            if (row_first < rows) {
+                highlighter_->for_each_line(row_first * per_row, std::min(lines, row_end * per_row) - 1,
+                    [&](std::size_t line, std::string_view text, const std::vector<Token>& tokens) {
+                        draw_line(static_cast<int>(line / per_row), text, tokens, lexer.get());
+                    });
+            }
+            plastic::end_render_target();
+        }
+
+        void draw_line(int row, std::string_view text, const std::vector<Token>& tokens, const Lexer* lexer) const {
+            const auto end = std::min(text.size(), static_cast<std::size_t>(columns_));
+            auto token = tokens.begin();
+            std::size_t run_start = 0;
+            plastic::Color run_color = text_color_;
+            bool in_run = false;
+
+            const auto flush = [&](std::size_t column) {
+                if (in_run) {
+                    DrawRectangle(static_cast<int>(run_start), row * row_height_,
+                                  static_cast<int>(column - run_start), row_height_, run_color.rl());
+                }
+                in_run = false;
+            };
+
+            for (std::size_t column = 0; column < end; ++column) {
+                if (text[column] == ' ' || text[column] == '\t') {
+                    flush(column);
+                    continue;
+                }
+                while (token != tokens.end() && token->start + token->length <= column) {
+                    ++token;
+                }
+                plastic::Color color = text_color_;
+                if (lexer && token != tokens.end() && token->start <= column && token->style < lexer->styles().size()) {
+                    color = lexer->styles()[token->style].color;
+                }
+                if (in_run && (color.r != run_color.r || color.g != run_color.g || color.b != run_color.b)) {
+                    flush(column);
+                }
+                if (!in_run) {
+                    run_start = column;
+                    run_color = color;
+                    in_run = true;
+                }
+            }
+            flush(end);
+        }
+
+        /// @brief Pixel offset of the first texture row shown, when the map is taller than the element
+        [[nodiscard]] float map_offset() const {
+            const float map_height = static_cast<float>(rows_ * static_cast<std::size_t>(row_height_));
+            if (!scroll_ || map_height <= bounds.height()) {
+                return 0.0f;
+            }
+            const float view_height = scroll_->get_bounds().height();
+            const float range = scroll_->content_height() - view_height;
+            const float progress = range > 0.0f ? std::clamp(scroll_->scroll_y() / range, 0.0f, 1.0f) : 0.0f;
+            return (map_height - bounds.height()) * progress;
+        }
+
+        void scroll_to(float y) {
+            if (!scroll_) {
+                return;
+            }
+            const float row = (y - bounds.y() + map_offset()) / static_cast<float>(row_height_);
+            const float line = row * static_cast<float>(lines_per_row_);
+            const float view_height = scroll_->get_bounds().height();
+            scroll_->set_scroll_position(scroll_->scroll_x(), line * line_height_ - view_height / 2.0f);
+            invalidate();
+        }
+
+    public:
+        Minimap() = default;
+
+        Minimap(const Minimap&) = delete;
+        Minimap& operator=(const Minimap&) = delete;
+
+        ~Minimap() override {
+            if (highlighter_) {
+                highlighter_->remove_listener(listener_);
+            }
+            if (has_texture_) {
+                UnloadRenderTexture(texture_);
+                UnloadRenderTexture(scratch_);
+            }
+        }
+
+        void mount(plastic::Context* cx) override {
+            Element::mount(cx);
+            std::lock_guard lock(dirty_->mutex);
+            dirty_->context = cx;
+            dirty_->owner = weak_from_this();
+        }
+
+        void unmount(plastic::Context* cx) override {
+            {
+                std::lock_guard lock(dirty_->mutex);
+                dirty_->context = nullptr;
+            }
+            Element::unmount(cx);
+        }
+
+        void set_highlighter(std::shared_ptr<SyntaxHighlighter> highlighter) {
+            if (highlighter_) {
+                highlighter_->remove_listener(listener_);
+            }
+            highlighter_ = std::move(highlighter);
+            if (highlighter_) {
+                listener_ = highlighter_->add_listener([dirty = dirty_](const LineChange& change) {
+                    dirty->mark(change);
+                });
+            }
+            dirty_->mark_all();
+            invalidate();
+        }
+
+        /// @brief Follows and drives the scroll offset of the text area
+        /// @param line_height Height of one editor line, to convert the scroll offset to lines
+        void set_scroll_source(std::shared_ptr<plastic::Scrollable> scroll, float line_height) {
+            scroll_ = std::move(scroll);
+            line_height_ = line_height;
+            invalidate();
+        }
+
+        void set_colors(const plastic::Color& background, const plastic::Color& text, const plastic::Color& viewport) {
+            background_ = background;
+            text_color_ = text;
+            viewport_color_ = viewport;
+            dirty_->mark_all();
+            invalidate();
+        }
+
+        void layout(plastic::Context* cx) override {
+        }
+
+        void paint(plastic::Context* cx) const override {
+            DrawRectangleRec(bounds.to_rl(), background_.rl());
+            refresh();
+            if (!has_texture_ || rows_ == 0) {
+                return;
+            }
+
+            // Render textures are stored upside down, so the source rect is flipped
+            const float offset = map_offset();
+            const float map_height = static_cast<float>(rows_ * static_cast<std::size_t>(row_height_));
+            const float shown = std::min(map_height - offset, bounds.height());
+            const float scale = bounds.width() / static_cast<float>(columns_);
+            const Rectangle source{
+                0.0f, static_cast<float>(texture_height()) - offset - shown,
+                static_cast<float>(columns_), -shown
+            };
+            const Rectangle dest{bounds.x(), bounds.y(), static_cast<float>(columns_) * scale, shown};
+            DrawTexturePro(texture_.texture, source, dest, {0.0f, 0.0f}, 0.0f, WHITE);
+
+            if (scroll_) {
+                const float lines_per_pixel = static_cast<float>(lines_per_row_) / static_cast<float>(row_height_);
+                const float top = scroll_->scroll_y() / line_height_ / lines_per_pixel - offset;
+                const float height = scroll_->get_bounds().height() / line_height_ / lines_per_pixel;
+                DrawRectangleRec({bounds.x(), bounds.y() + top, bounds.width(), height}, viewport_color_.rl());
+            }
+        }
+
+        bool process_event(const plastic::events::Event& event, plastic::Context* cx) override {
+            if (const auto* button = std::get_if<plastic::events::MouseButtonEvent>(&event)) {
+                const plastic::Point<float> point{button->position.width(), button->position.height()};
+                if (button->button != MOUSE_BUTTON_LEFT) {
+                    return false;
+                }
+                if (!button->pressed) {
+                    const bool was_dragging = dragging_;
+                    dragging_ = false;
+                    return was_dragging;
+                }
+                if (!bounds.contains(point)) {
+                    return false;
+                }
+                dragging_ = true;
+                scroll_to(point.y);
+                return true;
+            }
+            if (const auto* move = std::get_if<plastic::events::MouseMoveEvent>(&event)) {
+                if (dragging_) {
+                    scroll_to(move->position.y);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] plastic::Size<float> get_preferred_size() const override {
+            return {static_cast<float>(columns_), bounds.height()};
+        }
+    };
+}
@@ -4,15 +4,55 @@
 
 
 module;
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <regex>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 export module editor.syntax_highlighter;
 import plastic.color;
-import plastic;
-import plastic.plugin;
 import plastic.rich_text;
+import editor.bracket_index;
 export namespace editor
 {
+    /// @brief Lexer state carried from the end of one line to the start of the next.
+    /// 0 is the initial state; anything else is lexer specific (inside a block comment, a raw string, ...).
+    using LineState = std::uint32_t;
+
+    /// @brief A run of characters within a single line that shares one style.
+    struct Token {
+        std::uint32_t start{0};
+        std::uint32_t length{0};
+        std::uint16_t style{0}; ///< Index into Lexer::styles()
+    };
+
+    struct TokenStyle {
+        plastic::Color color{plastic::Color::white()};
+        bool bold{false};
+        bool italic{false};
+        bool literal{false}; ///< Strings and comments: brackets inside do not count for matching
+    };
+
+    /// @brief Turns one line into tokens, given the state the previous line ended in.
+    /// Implementations must be safe to call from the highlighter's worker thread.
+    struct Lexer {
+        virtual ~Lexer() = default;
+
+        /// @return The state at the end of `line`
+        virtual LineState tokenize(std::string_view line, LineState state, std::vector<Token>& out) const = 0;
+
+        [[nodiscard]] virtual const std::vector<TokenStyle>& styles() const = 0;
+    };
+
     struct SyntaxRule {
         std::regex pattern;
         plastic::Color color;
@@ -20,23 +60,492 @@ export namespace editor
         bool italic{false};
     };
 
+    /// @brief Adapts a list of single-line regex rules to the Lexer interface.
+    /// Earlier rules win where matches overlap. Regex rules cannot carry state across lines.
+    class RegexLexer : public Lexer {
+    private:
+        std::vector<SyntaxRule> rules_;
+        std::vector<TokenStyle> styles_;
+
+    public:
+        explicit RegexLexer(std::vector<SyntaxRule> rules) : rules_(std::move(rules)) {
+            for (const auto& rule : rules_) {
+                styles_.push_back({rule.color, rule.bold, rule.italic});
+            }
+        }
+
+        LineState tokenize(std::string_view line, LineState state, std::vector<Token>& out) const override {
+            std::vector<bool> taken(line.size(), false);
+            const auto first = out.size();
+
+            for (std::uint16_t i = 0; i < rules_.size(); ++i) {
+                for (std::cregex_iterator it(line.data(), line.data() + line.size(), rules_[i].pattern), end; it != end; ++it) {
+                    auto start = static_cast<std::size_t>(it->position());
+                    auto length = static_cast<std::size_t>(it->length());
+                    if (length == 0 || std::any_of(taken.begin() + start, taken.begin() + start + length, [](bool b) { return b; })) {
+                        continue;
+                    }
+                    std::fill(taken.begin() + start, taken.begin() + start + length, true);
+                    out.push_back({static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(length), i});
+                }
+            }
+
+            std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+                [](const Token& a, const Token& b) { return a.start < b.start; });
+            return state;
+        }
+
+        [[nodiscard]] const std::vector<TokenStyle>& styles() const override {
+            return styles_;
+        }
+    };
+
+    /// @brief Lines whose tokens changed: `removed` old lines at `first` are now `added` lines.
+    /// Re-tokenizing in place reports removed == added.
+    struct LineChange {
+        std::size_t first{0};
+        std::size_t removed{0};
+        std::size_t added{0};
+    };
+
+    /// @brief Incremental highlighter that remembers the lexer state at the end of every line.
+    ///
+    /// Edits only invalidate the lines they touch. A worker thread re-tokenizes from the first
+    /// stale line until a line's incoming state matches the state it was last tokenized with, at
+    /// which point everything below is known to be unchanged. The worker copies small batches of
+    /// line text under the lock and tokenizes them outside it; a batch is dropped if an edit landed
+    /// in the meantime. Lines in the viewport can be highlighted synchronously with highlight_range().
+    ///
+    /// @note Prototype: nothing feeds it edits or draws its tokens yet. Neither keditor::text::Buffer
+    /// nor the kupui::TextArea the app runs owns a highlighter, so text is still drawn in one colour.
     class SyntaxHighlighter {
     private:
+        struct LineEntry {
+            std::string text;
+            std::vector<Token> tokens;
+            LineState start_state{0};
+            LineState end_state{0};
+            bool valid{false};
+        };
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+        static constexpr std::size_t batch_lines_ = 256;
+
         std::vector<SyntaxRule> rules;
         std::string language_id;
 
+        std::shared_ptr<const Lexer> lexer_{};
+        std::vector<LineEntry> lines_{};
+        std::size_t first_dirty_{npos};   ///< Lowest line that may hold stale tokens
+        std::size_t invalid_count_{0};    ///< Lines that were never tokenized since their last edit
+        std::uint64_t version_{0};        ///< Bumped on every structural change; stale batches are dropped
+        BracketIndex brackets_{};
+        std::vector<std::pair<std::size_t, std::function<void(const LineChange&)>>> listeners_{};
+        std::size_t next_listener_{0};
+
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        std::atomic<bool> has_updates_{false};
+        bool stop_{false};
+        std::thread worker_;
+
+        void mark_dirty(std::size_t line) {
+            first_dirty_ = std::min(first_dirty_, line);
+            if (first_dirty_ >= lines_.size()) {
+                // Nothing left to tokenize (empty document, or an edit at the very end)
+                first_dirty_ = npos;
+            }
+            ++version_;
+            wake_.notify_one();
+        }
+
+        [[nodiscard]] LineState state_before(std::size_t line) const {
+            return line == 0 ? LineState{0} : lines_[line - 1].end_state;
+        }
+
+        /// Copies into the line's existing token storage, so re-tokenizing a line reuses its capacity
+        void store(std::size_t line, std::span<const Token> tokens, LineState start, LineState end) {
+            auto& entry = lines_[line];
+            if (!entry.valid) {
+                --invalid_count_;
+            }
+            entry.tokens.assign(tokens.begin(), tokens.end());
+            entry.start_state = start;
+            entry.end_state = end;
+            entry.valid = true;
+            brackets_.set_line(line, scan_brackets(entry));
+        }
+
+        /// @brief Brackets of a line outside string and comment tokens
+        [[nodiscard]] std::vector<Bracket> scan_brackets(const LineEntry& entry) const {
+            if (!lexer_ || !entry.valid) {
+                return BracketIndex::scan(entry.text);
+            }
+            const auto& styles = lexer_->styles();
+            auto token = entry.tokens.begin();
+            return BracketIndex::scan(entry.text, [&](std::size_t column) {
+                while (token != entry.tokens.end() && token->start + token->length <= column) {
+                    ++token;
+                }
+                return token == entry.tokens.end() || token->start > column || !styles[token->style].literal;
+            });
+        }
+
+        void notify(std::size_t first, std::size_t removed, std::size_t added) const {
+            for (const auto& [id, listener] : listeners_) {
+                listener({first, removed, added});
+            }
+        }
+
+        /// @brief Where the worker should continue once it caught up at `line`.
+        [[nodiscard]] std::size_t next_dirty_after(std::size_t line) const {
+            if (invalid_count_ == 0) {
+                return npos;
+            }
+            for (; line < lines_.size(); ++line) {
+                if (!lines_[line].valid) {
+                    return line;
+                }
+            }
+            return npos;
+        }
+
+        void run() {
+            struct Result {
+                std::size_t offset;
+                std::size_t count;
+                LineState start;
+                LineState end;
+            };
+            std::vector<Token> arena;
+            std::vector<Result> results;
+
+            std::unique_lock lock(mutex_);
+            while (true) {
+                wake_.wait(lock, [this] { return stop_ || (lexer_ && first_dirty_ < lines_.size()); });
+                if (stop_) {
+                    return;
+                }
+
+                // Snapshot a batch of lines, then tokenize without holding the lock
+                const auto version = version_;
+                const auto lexer = lexer_;
+                const std::size_t first = first_dirty_;
+                const std::size_t last = std::min(lines_.size(), first + batch_lines_);
+                LineState state = state_before(first);
+                std::vector<std::string> batch;
+                batch.reserve(last - first);
+                for (std::size_t i = first; i < last; ++i) {
+                    batch.push_back(lines_[i].text);
+                }
+                lock.unlock();
+
+                // Tokens for the whole batch go into one arena that is reused across batches
+                arena.clear();
+                results.clear();
+                for (const auto& text : batch) {
+                    Result result{arena.size(), 0, state, 0};
+                    result.end = lexer->tokenize(text, state, arena);
+                    result.count = arena.size() - result.offset;
+                    state = result.end;
+                    results.push_back(result);
+                }
+
+                lock.lock();
+                if (version != version_ || lexer != lexer_) {
+                    continue;
+                }
+
+                std::size_t line = first;
+                bool converged = false;
+                for (auto& result : results) {
+                    auto& entry = lines_[line];
+                    if (line > first && entry.valid && entry.start_state == result.start) {
+                        converged = true;
+                        break;
+                    }
+                    store(line, std::span<const Token>(arena).subspan(result.offset, result.count),
+                          result.start, result.end);
+                    ++line;
+                }
+                // A valid line right after the batch may already agree with the new state
+                if (!converged && line < lines_.size() && lines_[line].valid && lines_[line].start_state == state) {
+                    converged = true;
+                }
+
+                first_dirty_ = converged ? next_dirty_after(line) : line;
+                if (first_dirty_ >= lines_.size()) {
+                    first_dirty_ = npos;
+                }
+                notify(first, line - first, line - first);
+                has_updates_ = true;
+            }
+        }
+
+        void rebuild_regex_lexer() {
+            set_lexer(std::make_shared<RegexLexer>(rules));
+        }
+
     public:
-        explicit SyntaxHighlighter(std::string language) : language_id(std::move(language)) {}
+        explicit SyntaxHighlighter(std::string language) : language_id(std::move(language)) {
+            worker_ = std::thread([this] { run(); });
+        }
+
+        SyntaxHighlighter(const SyntaxHighlighter&) = delete;
+        SyntaxHighlighter& operator=(const SyntaxHighlighter&) = delete;
+
+        ~SyntaxHighlighter() {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            if (worker_.joinable()) {
+                worker_.join();
+            }
+        }
+
+        [[nodiscard]] const std::string& language() const {
+            return language_id;
+        }
 
         void add_rule(const std::regex& pattern, const plastic::Color& color, bool bold = false, bool italic = false) {
             rules.push_back({pattern, color, bold, italic});
+            rebuild_regex_lexer();
+        }
+
+        /// @brief Switches grammars; every line is re-tokenized.
+        void set_lexer(std::shared_ptr<const Lexer> lexer) {
+            std::lock_guard lock(mutex_);
+            lexer_ = std::move(lexer);
+            for (auto& entry : lines_) {
+                entry.valid = false;
+            }
+            invalid_count_ = lines_.size();
+            mark_dirty(0);
+        }
+
+        [[nodiscard]] std::shared_ptr<const Lexer> lexer() const {
+            std::lock_guard lock(mutex_);
+            return lexer_;
+        }
+
+        /// @brief Replaces the whole document.
+        void reset(std::vector<std::string> lines) {
+            std::lock_guard lock(mutex_);
+            const auto old_count = lines_.size();
+            lines_.clear();
+            lines_.resize(lines.size());
+            for (std::size_t i = 0; i < lines.size(); ++i) {
+                lines_[i].text = std::move(lines[i]);
+            }
+            std::vector<std::vector<Bracket>> brackets;
+            brackets.reserve(lines_.size());
+            for (const auto& entry : lines_) {
+                brackets.push_back(scan_brackets(entry));
+            }
+            brackets_.assign(std::move(brackets));
+            invalid_count_ = lines_.size();
+            first_dirty_ = npos;
+            mark_dirty(0);
+            notify(0, old_count, lines_.size());
+        }
+
+        /// @brief Replaces `removed` lines starting at `first` with `added`.
+        /// Lines outside the edit keep their tokens until the worker proves they changed.
+        void edit(std::size_t first, std::size_t removed, std::vector<std::string> added) {
+            std::lock_guard lock(mutex_);
+            first = std::min(first, lines_.size());
+            removed = std::min(removed, lines_.size() - first);
+
+            auto begin = lines_.begin() + static_cast<std::ptrdiff_t>(first);
+            auto end = begin + static_cast<std::ptrdiff_t>(removed);
+            invalid_count_ -= static_cast<std::size_t>(std::count_if(begin, end, [](const LineEntry& e) { return !e.valid; }));
+            auto at = lines_.erase(begin, end);
+
+            std::vector<LineEntry> entries(added.size());
+            for (std::size_t i = 0; i < added.size(); ++i) {
+                entries[i].text = std::move(added[i]);
+            }
+            std::vector<std::vector<Bracket>> brackets;
+            brackets.reserve(entries.size());
+            for (const auto& entry : entries) {
+                brackets.push_back(scan_brackets(entry));
+            }
+            brackets_.splice(first, removed, std::move(brackets));
+            lines_.insert(at, std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+            invalid_count_ += entries.size();
+
+            if (first_dirty_ != npos && first_dirty_ > first) {
+                // Lines the worker had not reached yet moved along with the edit
+                first_dirty_ = first_dirty_ + added.size() >= removed ? first_dirty_ + added.size() - removed : first;
+            }
+            mark_dirty(first);
+            notify(first, removed, entries.size());
+        }
+
+        /// @brief Tokenizes any stale line in [first, last] right away, for the lines on screen.
+        /// If the line above is stale too, its last known end state is used as a best guess; the
+        /// worker corrects the line once it gets there.
+        void highlight_range(std::size_t first, std::size_t last) {
+            std::lock_guard lock(mutex_);
+            if (!lexer_) {
+                return;
+            }
+            last = std::min(last, lines_.empty() ? 0 : lines_.size() - 1);
+            bool end_changed = false;
+            std::size_t changed_first = npos;
+            std::size_t changed_last = 0;
+            for (std::size_t line = first; line <= last && line < lines_.size(); ++line) {
+                auto& entry = lines_[line];
+                const LineState state = state_before(line);
+                if (entry.valid && entry.start_state == state) {
+                    end_changed = false;
+                    continue;
+                }
+                std::vector<Token> tokens;
+                const LineState end = lexer_->tokenize(entry.text, state, tokens);
+                end_changed = !entry.valid || entry.end_state != end;
+                store(line, tokens, state, end);
+                changed_first = std::min(changed_first, line);
+                changed_last = line;
+            }
+            if (changed_first != npos) {
+                notify(changed_first, changed_last - changed_first + 1, changed_last - changed_first + 1);
+            }
+
+            // The line below the range now starts in a different state; hand it to the worker
+            const std::size_t next = last + 1;
+            if (end_changed && next < lines_.size() && lines_[next].valid) {
+                lines_[next].valid = false;
+                ++invalid_count_;
+                mark_dirty(next);
+            }
         }
 
+        /// @brief Calls `fn(line, text, tokens)` for every line in [first, last] while holding the lock once.
+        template<typename Fn>
+        void for_each_line(std::size_t first, std::size_t last, Fn&& fn) const {
+            std::lock_guard lock(mutex_);
+            for (std::size_t line = first; line <= last && line < lines_.size(); ++line) {
+                fn(line, std::string_view(lines_[line].text), static_cast<const std::vector<Token>&>(lines_[line].tokens));
+            }
+        }
+
+        /// @return Number of lines in the document
+        [[nodiscard]] std::size_t line_count() const {
+            std::lock_guard lock(mutex_);
+            return lines_.size();
+        }
+
+        /// @brief Registers `listener` to hear about every change to the tokens of any line.
+        /// It runs on whichever thread made the change, with the highlighter locked, so it must
+        /// be cheap and must not call back into the highlighter.
+        /// @return Id to pass to remove_listener()
+        std::size_t add_listener(std::function<void(const LineChange&)> listener) {
+            std::lock_guard lock(mutex_);
+            listeners_.emplace_back(next_listener_, std::move(listener));
+            return next_listener_++;
+        }
+
+        void remove_listener(std::size_t id) {
+            std::lock_guard lock(mutex_);
+            std::erase_if(listeners_, [id](const auto& entry) { return entry.first == id; });
+        }
+
+        /// @return The bracket paired with the one at (line, column).
+        /// Brackets inside strings and comments are skipped once their line has been tokenized.
+        [[nodiscard]] std::optional<BracketLocation> match_bracket(std::size_t line, std::size_t column) const {
+            std::lock_guard lock(mutex_);
+            return brackets_.match(line, column);
+        }
+
+        /// @return The opening bracket of the innermost pair around (line, column)
+        [[nodiscard]] std::optional<BracketLocation> enclosing_bracket(std::size_t line, std::size_t column) const {
+            std::lock_guard lock(mutex_);
+            return brackets_.enclosing(line, column);
+        }
+
+        /// @return The last line to hide when folding at `line` by brackets: the line above the
+        /// partner of the first bracket on `line` that closes further down
+        [[nodiscard]] std::optional<std::size_t> fold_end(std::size_t line) const {
+            std::lock_guard lock(mutex_);
+            std::optional<std::size_t> end;
+            brackets_.for_each(line, line, [&](const BracketLocation& bracket) {
+                if (end || !Bracket{0, bracket.ch}.is_open()) {
+                    return;
+                }
+                const auto partner = brackets_.match(line, bracket.column);
+                if (partner && partner->line > line + 1) {
+                    end = partner->line - 1;
+                }
+            });
+            return end;
+        }
+
+        /// @brief Calls `fn(BracketLocation)` for the brackets on lines [first, last], for depth colouring.
+        template<typename Fn>
+        void for_each_bracket(std::size_t first, std::size_t last, Fn&& fn) const {
+            std::lock_guard lock(mutex_);
+            brackets_.for_each(first, last, std::forward<Fn>(fn));
+        }
+
+        /// @return The lexer state at the end of `line`, if it has been tokenized
+        [[nodiscard]] LineState end_state(std::size_t line) const {
+            std::lock_guard lock(mutex_);
+            return line < lines_.size() ? lines_[line].end_state : LineState{0};
+        }
+
+        /// @return True once after the worker published new tokens; poll from the UI thread to repaint.
+        [[nodiscard]] bool consume_updates() {
+            return has_updates_.exchange(false);
+        }
+
+        /// @return True while some lines are still waiting on the worker
+        [[nodiscard]] bool is_busy() const {
+            std::lock_guard lock(mutex_);
+            return first_dirty_ != npos;
+        }
+
+        /// @brief Highlights a standalone text synchronously, without touching the document state.
         [[nodiscard]] std::vector<plastic::RichText::TextSpan> highlight(const std::string& text) const {
             std::vector<plastic::RichText::TextSpan> spans;
-            // Implement the highlighting logic using regex matching
-            // This is a simplified version - a real implementation would need to handle overlapping matches
+            const auto lexer = this->lexer();
+            if (!lexer) {
+                spans.push_back({text, plastic::Color::white()});
+                return spans;
+            }
+
+            const auto& styles = lexer->styles();
+            LineState state = 0;
+            std::vector<Token> tokens;
+            std::size_t pos = 0;
+            while (pos <= text.size()) {
+                std::size_t end = text.find('\n', pos);
+                if (end == std::string::npos) {
+                    end = text.size();
+                }
+                std::string_view line(text.data() + pos, end - pos);
 
+                tokens.clear();
+                state = lexer->tokenize(line, state, tokens);
+                std::size_t column = 0;
+                for (const auto& token : tokens) {
+                    if (token.start > column) {
+                        spans.push_back({std::string(line.substr(column, token.start - column)), plastic::Color::white()});
+                    }
+                    const auto& style = styles[token.style];
+                    spans.push_back({std::string(line.substr(token.start, token.length)), style.color, style.bold, style.italic});
+                    column = token.start + token.length;
+                }
+                if (column < line.size()) {
+                    spans.push_back({std::string(line.substr(column)), plastic::Color::white()});
+                }
+                if (end < text.size()) {
+                    spans.push_back({"\n", plastic::Color::white()});
+                }
+                pos = end + 1;
+            }
             return spans;
         }
     };
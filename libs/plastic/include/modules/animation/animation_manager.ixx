@@ -21,7 +21,7 @@ export namespace plastic
     class AnimationManager {
     private:
         std::unordered_map<std::string, std::unique_ptr<AnimationBase>> animations_;
-        std::mutex animations_mutex_;
+        mutable std::mutex animations_mutex_;
 
     public:
         template<typename T>
@@ -39,11 +39,6 @@ export namespace plastic
                 start, end, duration, std::move(update), std::move(easing)
             );
 
-            animation->set_on_complete([this, id] {
-                std::lock_guard<std::mutex> guard(animations_mutex_);
-                animations_.erase(id);
-            });
-
             animations_[id] = std::move(animation);
             animations_[id]->start();
         }
@@ -54,6 +49,16 @@ export namespace plastic
             for (auto& [_, animation] : animations_) {
                 animation->update(delta_time);
             }
+            // Swept here rather than from on_complete, which runs under this lock mid-iteration
+            std::erase_if(animations_, [](const auto& entry) {
+                return !entry.second->is_running();
+            });
+        }
+
+        /// @brief Whether any animation is running, i.e. frames must keep coming until it ends
+        [[nodiscard]] bool has_animations() const {
+            std::lock_guard<std::mutex> guard(animations_mutex_);
+            return !animations_.empty();
         }
 
         void add_animation(const std::string& id, std::unique_ptr<AnimationBase> animation) {
@@ -43,6 +43,24 @@ export namespace plastic
         bool initialized_ = false;
         std::shared_ptr<EventBus> event_bus_;
         Theme theme_;
+        bool idle_mode_{true};
+        double max_idle_wait_{0.5};
+        /// Longest wait between frames while an animation runs
+        double animation_frame_interval_{1.0 / 60.0};
+
+        /// Nothing to draw or run: the loop may block until input or a wake-up.
+        /// Running animations and caret blinks do not keep the loop spinning; they set a
+        /// wake_after() deadline, and the frame they damage is what ends the idle state.
+        [[nodiscard]] bool is_idle() {
+            if (auto animations = app_context_->get_animation_manager(); animations && animations->has_animations()) {
+                platform_->wake_after(animation_frame_interval_);
+            }
+            bool idle = true;
+            window_manager_->for_each_window([&idle](const WindowBase& window) {
+                idle = idle && !window.needs_frame();
+            });
+            return idle;
+        }
 
 
     public:
@@ -257,6 +275,14 @@ export namespace plastic
         std::function<void(const events::KeyPressEvent&)> on_key_press_;
 
     public:
+        /// @brief Whether the loop sleeps while nothing changes (the default) instead of drawing every frame
+        /// @param max_wait Longest single sleep in seconds, a safety net for changes nobody reported
+        App& with_idle_mode(bool enabled, double max_wait = 0.5) {
+            idle_mode_ = enabled;
+            max_idle_wait_ = max_wait;
+            return *this;
+        }
+
         void set_on_window_close(std::function<void(const events::WindowCloseEvent&)> handler) {
             on_window_close_ = std::move(handler);
         }
@@ -296,6 +322,7 @@ export namespace plastic
             while (window_manager_->has_windows()) {
                 // Process platform events
                 platform_->update();
+                const bool ran_posted = platform_->run_posted();
 
                 // Update all windows
                 window_manager_->for_each_window([this](WindowBase& window) {
@@ -309,6 +336,11 @@ export namespace plastic
                         window_manager_->remove_window(id);
                     }
                 }
+
+                // Block instead of spinning; input, post() and wake_after() deadlines end the wait
+                if (idle_mode_ && !ran_posted && window_manager_->has_windows() && is_idle()) {
+                    platform_->wait_events(platform_->idle_timeout(max_idle_wait_));
+                }
             }
 
             // Shutdown when all windows are closed
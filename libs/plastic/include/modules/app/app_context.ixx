@@ -4,6 +4,7 @@
 module;
 
 
+#include <functional>
 #include <memory>
 #include <vector>
 export module plastic.app_context;
@@ -58,6 +59,20 @@ export namespace plastic::context
             layout_requested_ = true;
         }
 
+        bool post(std::function<void()> task) override {
+            if (auto platform = platform_.lock()) {
+                platform->post(std::move(task));
+                return true;
+            }
+            return false;
+        }
+
+        void wake_after(double seconds) override {
+            if (auto platform = platform_.lock()) {
+                platform->wake_after(seconds);
+            }
+        }
+
         bool process_layout() {
             if (layout_requested_) {
                 layout_requested_ = false;
@@ -5,8 +5,11 @@
 /// @brief context interface
 
 module;
+#include <functional>
 export module plastic.context;
 import plastic.events;
+import plastic.render_batch;
+import plastic.rect;
 
 
 export namespace plastic
@@ -25,8 +28,25 @@ export namespace plastic
         /// @brief Request a paint update.
         virtual void request_paint() = 0;
 
+        /// @brief Request a repaint of `region` only, in window coordinates.
+        /// @note Contexts that do not track damage repaint everything
+        virtual void add_damage(const Rect<float>& region) { request_paint(); }
+
         /// @brief act as a dispatcher for events
         /// @param event The event to be dispatched (might change self)
         virtual void dispatch_event(const events::Event& event) = 0;
+
+        /// @brief Runs `task` on the UI thread before the next frame and wakes an idle loop;
+        /// safe to call from any thread
+        /// @return False when no loop is attached, in which case `task` was dropped
+        virtual bool post(std::function<void()> task) { return false; }
+
+        /// @brief Makes an idle loop run a frame within `seconds`, e.g. for the next caret blink
+        /// @note Only the wait is shortened; the element still adds its own damage on that frame
+        virtual void wake_after(double seconds) {}
+
+        /// @brief Frame draw list to record into instead of drawing immediately
+        /// @return The batch, or nullptr when elements should draw directly
+        virtual RenderBatch* batch() { return nullptr; }
     };
 }
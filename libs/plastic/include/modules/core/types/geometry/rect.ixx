@@ -14,6 +14,7 @@ export module plastic.rect;
 import plastic.point;
 import plastic.size;
 import plastic.color;
+import plastic.render_state;
 
 export namespace plastic
 {
@@ -203,20 +204,15 @@ export namespace plastic
             DrawRectangleRec(to_rl(), color.rl());
         }
 
-        // MAYBE REMOVE THESE FUNCTIONS
-        /// @brief constrains the area that can be rendered on to be this rectangle until 'stop_scissor' is called by anything
+        /// @brief constrains the area that can be rendered on to this rectangle, within any enclosing scissor, until 'stop_scissor'
         void apply_scissor() const {
-            BeginScissorMode(
-                static_cast<int>(x_),
-                static_cast<int>(y_),
-                static_cast<int>(width_),
-                static_cast<int>(height_));
+            push_scissor(to_rl());
         }
 
-        /// @brief stops the scissor mode
+        /// @brief restores the scissor that was active before the matching 'apply_scissor'
         /// @note This function should be called after 'apply_scissor' to stop the scissor mode
         static void stop_scissor() {
-            EndScissorMode();
+            pop_scissor();
         }
 
         /// @brief the rightmost x coordinate of the rectangle, assuming the rectangle is not rotated
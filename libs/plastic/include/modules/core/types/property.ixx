@@ -0,0 +1,218 @@
+//
+// Interned, typed element properties and state flags.
+//
+/// @file property.ixx
+/// @brief property keys, typed slots and element state bits
+
+module;
+#include <algorithm>
+#include <any>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+export module plastic.property;
+
+import plastic.color;
+
+export namespace plastic
+{
+    /// @brief Boolean element states, stored as bits on the element
+    enum class ElementState : std::uint32_t {
+        None      = 0,
+        Focused   = 1u << 0,
+        Focusable = 1u << 1,
+        Hovered   = 1u << 2,
+        Pressed   = 1u << 3,
+        Disabled  = 1u << 4,
+        Selected  = 1u << 5,
+    };
+
+    constexpr ElementState operator|(ElementState a, ElementState b) {
+        return static_cast<ElementState>(static_cast<std::uint32_t>(a) | static_cast<std::uint32_t>(b));
+    }
+
+    constexpr ElementState operator&(ElementState a, ElementState b) {
+        return static_cast<ElementState>(static_cast<std::uint32_t>(a) & static_cast<std::uint32_t>(b));
+    }
+
+    constexpr ElementState operator~(ElementState a) {
+        return static_cast<ElementState>(~static_cast<std::uint32_t>(a));
+    }
+
+    /// @brief The state bit a legacy property name refers to, if any
+    constexpr ElementState state_named(std::string_view name) {
+        if (name == "focused") return ElementState::Focused;
+        if (name == "focusable") return ElementState::Focusable;
+        if (name == "hovered") return ElementState::Hovered;
+        if (name == "pressed") return ElementState::Pressed;
+        if (name == "disabled") return ElementState::Disabled;
+        if (name == "selected") return ElementState::Selected;
+        return ElementState::None;
+    }
+
+    /// @brief A property name interned to a small integer; equal names give equal keys.
+    /// Intern once (typically as a static) and reuse it; lookups then compare integers.
+    class PropertyKey {
+        std::uint32_t id_;
+
+        struct Table {
+            std::mutex mutex;
+            std::deque<std::string> names;      ///< Stable addresses for the views handed out
+            std::unordered_map<std::string_view, std::uint32_t> ids;
+        };
+
+        static Table& table() {
+            static Table t;
+            return t;
+        }
+
+        explicit PropertyKey(std::uint32_t id) : id_(id) {}
+
+    public:
+        static PropertyKey intern(std::string_view name) {
+            Table& t = table();
+            std::lock_guard lock(t.mutex);
+            if (auto it = t.ids.find(name); it != t.ids.end()) {
+                return PropertyKey{it->second};
+            }
+            const auto id = static_cast<std::uint32_t>(t.names.size());
+            t.ids.emplace(t.names.emplace_back(name), id);
+            return PropertyKey{id};
+        }
+
+        /// @brief The key of a name that was already interned, without adding it to the table.
+        /// Reads use this, so looking up names that were never set does not grow the table.
+        static std::optional<PropertyKey> find(std::string_view name) {
+            Table& t = table();
+            std::lock_guard lock(t.mutex);
+            if (auto it = t.ids.find(name); it != t.ids.end()) {
+                return PropertyKey{it->second};
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] std::uint32_t id() const { return id_; }
+
+        [[nodiscard]] std::string_view name() const {
+            Table& t = table();
+            std::lock_guard lock(t.mutex);
+            return t.names[id_];
+        }
+
+        bool operator==(const PropertyKey&) const = default;
+    };
+
+    /// @brief A property key bound to its value type
+    /// @code
+    /// static const Property<float> opacity{"opacity"};
+    /// element->set(opacity, 0.5f);
+    /// float o = element->get_or(opacity, 1.0f);
+    /// @endcode
+    template <typename T>
+    struct Property {
+        PropertyKey key;
+
+        explicit Property(std::string_view name) : key(PropertyKey::intern(name)) {}
+    };
+
+    /// @brief Per-element property storage: a short flat list of interned keys and inline values.
+    ///
+    /// bool, int, float and Color are held inline; anything else falls back to std::any.
+    /// Elements carry a handful of properties at most, so scanning a few integer keys beats hashing.
+    class PropertyMap {
+    public:
+        using Value = std::variant<std::monostate, bool, int, float, Color, std::any>;
+
+    private:
+        struct Entry {
+            std::uint32_t key;
+            Value value;
+        };
+        std::vector<Entry> entries_{};
+
+        template <typename T>
+        static constexpr bool inline_type = std::is_same_v<T, bool> || std::is_same_v<T, int>
+                                            || std::is_same_v<T, float> || std::is_same_v<T, Color>;
+
+        [[nodiscard]] const Value* find(PropertyKey key) const {
+            for (const auto& e : entries_) {
+                if (e.key == key.id()) return &e.value;
+            }
+            return nullptr;
+        }
+
+    public:
+        void set(PropertyKey key, Value value) {
+            for (auto& e : entries_) {
+                if (e.key == key.id()) {
+                    e.value = std::move(value);
+                    return;
+                }
+            }
+            entries_.push_back({key.id(), std::move(value)});
+        }
+
+        template <typename T>
+        void set(const Property<T>& property, T value) {
+            if constexpr (inline_type<T>) {
+                set(property.key, Value{std::move(value)});
+            } else {
+                set(property.key, Value{std::any{std::move(value)}});
+            }
+        }
+
+        /// @brief The value if set with this type, without boxing for inline types
+        template <typename T>
+        [[nodiscard]] std::optional<T> get(const Property<T>& property) const {
+            const Value* value = find(property.key);
+            if (!value) return std::nullopt;
+            if constexpr (inline_type<T>) {
+                if (const T* v = std::get_if<T>(value)) return *v;
+            } else if (const auto* boxed = std::get_if<std::any>(value)) {
+                if (const T* v = std::any_cast<T>(boxed)) return *v;
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] bool contains(PropertyKey key) const {
+            return find(key) != nullptr;
+        }
+
+        void erase(PropertyKey key) {
+            std::erase_if(entries_, [&](const Entry& e) { return e.key == key.id(); });
+        }
+
+        /// @brief The value boxed in std::any, for the string-keyed API
+        [[nodiscard]] std::any get_any(PropertyKey key) const {
+            const Value* value = find(key);
+            if (!value) return {};
+            return std::visit([]<typename V>(const V& v) -> std::any {
+                if constexpr (std::is_same_v<V, std::monostate>) {
+                    return {};
+                } else {
+                    return v;
+                }
+            }, *value);
+        }
+
+        /// @brief Stores a boxed value, unboxing the inline types
+        void set_any(PropertyKey key, std::any value) {
+            if (const bool* b = std::any_cast<bool>(&value)) set(key, Value{*b});
+            else if (const int* i = std::any_cast<int>(&value)) set(key, Value{*i});
+            else if (const float* f = std::any_cast<float>(&value)) set(key, Value{*f});
+            else if (const Color* c = std::any_cast<Color>(&value)) set(key, Value{*c});
+            else set(key, Value{std::move(value)});
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return entries_.size();
+        }
+    };
+}
@@ -0,0 +1,74 @@
+// Checks PropertyKey interning and PropertyMap typed, boxed and string-keyed access.
+
+#include <any>
+#include <cstdio>
+#include <string>
+
+import plastic.color;
+import plastic.property;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+int main() {
+    using plastic::Color;
+    using plastic::ElementState;
+    using plastic::Property;
+    using plastic::PropertyKey;
+    using plastic::PropertyMap;
+
+    CHECK(!PropertyKey::find("property_test.missing"));
+    const PropertyKey a = PropertyKey::intern("property_test.a");
+    CHECK(PropertyKey::intern("property_test.a") == a);
+    CHECK(PropertyKey::find("property_test.a") == a);
+    CHECK(a.name() == "property_test.a");
+    CHECK(!(PropertyKey::intern("property_test.b") == a));
+    CHECK(!PropertyKey::find("property_test.missing"));
+
+    CHECK(plastic::state_named("hovered") == ElementState::Hovered);
+    CHECK(plastic::state_named("opacity") == ElementState::None);
+    const ElementState both = ElementState::Focused | ElementState::Pressed;
+    CHECK((both & ElementState::Pressed) == ElementState::Pressed);
+    CHECK((both & ~ElementState::Pressed) == ElementState::Focused);
+
+    const Property<float> opacity{"property_test.opacity"};
+    const Property<int> count{"property_test.count"};
+    const Property<Color> tint{"property_test.tint"};
+    const Property<std::string> label{"property_test.label"};
+
+    PropertyMap map;
+    CHECK(!map.get(opacity));
+    map.set(opacity, 0.5f);
+    map.set(count, 3);
+    map.set(tint, Color(1, 2, 3));
+    map.set(label, std::string("hi"));
+    CHECK(map.size() == 4);
+    CHECK(map.get(opacity) == 0.5f);
+    CHECK(map.get(count) == 3);
+    CHECK(map.get(tint) == Color(1, 2, 3));
+    CHECK(map.get(label) == std::string("hi"));
+
+    // Overwriting keeps one entry per key; a value of another type reads as unset
+    map.set(opacity, 0.25f);
+    CHECK(map.size() == 4);
+    CHECK(map.get(opacity) == 0.25f);
+    map.set(count.key, PropertyMap::Value{1.5f});
+    CHECK(!map.get(count));
+    CHECK(map.contains(count.key));
+
+    // The string-keyed path unboxes inline types, so typed reads still see them
+    map.set_any(count.key, std::any{7});
+    CHECK(map.get(count) == 7);
+    CHECK(std::any_cast<int>(map.get_any(count.key)) == 7);
+    map.set_any(label.key, std::any{std::string("boxed")});
+    CHECK(map.get(label) == std::string("boxed"));
+    CHECK(std::any_cast<std::string>(map.get_any(label.key)) == "boxed");
+    CHECK(!map.get_any(a).has_value());
+
+    map.erase(opacity.key);
+    CHECK(!map.contains(opacity.key));
+    CHECK(!map.get(opacity));
+    CHECK(map.size() == 3);
+    map.erase(opacity.key);
+    CHECK(map.size() == 3);
+    return 0;
+}
@@ -1,42 +1,226 @@
 //
 // Created by Aidan Jost on 3/7/25.
 //
+/// @file object_pool.ixx
+/// @brief Slab-backed fixed-size allocation and object pools
+
 module;
-#include <vector>
-#if defined(_WIN32)
 #include <algorithm>
+#include <cstddef>
 #include <memory>
-#endif
+#include <new>
+#include <utility>
+#include <vector>
 export module plastic.object_pool;
 
 export namespace plastic
 {
+    /// @brief Reuse counters for a pool
+    struct PoolStats {
+        std::size_t slabs{0};
+        std::size_t capacity{0};    ///< Blocks across all slabs
+        std::size_t live{0};        ///< Blocks handed out and not yet returned
+        std::size_t peak{0};        ///< Highest `live` seen
+        std::size_t allocations{0}; ///< Blocks handed out in total
+        std::size_t reuses{0};      ///< Of those, blocks that had been returned before
+    };
+
+    /// @brief Equal-sized blocks carved from contiguous slabs, recycled through an intrusive free list.
+    ///
+    /// Allocation pops the free list and release pushes onto it, both O(1). A returned block
+    /// holds the link to the next free one, so the list costs no memory of its own. Slabs are
+    /// only freed with the arena. Not thread-safe; see thread_pool() for per-thread pools.
+    class SlabArena {
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct SlabDeleter {
+            std::size_t align;
+            void operator()(std::byte* slab) const {
+                ::operator delete(slab, std::align_val_t{align});
+            }
+        };
+
+        std::size_t block_size_{0};
+        std::size_t align_{alignof(std::max_align_t)};
+        std::size_t slab_blocks_;
+        std::vector<std::unique_ptr<std::byte, SlabDeleter>> slabs_{};
+        FreeBlock* free_{nullptr};
+        std::size_t fresh_{0};      ///< Never-used blocks left at the end of the newest slab
+        PoolStats stats_{};
+
+        void add_slab() {
+            const std::size_t bytes = block_size_ * slab_blocks_;
+            slabs_.emplace_back(static_cast<std::byte*>(::operator new(bytes, std::align_val_t{align_})), SlabDeleter{align_});
+            fresh_ = slab_blocks_;
+            ++stats_.slabs;
+            stats_.capacity += slab_blocks_;
+        }
+
+    public:
+        /// @param block_size Bytes per block; 0 defers the size to the first configure() call
+        /// @param slab_blocks Blocks per slab
+        explicit SlabArena(std::size_t block_size = 0, std::size_t align = alignof(std::max_align_t), std::size_t slab_blocks = 64)
+            : slab_blocks_(std::max<std::size_t>(slab_blocks, 1)) {
+            if (block_size > 0) {
+                configure(block_size, align);
+            }
+        }
+
+        SlabArena(const SlabArena&) = delete;
+        SlabArena& operator=(const SlabArena&) = delete;
+
+        /// @brief Fixes the block layout; only the first call before any allocation has an effect
+        void configure(std::size_t size, std::size_t align) {
+            if (block_size_ != 0) return;
+            align_ = std::max({align, alignof(FreeBlock), align_});
+            const std::size_t size_with_link = std::max(size, sizeof(FreeBlock));
+            block_size_ = (size_with_link + align_ - 1) / align_ * align_;
+        }
+
+        /// @brief Whether an object of this layout can live in one block, settling the layout if unset
+        [[nodiscard]] bool accepts(std::size_t size, std::size_t align) {
+            configure(size, align);
+            return size <= block_size_ && align <= align_;
+        }
+
+        [[nodiscard]] void* allocate() {
+            ++stats_.allocations;
+            stats_.peak = std::max(stats_.peak, ++stats_.live);
+            if (free_) {
+                ++stats_.reuses;
+                return std::exchange(free_, free_->next);
+            }
+            if (fresh_ == 0) {
+                add_slab();
+            }
+            return slabs_.back().get() + block_size_ * (slab_blocks_ - fresh_--);
+        }
+
+        void deallocate(void* block) {
+            auto* node = static_cast<FreeBlock*>(block);
+            node->next = free_;
+            free_ = node;
+            --stats_.live;
+        }
+
+        /// @brief Grows capacity so the next `count` allocations do not allocate slabs
+        void reserve(std::size_t count) {
+            while (stats_.capacity - stats_.live < count) {
+                // Unused tail blocks would be stranded by a new slab, so move them to the free list
+                while (fresh_ > 0) {
+                    deallocate(slabs_.back().get() + block_size_ * (slab_blocks_ - fresh_--));
+                    ++stats_.live;
+                }
+                add_slab();
+            }
+        }
+
+        [[nodiscard]] std::size_t block_size() const {
+            return block_size_;
+        }
+
+        [[nodiscard]] const PoolStats& stats() const {
+            return stats_;
+        }
+    };
+
+    /// @brief Standard allocator over a shared SlabArena, for allocate_shared and node containers.
+    /// Single-object requests that fit a block come from the arena; the rest go to the heap.
+    /// Each copy keeps the arena alive, so memory is valid until the last allocation is gone.
     template <typename T>
-    class ObjectPool {
-        std::vector<std::unique_ptr<T>> free_objects;
-        std::vector<std::unique_ptr<T>> used_objects;
+    class PoolAllocator {
+        template <typename U> friend class PoolAllocator;
+        std::shared_ptr<SlabArena> arena_;
+
     public:
-        std::shared_ptr<T> acquire() {
-            if (free_objects.empty()) {
-                free_objects.push_back(std::make_unique<T>());
+        using value_type = T;
+
+        explicit PoolAllocator(std::shared_ptr<SlabArena> arena) : arena_(std::move(arena)) {}
+
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>& other) noexcept : arena_(other.arena_) {}
+
+        [[nodiscard]] T* allocate(std::size_t n) {
+            if (n == 1 && arena_->accepts(sizeof(T), alignof(T))) {
+                return static_cast<T*>(arena_->allocate());
             }
-            auto obj = std::move(free_objects.back());
-            free_objects.pop_back();
-            used_objects.push_back(std::move(obj));
-            return std::shared_ptr<T>(used_objects.back().get(), [this](T* ptr) {
-                this->release(ptr);
-            });
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
         }
 
-        void release(T* obj) {
-            auto it = std::find_if(used_objects.begin(), used_objects.end(),
-                [obj](const auto& p) { return p.get() == obj; });
-            if (it != used_objects.end()) {
-                free_objects.push_back(std::move(*it));
-                used_objects.erase(it);
+        void deallocate(T* p, std::size_t n) {
+            if (n == 1 && arena_->accepts(sizeof(T), alignof(T))) {
+                arena_->deallocate(p);
+                return;
             }
+            ::operator delete(p, std::align_val_t{alignof(T)});
+        }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>& other) const noexcept {
+            return arena_ == other.arena_;
         }
     };
-}
 
+    /// @brief Pool of T objects: constructed on acquire, destroyed on release, memory kept for reuse
+    template <typename T>
+    class ObjectPool {
+        SlabArena arena_;
+
+    public:
+        /// Returns an object to its pool when the handle goes away
+        struct Releaser {
+            ObjectPool* pool;
+            void operator()(T* object) const {
+                pool->release(object);
+            }
+        };
+        using Handle = std::unique_ptr<T, Releaser>;
+
+        explicit ObjectPool(std::size_t slab_objects = 64) : arena_(sizeof(T), alignof(T), slab_objects) {}
 
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+        /// @brief Constructs an object in pooled memory; pair with release()
+        template <typename... Args>
+        [[nodiscard]] T* create(Args&&... args) {
+            void* block = arena_.allocate();
+            try {
+                return ::new (block) T(std::forward<Args>(args)...);
+            } catch (...) {
+                arena_.deallocate(block);
+                throw;
+            }
+        }
+
+        /// @brief Like create(), but the object is released automatically with the handle
+        template <typename... Args>
+        [[nodiscard]] Handle acquire(Args&&... args) {
+            return Handle(create(std::forward<Args>(args)...), Releaser{this});
+        }
+
+        void release(T* object) {
+            if (!object) return;
+            object->~T();
+            arena_.deallocate(object);
+        }
+
+        void reserve(std::size_t count) {
+            arena_.reserve(count);
+        }
+
+        [[nodiscard]] const PoolStats& stats() const {
+            return arena_.stats();
+        }
+    };
+
+    /// @brief This thread's pool for T, usable without locking.
+    /// @note Objects must be released on the thread that acquired them, before that thread exits
+    template <typename T>
+    ObjectPool<T>& thread_pool() {
+        thread_local ObjectPool<T> pool;
+        return pool;
+    }
+}
@@ -0,0 +1,115 @@
+// Checks SlabArena block layout, reuse and reserve, and ObjectPool and PoolAllocator lifetimes.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+import plastic.object_pool;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+namespace {
+    int alive = 0;
+
+    struct Tracked {
+        std::string name;
+        explicit Tracked(std::string n) : name(std::move(n)) { ++alive; }
+        ~Tracked() { --alive; }
+    };
+}
+
+int main() {
+    {
+        // Blocks are aligned, distinct and sized up to the alignment; released blocks come back first
+        plastic::SlabArena arena(24, 32, 4);
+        CHECK(arena.block_size() == 32);
+        std::set<void*> seen;
+        std::vector<void*> blocks;
+        for (int i = 0; i < 10; ++i) {
+            void* block = arena.allocate();
+            CHECK(reinterpret_cast<std::uintptr_t>(block) % 32 == 0);
+            CHECK(seen.insert(block).second);
+            std::memset(block, 0xAB, arena.block_size());
+            blocks.push_back(block);
+        }
+        CHECK(arena.stats().slabs == 3);
+        CHECK(arena.stats().live == 10);
+        CHECK(arena.stats().reuses == 0);
+
+        arena.deallocate(blocks[3]);
+        arena.deallocate(blocks[7]);
+        CHECK(arena.allocate() == blocks[7]);
+        CHECK(arena.allocate() == blocks[3]);
+        CHECK(arena.stats().reuses == 2);
+        CHECK(arena.stats().peak == 10);
+
+        // Reserving moves the unused tail of the last slab to the free list before adding slabs
+        arena.reserve(9);
+        const std::size_t slabs = arena.stats().slabs;
+        CHECK(arena.stats().capacity - arena.stats().live >= 9);
+        for (int i = 0; i < 9; ++i) {
+            CHECK(seen.insert(arena.allocate()).second);
+        }
+        CHECK(arena.stats().slabs == slabs);
+        CHECK(arena.stats().live == 19);
+    }
+    {
+        // A deferred layout is settled by the first accepts() and not changed by later ones
+        plastic::SlabArena arena;
+        CHECK(arena.block_size() == 0);
+        CHECK(arena.accepts(40, 8));
+        const std::size_t size = arena.block_size();
+        CHECK(size >= 40);
+        CHECK(!arena.accepts(size + 1, 8));
+        CHECK(arena.block_size() == size);
+    }
+    {
+        plastic::ObjectPool<Tracked> pool(2);
+        Tracked* first = pool.create("a");
+        CHECK(first->name == "a");
+        CHECK(alive == 1);
+        pool.release(first);
+        CHECK(alive == 0);
+        {
+            auto handle = pool.acquire("b");
+            CHECK(handle.get() == first);
+            CHECK(handle->name == "b");
+            CHECK(alive == 1);
+        }
+        CHECK(alive == 0);
+        CHECK(pool.stats().live == 0);
+        CHECK(pool.stats().reuses == 1);
+        pool.release(nullptr);
+        CHECK(pool.stats().live == 0);
+    }
+    {
+        // Node containers take their nodes from the arena, which outlives the allocator copies
+        std::list<int, plastic::PoolAllocator<int>> numbers{plastic::PoolAllocator<int>(std::make_shared<plastic::SlabArena>())};
+        for (int i = 0; i < 100; ++i) {
+            numbers.push_back(i);
+        }
+        numbers.remove_if([](int n) { return n % 2 == 0; });
+        for (int i = 0; i < 50; ++i) {
+            numbers.push_front(-i);
+        }
+        CHECK(numbers.size() == 100);
+        CHECK(numbers.back() == 99);
+        CHECK(numbers.front() == -49);
+
+        // Shared objects allocated through the pool survive the arena's last named owner
+        auto arena = std::make_shared<plastic::SlabArena>();
+        auto shared = std::allocate_shared<Tracked>(plastic::PoolAllocator<Tracked>(arena), "c");
+        CHECK(arena->stats().live == 1);
+        arena.reset();
+        CHECK(shared->name == "c");
+        shared.reset();
+        CHECK(alive == 0);
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+//
+// Uniform grid over a container's children, for hit-testing and culling without a linear scan.
+//
+/// @file spatial_index.ixx
+/// @brief bucketed rectangle index keyed by child slot
+
+module;
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+export module plastic.spatial_index;
+
+import plastic.rect;
+import plastic.point;
+
+export namespace plastic
+{
+    /// @brief Rectangles bucketed into square cells, each identified by a small integer id.
+    ///
+    /// A query visits only the cells it overlaps, so its cost follows the number of nearby
+    /// items rather than the total. Items spanning more than `max_cells_per_item` cells
+    /// (backgrounds, full-width panels) are kept in a short side list that is always scanned.
+    /// Results come back in ascending id order, which for children is paint order.
+    class SpatialIndex {
+        static constexpr std::size_t max_cells_per_item = 64;
+
+        struct CellRange {
+            std::int32_t x0{0}, y0{0}, x1{-1}, y1{-1};
+        };
+
+        struct Entry {
+            Rect<float> bounds{};
+            CellRange cells{};
+            bool live{false};
+            bool large{false};
+        };
+
+        float cell_size_;
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> cells_{};
+        std::vector<Entry> entries_{};
+        std::vector<std::uint32_t> large_{};
+        mutable std::vector<std::uint32_t> seen_{};
+        mutable std::uint32_t query_{0};
+
+        static std::uint64_t key(std::int32_t x, std::int32_t y) {
+            return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 | static_cast<std::uint32_t>(y);
+        }
+
+        [[nodiscard]] std::int32_t cell_of(float v) const {
+            // Clamped so unbounded rectangles still map to a finite range
+            return static_cast<std::int32_t>(std::clamp(std::floor(v / cell_size_), -1.0e9f, 1.0e9f));
+        }
+
+        /// Inclusive of the far edges, like Rect::contains
+        [[nodiscard]] CellRange range_of(const Rect<float>& r) const {
+            return {cell_of(r.x()), cell_of(r.y()), cell_of(r.x() + r.width()), cell_of(r.y() + r.height())};
+        }
+
+        static std::size_t cell_count(const CellRange& c) {
+            if (c.x1 < c.x0 || c.y1 < c.y0) return 0;
+            return static_cast<std::size_t>(c.x1 - c.x0 + 1) * static_cast<std::size_t>(c.y1 - c.y0 + 1);
+        }
+
+        template <typename F>
+        static void for_cells(const CellRange& c, F&& f) {
+            for (std::int32_t y = c.y0; y <= c.y1; ++y) {
+                for (std::int32_t x = c.x0; x <= c.x1; ++x) {
+                    f(key(x, y));
+                }
+            }
+        }
+
+        void link(std::uint32_t id) {
+            Entry& e = entries_[id];
+            e.cells = range_of(e.bounds);
+            e.large = cell_count(e.cells) > max_cells_per_item;
+            if (e.large) {
+                large_.push_back(id);
+                return;
+            }
+            for_cells(e.cells, [&](std::uint64_t k) { cells_[k].push_back(id); });
+        }
+
+        void unlink(std::uint32_t id) {
+            Entry& e = entries_[id];
+            if (e.large) {
+                std::erase(large_, id);
+                return;
+            }
+            for_cells(e.cells, [&](std::uint64_t k) {
+                auto it = cells_.find(k);
+                if (it == cells_.end()) return;
+                std::erase(it->second, id);
+                if (it->second.empty()) {
+                    cells_.erase(it);
+                }
+            });
+        }
+
+        /// Each id is reported once per query even when it sits in several cells
+        bool first_visit(std::uint32_t id) const {
+            if (seen_[id] == query_) return false;
+            seen_[id] = query_;
+            return true;
+        }
+
+        void begin_query() const {
+            seen_.resize(entries_.size(), 0);
+            if (++query_ == 0) {
+                std::ranges::fill(seen_, 0u);
+                query_ = 1;
+            }
+        }
+
+    public:
+        explicit SpatialIndex(float cell_size = 128.0f) : cell_size_(std::max(cell_size, 1.0f)) {}
+
+        void insert(std::uint32_t id, const Rect<float>& bounds) {
+            if (id >= entries_.size()) {
+                entries_.resize(id + 1);
+            }
+            if (entries_[id].live) {
+                unlink(id);
+            }
+            entries_[id].bounds = bounds;
+            entries_[id].live = true;
+            link(id);
+        }
+
+        /// @brief Moves an item; cheap when it stays within the same cells
+        void update(std::uint32_t id, const Rect<float>& bounds) {
+            if (id >= entries_.size() || !entries_[id].live) {
+                insert(id, bounds);
+                return;
+            }
+            Entry& e = entries_[id];
+            const CellRange cells = range_of(bounds);
+            if (cells.x0 == e.cells.x0 && cells.y0 == e.cells.y0 && cells.x1 == e.cells.x1 && cells.y1 == e.cells.y1) {
+                e.bounds = bounds;
+                return;
+            }
+            unlink(id);
+            e.bounds = bounds;
+            link(id);
+        }
+
+        void remove(std::uint32_t id) {
+            if (id >= entries_.size() || !entries_[id].live) return;
+            unlink(id);
+            entries_[id].live = false;
+        }
+
+        void clear() {
+            cells_.clear();
+            entries_.clear();
+            large_.clear();
+        }
+
+        /// @brief Ids whose bounds intersect `area`, ascending
+        void query(const Rect<float>& area, std::vector<std::uint32_t>& out) const {
+            out.clear();
+            if (area.width() <= 0 || area.height() <= 0) return;
+            begin_query();
+            const auto visit = [&](std::uint32_t id) {
+                if (first_visit(id) && entries_[id].bounds.intersects(area)) {
+                    out.push_back(id);
+                }
+            };
+            const CellRange range = range_of(area);
+            if (cell_count(range) > cells_.size()) {
+                // A query wider than the populated cells is cheaper walked the other way
+                for (const auto& [k, ids] : cells_) {
+                    std::ranges::for_each(ids, visit);
+                }
+            } else {
+                for_cells(range, [&](std::uint64_t k) {
+                    if (auto it = cells_.find(k); it != cells_.end()) {
+                        std::ranges::for_each(it->second, visit);
+                    }
+                });
+            }
+            std::ranges::for_each(large_, visit);
+            std::ranges::sort(out);
+        }
+
+        /// @brief Ids whose bounds contain `point`, descending so the front-most comes first
+        void query(const Point<float>& point, std::vector<std::uint32_t>& out) const {
+            out.clear();
+            const auto visit = [&](std::uint32_t id) {
+                if (entries_[id].bounds.contains(point)) {
+                    out.push_back(id);
+                }
+            };
+            if (auto it = cells_.find(key(cell_of(point.x), cell_of(point.y))); it != cells_.end()) {
+                std::ranges::for_each(it->second, visit);
+            }
+            std::ranges::for_each(large_, visit);
+            std::ranges::sort(out, std::greater{});
+        }
+
+        [[nodiscard]] bool contains(std::uint32_t id) const {
+            return id < entries_.size() && entries_[id].live;
+        }
+    };
+}
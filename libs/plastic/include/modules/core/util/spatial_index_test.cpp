@@ -0,0 +1,66 @@
+// Checks SpatialIndex rectangle and point queries against a linear scan, through moves and removals.
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+import plastic.rect;
+import plastic.point;
+import plastic.spatial_index;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+int main() {
+    using plastic::Rect;
+    using plastic::Point;
+
+    plastic::SpatialIndex index(32.0f);
+    std::vector<Rect<float>> bounds(60);
+    std::vector<bool> live(60, false);
+
+    std::mt19937 rng(9);
+    const auto random_rect = [&] {
+        // Mostly small items, some spanning far more cells than the index buckets
+        const float size = rng() % 10 == 0 ? 2000.0f : static_cast<float>(rng() % 80 + 1);
+        return Rect<float>(static_cast<float>(rng() % 1000) - 100.0f, static_cast<float>(rng() % 1000) - 100.0f,
+                           size, static_cast<float>(rng() % 80 + 1));
+    };
+
+    std::vector<std::uint32_t> found;
+    for (int step = 0; step < 3000; ++step) {
+        const auto id = static_cast<std::uint32_t>(rng() % bounds.size());
+        if (live[id] && rng() % 4 == 0) {
+            index.remove(id);
+            live[id] = false;
+        } else {
+            bounds[id] = random_rect();
+            index.update(id, bounds[id]);
+            live[id] = true;
+        }
+        CHECK(index.contains(id) == live[id]);
+
+        const Rect<float> area(static_cast<float>(rng() % 1000) - 100.0f, static_cast<float>(rng() % 1000) - 100.0f,
+                               static_cast<float>(rng() % 300 + 1), static_cast<float>(rng() % 300 + 1));
+        std::vector<std::uint32_t> expected;
+        for (std::uint32_t i = 0; i < bounds.size(); ++i) {
+            if (live[i] && bounds[i].intersects(area)) {
+                expected.push_back(i);
+            }
+        }
+        index.query(area, found);
+        CHECK(found == expected);
+
+        const Point<float> point(area.x(), area.y());
+        expected.clear();
+        for (std::uint32_t i = static_cast<std::uint32_t>(bounds.size()); i-- > 0;) {
+            if (live[i] && bounds[i].contains(point)) {
+                expected.push_back(i);
+            }
+        }
+        index.query(point, found);
+        CHECK(found == expected);
+    }
+    return 0;
+}
@@ -2,9 +2,14 @@
 // Created by Aidan Jost on 2/25/25.
 //
 module;
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <raylib.h>
 #include <string>
+#include <vector>
 export module plastic.font;
 import plastic.point;
 import plastic.size;
@@ -84,6 +89,118 @@ export namespace plastic
         }
     };
 
+    /// Bounded memo of MeasureTextEx results, shared by every font and element.
+    /// A fixed two-way set-associative table: lookups never allocate and the older entry of a
+    /// set is simply overwritten. Entries are keyed by font texture, size, spacing and a 64-bit
+    /// hash of the text, and keep a copy of the text so a hash collision is a miss, never a wrong
+    /// width. Lookups only allocate when a miss needs a longer copy than its slot held before.
+    /// Like the rest of the UI it is meant for the main thread.
+    class TextMeasureCache {
+    public:
+        struct Stats {
+            std::uint64_t hits{0};
+            std::uint64_t misses{0};
+        };
+
+    private:
+        struct Entry {
+            std::uint64_t hash{0};
+            unsigned int font{0};
+            float size{0.0f};
+            float spacing{0.0f};
+            std::uint32_t length{0};
+            std::uint32_t stamp{0};  // 0 marks an empty slot
+            Vector2 result{};
+            std::string text{};
+        };
+
+        std::vector<Entry> entries_;
+        std::uint32_t tick_{0};
+        Stats stats_{};
+
+        static std::uint64_t hash(unsigned int font, float size, float spacing, const char* text, std::size_t length) {
+            // FNV-1a over the text, then the numeric key folded in
+            std::uint64_t h = 0xCBF29CE484222325ull;
+            for (std::size_t i = 0; i < length; ++i) {
+                h = (h ^ static_cast<unsigned char>(text[i])) * 0x100000001B3ull;
+            }
+            h ^= (static_cast<std::uint64_t>(font) << 32) ^ std::bit_cast<std::uint32_t>(size);
+            h *= 0x9E3779B97F4A7C15ull;
+            h ^= std::bit_cast<std::uint32_t>(spacing);
+            return h ^ (h >> 29);
+        }
+
+    public:
+        explicit TextMeasureCache(std::size_t capacity = 4096)
+            : entries_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity)) {}
+
+        static TextMeasureCache& shared() {
+            static TextMeasureCache cache;
+            return cache;
+        }
+
+        Vector2 measure(const ::Font& font, const char* text, float size, float spacing) {
+            const std::size_t length = std::strlen(text);
+            const std::uint64_t h = hash(font.texture.id, size, spacing, text, length);
+            const std::size_t set = static_cast<std::size_t>(h) & (entries_.size() - 2);
+            Entry* slots[2] = {&entries_[set], &entries_[set + 1]};
+            for (Entry* entry : slots) {
+                if (entry->stamp != 0 && entry->hash == h && entry->font == font.texture.id &&
+                    entry->size == size && entry->spacing == spacing && entry->length == length &&
+                    std::memcmp(entry->text.data(), text, length) == 0) {
+                    entry->stamp = ++tick_;
+                    ++stats_.hits;
+                    return entry->result;
+                }
+            }
+
+            ++stats_.misses;
+            Entry& victim = slots[0]->stamp <= slots[1]->stamp ? *slots[0] : *slots[1];
+            victim.hash = h;
+            victim.font = font.texture.id;
+            victim.size = size;
+            victim.spacing = spacing;
+            victim.length = static_cast<std::uint32_t>(length);
+            victim.stamp = ++tick_;
+            victim.result = MeasureTextEx(font, text, size, spacing);
+            // assign() reuses the slot's buffer, so steady-state misses stop allocating
+            victim.text.assign(text, length);
+            return victim.result;
+        }
+
+        /// Drops the entries of a font whose texture is going away, since the id can be reused
+        void forget(unsigned int font) {
+            for (auto& entry : entries_) {
+                if (entry.font == font) {
+                    entry.stamp = 0;
+                }
+            }
+        }
+
+        void clear() {
+            for (auto& entry : entries_) {
+                entry.stamp = 0;
+            }
+        }
+
+        [[nodiscard]] Stats stats() const {
+            return stats_;
+        }
+
+        void reset_stats() {
+            stats_ = {};
+        }
+
+        [[nodiscard]] std::size_t capacity() const {
+            return entries_.size();
+        }
+    };
+
+    /// MeasureTextEx through the shared cache
+    inline Vector2 measure_text_cached(const ::Font& font, const char* text, float size, float spacing) {
+        return TextMeasureCache::shared().measure(font, text, size, spacing);
+    }
+
     struct GlyphInformation {
         int value;              // Character value (Unicode)
         int offsetX;            // Character offset X when drawing
@@ -128,6 +245,7 @@ export namespace plastic
         }
 
         void unload() {
+            TextMeasureCache::shared().forget(font_.texture.id);
             UnloadFont(font_);
             font_ = {};
         }
@@ -136,7 +254,7 @@ export namespace plastic
 
         // Measure text with this font
         Size<float> measure_text(const std::string& text, float fontSize, float spacing = 1.0f) const {
-            Vector2 size = MeasureTextEx(font_, text.c_str(), fontSize, spacing);
+            Vector2 size = measure_text_cached(font_, text.c_str(), fontSize, spacing);
             return Size<float>{size.x, size.y};
         }
 
@@ -0,0 +1,104 @@
+//
+// Nestable scissor and render target state on top of raylib's single-level modes.
+//
+/// @file render_state.ixx
+/// @brief scissor and render target stacks
+
+module;
+#include <algorithm>
+#include <optional>
+#include <vector>
+#include <raylib.h>
+#include <rlgl.h>
+export module plastic.render_state;
+
+namespace plastic::detail
+{
+    /// One entry per active render target (the screen first), each with its own clip stack.
+    /// Clips are kept in screen coordinates; `origin` is the screen point at the target's corner.
+    struct TargetState {
+        RenderTexture2D target{};
+        Vector2 origin{};
+        std::vector<Rectangle> clips{};
+    };
+
+    std::vector<TargetState>& targets() {
+        static std::vector<TargetState> stack{TargetState{}};
+        return stack;
+    }
+
+    void bind(const TargetState& state) {
+        BeginTextureMode(state.target);
+        if (state.origin.x != 0.0f || state.origin.y != 0.0f) {
+            rlTranslatef(-state.origin.x, -state.origin.y, 0.0f);
+        }
+    }
+
+    void apply(const TargetState& state) {
+        if (state.clips.empty()) {
+            EndScissorMode();
+            return;
+        }
+        const Rectangle& clip = state.clips.back();
+        BeginScissorMode(static_cast<int>(clip.x - state.origin.x), static_cast<int>(clip.y - state.origin.y),
+                         static_cast<int>(clip.width), static_cast<int>(clip.height));
+    }
+}
+
+export namespace plastic
+{
+    /// @brief Clips drawing to `clip` intersected with the enclosing clip; pair with pop_scissor()
+    void push_scissor(const Rectangle& clip) {
+        auto& clips = detail::targets().back().clips;
+        Rectangle next = clip;
+        if (!clips.empty()) {
+            const Rectangle& outer = clips.back();
+            const float x1 = std::max(outer.x, clip.x);
+            const float y1 = std::max(outer.y, clip.y);
+            const float x2 = std::min(outer.x + outer.width, clip.x + clip.width);
+            const float y2 = std::min(outer.y + outer.height, clip.y + clip.height);
+            next = {x1, y1, std::max(0.0f, x2 - x1), std::max(0.0f, y2 - y1)};
+        }
+        clips.push_back(next);
+        detail::apply(detail::targets().back());
+    }
+
+    /// @brief Restores the clip that was active before the matching push_scissor()
+    void pop_scissor() {
+        auto& clips = detail::targets().back().clips;
+        if (!clips.empty()) {
+            clips.pop_back();
+        }
+        detail::apply(detail::targets().back());
+    }
+
+    /// @brief The active clip in screen coordinates, or nothing when the current target is unclipped
+    std::optional<Rectangle> current_scissor() {
+        const auto& clips = detail::targets().back().clips;
+        if (clips.empty()) {
+            return std::nullopt;
+        }
+        return clips.back();
+    }
+
+    /// @brief Redirects drawing into `target` with no clip; pair with end_render_target().
+    /// @param origin Screen point drawn at the target's top-left corner, so content keeps its screen coordinates
+    /// @note Unlike BeginTextureMode, this nests: the enclosing target and its clip come back afterwards
+    void begin_render_target(const RenderTexture2D& target, Vector2 origin = {0.0f, 0.0f}) {
+        EndScissorMode();
+        detail::targets().push_back({target, origin, {}});
+        detail::bind(detail::targets().back());
+    }
+
+    void end_render_target() {
+        auto& stack = detail::targets();
+        EndTextureMode();
+        if (stack.size() > 1) {
+            stack.pop_back();
+        }
+        if (stack.size() > 1) {
+            detail::bind(stack.back());
+        }
+        detail::apply(stack.back());
+    }
+}
@@ -0,0 +1,54 @@
+// Checks TextMeasureCache hits, misses, eviction and forget() against MeasureTextEx itself.
+// The font is built in memory with fixed advances, so no window or GPU is needed.
+
+#include <cstdio>
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+import plastic.font;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+int main() {
+    // Printable ASCII, each glyph as wide as its index so different texts measure differently
+    std::vector<GlyphInfo> glyphs(95);
+    std::vector<Rectangle> recs(95);
+    for (int i = 0; i < 95; ++i) {
+        glyphs[i].value = 32 + i;
+        glyphs[i].advanceX = i + 1;
+        recs[i] = Rectangle{0, 0, static_cast<float>(i + 1), 10};
+    }
+    Font font{};
+    font.baseSize = 10;
+    font.glyphCount = 95;
+    font.texture.id = 7;
+    font.glyphs = glyphs.data();
+    font.recs = recs.data();
+
+    plastic::TextMeasureCache cache(2);
+    const auto direct = [&](const char* text) { return MeasureTextEx(font, text, 10.0f, 1.0f).x; };
+
+    CHECK(cache.measure(font, "abc", 10.0f, 1.0f).x == direct("abc"));
+    CHECK(cache.measure(font, "abc", 10.0f, 1.0f).x == direct("abc"));
+    CHECK(cache.stats().hits == 1 && cache.stats().misses == 1);
+
+    // Same length, different text: never served from the other's entry
+    CHECK(cache.measure(font, "xyz", 10.0f, 1.0f).x == direct("xyz"));
+    // A different size is a different entry
+    CHECK(cache.measure(font, "abc", 20.0f, 1.0f).x == MeasureTextEx(font, "abc", 20.0f, 1.0f).x);
+
+    // With one set, churning many texts evicts but never returns a stale width
+    for (int i = 0; i < 200; ++i) {
+        const std::string text = "w" + std::to_string(i);
+        CHECK(cache.measure(font, text.c_str(), 10.0f, 1.0f).x == direct(text.c_str()));
+    }
+
+    cache.reset_stats();
+    cache.measure(font, "abc", 10.0f, 1.0f);
+    cache.measure(font, "abc", 10.0f, 1.0f);
+    cache.forget(font.texture.id);
+    cache.measure(font, "abc", 10.0f, 1.0f);
+    CHECK(cache.stats().hits == 1 && cache.stats().misses == 2);
+    return 0;
+}
@@ -0,0 +1,285 @@
+//
+// Arena storage for element trees, with generational handles.
+//
+/// @file element_arena.ixx
+/// @brief element trees allocated from shared slabs
+
+module;
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module plastic.element_arena;
+
+import plastic.object_pool;
+import plastic.element;
+
+export namespace plastic
+{
+    /// @brief Compact, non-owning reference to an arena element.
+    /// Stale handles are detected by generation rather than dangling like a raw pointer.
+    struct ElementHandle {
+        std::uint32_t index{std::numeric_limits<std::uint32_t>::max()};
+        std::uint32_t generation{0};
+
+        [[nodiscard]] bool valid() const {
+            return index != std::numeric_limits<std::uint32_t>::max();
+        }
+
+        bool operator==(const ElementHandle&) const = default;
+    };
+
+    class ElementArena;
+}
+
+namespace plastic::detail
+{
+    /// Blocks of 64, 128, ... 2048 bytes; element types larger than that use the heap
+    constexpr std::size_t arena_granule = 64;
+    constexpr std::size_t arena_classes = 32;
+    constexpr std::size_t arena_max_block = arena_granule * arena_classes;
+    /// Upper bound on what allocate_shared adds around the object: vtable, counts, allocator copy
+    constexpr std::size_t arena_control_overhead = 64;
+
+    class ArenaState {
+        struct Slot {
+            Element* element{nullptr};
+            std::uint32_t generation{0};
+        };
+
+        std::array<std::unique_ptr<SlabArena>, arena_classes> classes_{};
+        std::vector<Slot> slots_{};
+        std::vector<std::uint32_t> free_slots_{};
+        std::size_t live_{0};
+        std::size_t heap_fallbacks_{0};
+
+    public:
+        ArenaState() {
+            for (std::size_t k = 0; k < arena_classes; ++k) {
+                const std::size_t block = (k + 1) * arena_granule;
+                // Roughly 16 KiB slabs, so small elements pack densely and large ones still batch
+                classes_[k] = std::make_unique<SlabArena>(block, alignof(std::max_align_t), std::max<std::size_t>(4, 16384 / block));
+            }
+        }
+
+        [[nodiscard]] static SlabArena* class_for(ArenaState& state, std::size_t bytes, std::size_t align) {
+            if (bytes == 0 || bytes > arena_max_block || align > alignof(std::max_align_t)) {
+                return nullptr;
+            }
+            return state.classes_[(bytes - 1) / arena_granule].get();
+        }
+
+        ElementHandle attach(Element* element) {
+            ++live_;
+            std::uint32_t index;
+            if (!free_slots_.empty()) {
+                index = free_slots_.back();
+                free_slots_.pop_back();
+            } else {
+                index = static_cast<std::uint32_t>(slots_.size());
+                slots_.emplace_back();
+            }
+            slots_[index].element = element;
+            return {index, slots_[index].generation};
+        }
+
+        void detach(ElementHandle handle) {
+            --live_;
+            Slot& slot = slots_[handle.index];
+            slot.element = nullptr;
+            ++slot.generation;
+            free_slots_.push_back(handle.index);
+        }
+
+        [[nodiscard]] Element* resolve(ElementHandle handle) const {
+            if (!handle.valid() || handle.index >= slots_.size()) return nullptr;
+            const Slot& slot = slots_[handle.index];
+            return slot.generation == handle.generation ? slot.element : nullptr;
+        }
+
+        [[nodiscard]] std::size_t live() const {
+            return live_;
+        }
+
+        void count_heap_fallback() {
+            ++heap_fallbacks_;
+        }
+
+        [[nodiscard]] std::size_t heap_fallbacks() const {
+            return heap_fallbacks_;
+        }
+
+        [[nodiscard]] std::size_t reserved_bytes() const {
+            std::size_t bytes = 0;
+            for (const auto& c : classes_) {
+                bytes += c->stats().capacity * c->block_size();
+            }
+            return bytes;
+        }
+    };
+
+    /// Allocator handed to allocate_shared; its copy in each control block keeps the state alive
+    template <typename T>
+    class ArenaAllocator {
+        template <typename U> friend class ArenaAllocator;
+        std::shared_ptr<ArenaState> state_;
+
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(std::shared_ptr<ArenaState> state) : state_(std::move(state)) {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : state_(other.state_) {}
+
+        [[nodiscard]] T* allocate(std::size_t n) {
+            if (auto* slab = ArenaState::class_for(*state_, n * sizeof(T), alignof(T))) {
+                return static_cast<T*>(slab->allocate());
+            }
+            state_->count_heap_fallback();
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            if (auto* slab = ArenaState::class_for(*state_, n * sizeof(T), alignof(T))) {
+                slab->deallocate(p);
+                return;
+            }
+            ::operator delete(p, std::align_val_t{alignof(T)});
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept {
+            return state_ == other.state_;
+        }
+    };
+
+    /// The element as stored in the arena: registers a handle for its lifetime
+    template <typename T>
+    class Tracked final : public T {
+        ArenaState* state_;
+        ElementHandle handle_;
+
+    public:
+        template <typename... Args>
+        explicit Tracked(ArenaState* state, Args&&... args)
+            : T(std::forward<Args>(args)...), state_(state), handle_(state->attach(this)) {}
+
+        ~Tracked() override {
+            state_->detach(handle_);
+        }
+
+        [[nodiscard]] ElementHandle handle() const {
+            return handle_;
+        }
+    };
+
+    ElementArena*& current_arena();
+}
+
+export namespace plastic
+{
+    /// @brief Whether ElementArena stores a T (with its control block) in a slab rather than on the heap
+    /// @note Every element in plastic fits today; Scrollable, the largest, is about 1.3 KiB with
+    /// its control block. Custom elements can check with `static_assert(fits_arena_v<MyElement>)`.
+    template <typename T>
+    constexpr bool fits_arena_v = sizeof(detail::Tracked<T>) + detail::arena_control_overhead <= detail::arena_max_block
+                                  && alignof(T) <= alignof(std::max_align_t);
+
+    /// @brief Optional storage for an element tree: elements and their control blocks are packed
+    /// into shared slabs by size class instead of one heap allocation each.
+    ///
+    /// A tree built in one pass lands in consecutive blocks, so layout and paint walk nearby memory.
+    /// Dropping the tree returns its blocks to the arena's free lists for the next build, and the
+    /// slabs are released together once the arena and the last of its elements are gone.
+    /// Elements stay ordinary shared_ptr-owned Elements, so existing code works on them unchanged.
+    /// @note Single-threaded, like the element tree itself
+    class ElementArena {
+        std::shared_ptr<detail::ArenaState> state_{std::make_shared<detail::ArenaState>()};
+
+    public:
+        ElementArena() = default;
+        ElementArena(const ElementArena&) = delete;
+        ElementArena& operator=(const ElementArena&) = delete;
+
+        template <typename T, typename... Args>
+            requires std::derived_from<T, Element> && (!std::is_final_v<T>)
+        [[nodiscard]] std::shared_ptr<T> make(Args&&... args) {
+            return std::allocate_shared<detail::Tracked<T>>(
+                detail::ArenaAllocator<detail::Tracked<T>>(state_), state_.get(), std::forward<Args>(args)...);
+        }
+
+        /// @brief The handle of an element this arena made as a T, or an invalid handle
+        template <typename T>
+        [[nodiscard]] ElementHandle handle_of(const T& element) const {
+            if (const auto* tracked = dynamic_cast<const detail::Tracked<T>*>(&element)) {
+                if (resolve(tracked->handle()) == &element) {
+                    return tracked->handle();
+                }
+            }
+            return {};
+        }
+
+        /// @brief The element behind `handle`, or null once it has been destroyed
+        [[nodiscard]] Element* resolve(ElementHandle handle) const {
+            return state_->resolve(handle);
+        }
+
+        /// @brief Shared ownership of the element behind `handle`, or null once it has been destroyed
+        [[nodiscard]] std::shared_ptr<Element> lock(ElementHandle handle) const {
+            auto* element = resolve(handle);
+            return element ? element->shared_from_this() : nullptr;
+        }
+
+        /// @brief Elements made here and still alive
+        [[nodiscard]] std::size_t live() const {
+            return state_->live();
+        }
+
+        [[nodiscard]] std::size_t reserved_bytes() const {
+            return state_->reserved_bytes();
+        }
+
+        /// @brief Elements made here that were too large for any size class and went to the heap
+        [[nodiscard]] std::size_t heap_fallbacks() const {
+            return state_->heap_fallbacks();
+        }
+    };
+
+    /// @brief Routes make_element() into `arena` for the scope's lifetime, e.g. around View::render
+    class ArenaScope {
+        ElementArena* previous_;
+
+    public:
+        explicit ArenaScope(ElementArena* arena) : previous_(std::exchange(detail::current_arena(), arena)) {}
+        ~ArenaScope() { detail::current_arena() = previous_; }
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+    };
+
+    /// @brief Creates an element in the active ArenaScope's arena, or on the heap outside one
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make_element(Args&&... args) {
+        if constexpr (std::derived_from<T, Element> && !std::is_final_v<T>) {
+            if (auto* arena = detail::current_arena()) {
+                return arena->template make<T>(std::forward<Args>(args)...);
+            }
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+}
+
+namespace plastic::detail
+{
+    ElementArena*& current_arena() {
+        thread_local ElementArena* arena = nullptr;
+        return arena;
+    }
+}
@@ -4,35 +4,53 @@
 
 module;
 #include <memory>
-#include <vector>
+#include <type_traits>
+#include <utility>
 export module plastic.element_pool;
 
+import plastic.object_pool;
+
 export namespace plastic
 {
 
-    /// @brief A simple object pool for managing reusable elements.
+    /// @brief Pooled storage for elements that are created and dropped often (list rows, popups, tooltips).
+    ///
+    /// Elements are still owned through std::shared_ptr, which enable_shared_from_this needs, but
+    /// the object and its control block share one block from a slab arena. Dropping the last
+    /// reference destroys the element and returns the block, so steady churn stops reaching malloc.
+    /// Elements may safely outlive the pool: the arena lives until its last block is returned.
     /// @tparam T The type of elements to be pooled.
     template<typename T>
     class ElementPool {
-        std::vector<std::unique_ptr<T>> free_elements_;
-
-        /// @brief Private constructor to prevent instantiation.
-        /// This class should be used as a singleton or through a factory method.
-        std::shared_ptr<T> acquire() {
-            if (free_elements_.empty()) {
-                return std::make_shared<T>();
-            } else {
-                auto element = std::move(free_elements_.back());
-                free_elements_.pop_back();
-                return element;
+        std::shared_ptr<SlabArena> arena_;
+
+    public:
+        /// @param slab_elements Elements per slab
+        explicit ElementPool(std::size_t slab_elements = 64)
+            : arena_(std::make_shared<SlabArena>(0, alignof(T), slab_elements)) {}
+
+        /// @brief Constructs an element in pooled memory
+        template <typename... Args>
+        [[nodiscard]] std::shared_ptr<T> acquire(Args&&... args) {
+            return std::allocate_shared<T>(PoolAllocator<T>(arena_), std::forward<Args>(args)...);
+        }
+
+        /// @brief Preallocates room for `count` more elements
+        /// @note Needs T to be default-constructible, or one element acquired beforehand
+        void reserve(std::size_t count) {
+            if constexpr (std::is_default_constructible_v<T>) {
+                if (arena_->block_size() == 0) {
+                    // Settle the block layout by creating and dropping one element
+                    (void)acquire();
+                }
+            }
+            if (arena_->block_size() != 0) {
+                arena_->reserve(count);
             }
         }
 
-        /// @brief Reset the element to its default state
-        /// @param element The element to reset
-        void release(T* element) {
-            element->reset();
-            free_elements_.push_back(std::unique_ptr<T>(element));
+        [[nodiscard]] const PoolStats& stats() const {
+            return arena_->stats();
         }
     };
 
@@ -5,6 +5,7 @@
 /// @brief Basic elements for the Plastic UI framework
 
 module;
+#include <algorithm>
 #include <string>
 #include <functional>
 #include <raylib.h>
@@ -21,7 +22,9 @@ import plastic.color;
 import plastic.events;
 import plastic.size;
 import plastic.point;
+import plastic.font;
 import plastic.font_registry;
+import plastic.render_batch;
 import plastic.style;
 
 export namespace plastic
@@ -53,10 +56,24 @@ export namespace plastic
             calculate_size();
         }
 
+        [[nodiscard]] bool paints_into_batch() const override {
+            return true;
+        }
+
         /// @brief Paints the text element on the screen
         void paint(Context* cx) const override {
             auto default_font = FontRegistry::get_global_default_font();
 
+            if (auto* batch = cx ? cx->batch() : nullptr) {
+                if (default_font && default_font->is_valid()) {
+                    batch->draw_text(*default_font, text_, Point{bounds.x(), bounds.y()}, font_size_, 1.0f, color_);
+                } else {
+                    // DrawText's spacing for the default font
+                    batch->draw_text(text_, {bounds.x(), bounds.y()}, font_size_, std::max(font_size_, 10.0f) / 10.0f, color_);
+                }
+                return;
+            }
+
             if (default_font && default_font->is_valid()) {
                 // Use our custom font
                 default_font->draw_text(
@@ -95,7 +112,7 @@ export namespace plastic
                 current_size = default_font->measure_text(text_, font_size_, 1.0f);
             } else {
                 // Fallback to Raylib's MeasureText
-                auto [x, y] = MeasureTextEx(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
+                auto [x, y] = measure_text_cached(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
                 current_size = Size<float>{x, y};
             }
 
@@ -145,7 +162,7 @@ export namespace plastic
             if (default_font && default_font->is_valid()) {
                 return default_font->measure_text(text_, font_size_, 1.0f);
             }
-            Vector2 size = MeasureTextEx(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
+            Vector2 size = measure_text_cached(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
             return Size<float>{size.x, size.y};
         };
 
@@ -180,6 +197,10 @@ export namespace plastic
             bounds = Rect<float>{0, 0, 100, 40};
         }
 
+        [[nodiscard]] bool paints_into_batch() const override {
+            return true;
+        }
+
         void paint(Context* cx) const override {
             const auto& bounds = get_bounds();
 
@@ -189,9 +210,17 @@ export namespace plastic
             else if (is_hovered_) current_bg = hover_color_;
             else current_bg = bg_color_;
 
+            auto* batch = cx ? cx->batch() : nullptr;
+
             // Draw button background
             if (corner_radius_ > 0) {
+                if (batch) {
+                    // Drawn directly, so whatever was recorded beneath it must land first
+                    batch->flush();
+                }
                 DrawRectangleRounded(bounds.to_rl(), corner_radius_, 10, current_bg.rl());
+            } else if (batch) {
+                batch->draw_rectangle(bounds, current_bg);
             } else {
                 DrawRectangleRec(bounds.to_rl(), current_bg.rl());
             }
@@ -199,6 +228,23 @@ export namespace plastic
             // Get default font
             auto default_font = FontRegistry::get_global_default_font();
 
+            if (batch) {
+                if (default_font && default_font->is_valid()) {
+                    auto text_size = default_font->measure_text(text_, font_size_, 1.0f);
+                    batch->draw_text(*default_font, text_,
+                                     Point{bounds.x() + (bounds.width() - text_size.width()) / 2,
+                                           bounds.y() + (bounds.height() - text_size.height()) / 2},
+                                     font_size_, 1.0f, text_color_);
+                } else {
+                    const float spacing = std::max(font_size_, 10.0f) / 10.0f;
+                    Vector2 text_size = measure_text_cached(GetFontDefault(), text_.c_str(), font_size_, spacing);
+                    batch->draw_text(text_, {bounds.x() + (bounds.width() - text_size.x) / 2,
+                                             bounds.y() + (bounds.height() - text_size.y) / 2},
+                                     font_size_, spacing, text_color_);
+                }
+                return;
+            }
+
             // Draw text centered
             if (default_font && default_font->is_valid()) {
                 // Measure text using our custom font
@@ -216,7 +262,7 @@ export namespace plastic
                 );
             } else {
                 // Fallback to Raylib's default font
-                Vector2 text_size = MeasureTextEx(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
+                Vector2 text_size = measure_text_cached(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
                 float text_x = bounds.x() + (bounds.width() - text_size.x) / 2;
                 float text_y = bounds.y() + (bounds.height() - text_size.y) / 2;
 
@@ -232,7 +278,7 @@ export namespace plastic
 
         void layout(Context* cx) override {
             // Calculate minimum button size based on text
-            Vector2 text_size = MeasureTextEx(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
+            Vector2 text_size = measure_text_cached(GetFontDefault(), text_.c_str(), font_size_, 1.0f);
             current_size = Size<float>{
                 text_size.x + padding_ * 2,
                 text_size.y + padding_ * 2
@@ -313,7 +359,7 @@ export namespace plastic
 
         [[nodiscard]] Size<float> get_preferred_size() const override {
             // Calculate minimum button size based on text
-            Vector2 text_size = MeasureTextEx(font::get_default()->rl(), text_.c_str(), font_size_, 1.0f);
+            Vector2 text_size = measure_text_cached(font::get_default()->rl(), text_.c_str(), font_size_, 1.0f);
             return Size<float>{
                 text_size.x + padding_ * 2,
                 text_size.y + padding_ * 2
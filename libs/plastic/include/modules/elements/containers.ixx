@@ -12,6 +12,7 @@ module;
 export module plastic.elements.containers;
 
 import plastic.element;
+import plastic.element_arena;
 import plastic.context;
 import plastic.rect;
 import plastic.color;
@@ -67,21 +68,14 @@ export namespace plastic
 
             // Apply clipping if needed
             if (clip_children_) {
-                BeginScissorMode(
-                    static_cast<int>(bounds.x()),
-                    static_cast<int>(bounds.y()),
-                    static_cast<int>(bounds.width()),
-                    static_cast<int>(bounds.height())
-                );
+                bounds.apply_scissor();
             }
 
-            // Paint all children
-            for (const auto& child : get_children()) {
-                child->paint(cx);
-            }
+            // Paint the children that reach the clip
+            composite_children(cx);
 
             if (clip_children_) {
-                EndScissorMode();
+                Rect<float>::stop_scissor();
             }
         }
 
@@ -130,7 +124,7 @@ export namespace plastic
 
         template<typename... Children>
         static std::shared_ptr<VStack> create(Children... children) {
-            auto container = std::make_shared<VStack>();
+            auto container = make_element<VStack>();
             (container->add_child(children), ...);
             return container;
         }
@@ -150,7 +144,7 @@ export namespace plastic
 
         template<typename... Children>
         static std::shared_ptr<HStack> create(Children... children) {
-            auto container = std::make_shared<HStack>();
+            auto container = make_element<HStack>();
             (container->add_child(children), ...);
             return container;
         }
@@ -189,7 +183,7 @@ export namespace plastic
 
         template<typename... Children>
         static std::shared_ptr<FlexBox> create(Children... children) {
-            auto container = std::make_shared<FlexBox>();
+            auto container = make_element<FlexBox>();
             (container->add_child(children), ...);
             return container;
         }
@@ -0,0 +1,55 @@
+// Checks HeightIndex offsets and lookups against a linear prefix sum, through resets and height changes.
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+import plastic.virtual_list;
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+int main() {
+    plastic::detail::HeightIndex index;
+    CHECK(index.size() == 0);
+    CHECK(index.total() == 0.0);
+    CHECK(index.index_at(10.0) == 0);
+
+    std::mt19937 rng(5);
+    for (const std::size_t count : {1u, 7u, 64u, 300u}) {
+        std::vector<float> heights(count, 40.0f);
+        index.reset(count, 40.0f);
+        CHECK(index.size() == count);
+        CHECK(!index.measured(count - 1));
+
+        for (int step = 0; step < 1500; ++step) {
+            const std::size_t i = rng() % count;
+            // Whole-pixel heights keep the float sums exact, so the comparisons can be strict
+            const float height = static_cast<float>(rng() % 120 + 1);
+            index.set(i, height);
+            heights[i] = height;
+            CHECK(index.measured(i));
+            CHECK(index.height(i) == height);
+
+            double top = 0.0;
+            for (std::size_t k = 0; k < count; ++k) {
+                CHECK(index.offset(k) == top);
+                // First pixel, a middle one and the last pixel of each item all map back to it
+                CHECK(index.index_at(top) == k);
+                CHECK(index.index_at(top + heights[k] / 2.0) == k);
+                CHECK(index.index_at(top + heights[k] - 0.5) == k);
+                top += heights[k];
+            }
+            CHECK(index.total() == top);
+            CHECK(index.index_at(top + 100.0) == count - 1);
+            CHECK(index.index_at(-5.0) == 0);
+
+            if (step % 50 == 0) {
+                index.forget(i);
+                CHECK(!index.measured(i));
+                CHECK(index.height(i) == height);
+            }
+        }
+    }
+    return 0;
+}
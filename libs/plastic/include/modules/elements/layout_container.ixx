@@ -76,10 +76,8 @@ export namespace plastic
                 );
             }
 
-            // Paint all children
-            for (const auto& child : get_children()) {
-                child->paint(cx);
-            }
+            // Paint the children that reach the clip
+            composite_children(cx);
 
         };
     };
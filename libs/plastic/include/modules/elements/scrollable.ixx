@@ -67,22 +67,11 @@ export namespace plastic
             // Set up clipping to prevent content from rendering outside bounds
             bounds.apply_scissor();
 
-            // Draw children with offset
-            for (const auto& child : get_children()) {
-                // Adjust child position based on scroll
-                Rect<float> original_bounds = child->get_bounds();
-                Rect<float> scrolled_bounds{
-                    original_bounds.x() - scroll_x_,
-                    original_bounds.y() - scroll_y_,
-                    original_bounds.width(),
-                    original_bounds.height()
-                };
-
-                // Only draw if visible
-                if (bounds.intersects(scrolled_bounds)) {
-                    child->paint(cx);
-                }
-            }
+            // Draw only the children whose scrolled bounds reach the viewport
+            const Rect<float> content_viewport{bounds.x() + scroll_x_, bounds.y() + scroll_y_, bounds.width(), bounds.height()};
+            for_each_child_in(content_viewport, [cx](const std::shared_ptr<Element>& child) {
+                child->composite(cx);
+            });
 
             Rect<float>::stop_scissor();
 
@@ -144,6 +133,11 @@ export namespace plastic
             return false;
         }
 
+        [[nodiscard]] float scroll_x() const { return scroll_x_; }
+        [[nodiscard]] float scroll_y() const { return scroll_y_; }
+        [[nodiscard]] float content_width() const { return content_width_; }
+        [[nodiscard]] float content_height() const { return content_height_; }
+
         void set_content_size(float width, float height) {
             content_width_ = width;
             content_height_ = height;
@@ -5,43 +5,176 @@
 /// @brief Virtualized list element
 
 module;
+#include <algorithm>
 #include <vector>
 #include <functional>
 #include <memory>
+#include <ranges>
 #include <variant>
 #include <cmath>
 export module plastic.virtual_list;
 
 import plastic.element;
+import plastic.element_pool;
 import plastic.context;
 import plastic.rect;
 import plastic.size;
 import plastic.events;
 
+/// Exported for the unit tests; not part of the element API
+export namespace plastic::detail
+{
+    /// Item offsets as a Fenwick tree over heights: prefix sums and offset lookups in O(log n).
+    /// Doubles keep offsets exact enough past a million rows.
+    class HeightIndex {
+        std::vector<double> tree_{};    ///< 1-based
+        std::vector<float> heights_{};
+        std::vector<bool> measured_{};
+
+        static std::size_t low_bit(std::size_t i) { return i & (~i + 1); }
+
+    public:
+        void reset(std::size_t count, float estimate) {
+            heights_.assign(count, estimate);
+            measured_.assign(count, false);
+            tree_.assign(count + 1, 0.0);
+            for (std::size_t i = 1; i <= count; ++i) {
+                tree_[i] += estimate;
+                if (const std::size_t up = i + low_bit(i); up <= count) {
+                    tree_[up] += tree_[i];
+                }
+            }
+        }
+
+        [[nodiscard]] std::size_t size() const { return heights_.size(); }
+        [[nodiscard]] bool measured(std::size_t i) const { return measured_[i]; }
+        [[nodiscard]] float height(std::size_t i) const { return heights_[i]; }
+
+        void set(std::size_t i, float height) {
+            measured_[i] = true;
+            const double delta = static_cast<double>(height) - heights_[i];
+            heights_[i] = height;
+            if (delta == 0.0) return;
+            for (std::size_t k = i + 1; k < tree_.size(); k += low_bit(k)) {
+                tree_[k] += delta;
+            }
+        }
+
+        void forget(std::size_t i) {
+            measured_[i] = false;
+        }
+
+        /// Top of item `i`, i.e. the summed height of the items before it
+        [[nodiscard]] double offset(std::size_t i) const {
+            double sum = 0.0;
+            for (std::size_t k = i; k > 0; k -= low_bit(k)) {
+                sum += tree_[k];
+            }
+            return sum;
+        }
+
+        [[nodiscard]] double total() const {
+            return offset(heights_.size());
+        }
+
+        /// The item covering `y`, clamped to the last item
+        [[nodiscard]] std::size_t index_at(double y) const {
+            std::size_t pos = 0;
+            std::size_t step = 1;
+            while (step * 2 < tree_.size()) step *= 2;
+            for (; step > 0; step /= 2) {
+                if (pos + step < tree_.size() && tree_[pos + step] <= y) {
+                    pos += step;
+                    y -= tree_[pos];
+                }
+            }
+            return std::min(pos, heights_.empty() ? 0 : heights_.size() - 1);
+        }
+    };
+}
+
 export namespace plastic {
+    /// @brief Vertical list that only keeps elements for the rows in view.
+    ///
+    /// Given a factory and a binder the list recycles: rows leaving the view return their
+    /// element to a pool for their item type, and rows entering take one back and rebind it,
+    /// so scrolling allocates nothing once the pools cover a screenful. Without them each
+    /// newly visible row is built by the renderer, while rows that stay visible are kept.
+    /// Rows are `item_height` tall unless a height function is set; heights are then measured
+    /// as rows first come into view, with `item_height` standing in for the rest.
     template <typename T>
     class VirtualizedList : public Element {
     public:
         using ItemRenderer = std::function<std::shared_ptr<Element>(const T&, size_t)>;
+        /// Builds an unbound element for an item type
+        using ItemFactory = std::function<std::shared_ptr<Element>(size_t type)>;
+        /// Points a (possibly recycled) element at an item
+        using ItemBinder = std::function<void(Element&, const T&, size_t)>;
+        using ItemType = std::function<size_t(const T&, size_t)>;
+        using ItemHeight = std::function<float(const T&, size_t)>;
 
     private:
+        struct Row {
+            size_t index;
+            size_t type;
+            std::shared_ptr<Element> element;
+        };
+
         std::vector<T> items_;
         ItemRenderer renderer_;
+        ItemFactory factory_{};
+        ItemBinder binder_{};
+        ItemType type_of_{};
+        ItemHeight height_of_{};
         float item_height_{40.0f};
         float scroll_position_{0};
-        std::unordered_map<size_t, std::shared_ptr<Element>> visible_elements_;
+
+        detail::HeightIndex heights_{};
+        std::vector<Row> rows_{};               ///< Visible rows by ascending index
+        std::vector<Row> next_rows_{};          ///< Scratch for the next frame's rows, swapped in
+        std::vector<std::vector<std::shared_ptr<Element>>> pools_{};   ///< Spare elements per item type
 
     public:
         VirtualizedList(std::vector<T> items, ItemRenderer renderer, float item_height = 40.0f)
             : items_(std::move(items)), renderer_(std::move(renderer)), item_height_(item_height) {}
 
+        /// @brief A recycling list; `factory` is called only when a type's pool runs dry
+        VirtualizedList(std::vector<T> items, ItemFactory factory, ItemBinder binder, float item_height = 40.0f)
+            : items_(std::move(items)), factory_(std::move(factory)), binder_(std::move(binder)), item_height_(item_height) {}
+
+        /// @brief Factory that builds rows of type `E` in slab memory from one shared ElementPool
+        /// @note Spare rows are recycled through the per-type pools; this keeps the rows that do get
+        /// built (first screenful, resizes, new item types) and their control blocks out of malloc.
+        template <typename E, typename... Args>
+        [[nodiscard]] static ItemFactory pooled_factory(Args... args) {
+            auto pool = std::make_shared<ElementPool<E>>();
+            return [pool, args...](size_t) -> std::shared_ptr<Element> {
+                return pool->acquire(args...);
+            };
+        }
+
+        /// @brief Separates pools by item type so rows are only recycled into matching elements
+        VirtualizedList& with_item_types(ItemType type_of) {
+            type_of_ = std::move(type_of);
+            reset_rows();
+            return *this;
+        }
+
+        /// @brief Switches to variable row heights, measured lazily as rows become visible
+        VirtualizedList& with_item_heights(ItemHeight height_of) {
+            height_of_ = std::move(height_of);
+            heights_.reset(height_of_ ? items_.size() : 0, item_height_);
+            reset_rows();
+            return *this;
+        }
+
         void layout(Context* cx) override {
             update_visible_elements();
         }
 
         void paint(Context* cx) const override {
-            for (const auto& [index, element] : visible_elements_) {
-                element->paint(cx);
+            for (const auto& row : rows_) {
+                row.element->composite(cx);
             }
         }
 
@@ -54,9 +187,9 @@ export namespace plastic {
                 return true;
             }
 
-            // Delegate events to visible children
-            for (auto& [index, element] : visible_elements_) {
-                if (element->handle_event(event, cx)) {
+            // Delegate events to visible children, front to back
+            for (const auto& row : std::ranges::reverse_view(rows_)) {
+                if (row.element->handle_event(event, cx)) {
                     return true;
                 }
             }
@@ -72,37 +205,155 @@ export namespace plastic {
 
         void set_items(std::vector<T> items) {
             items_ = std::move(items);
+            heights_.reset(height_of_ ? items_.size() : 0, item_height_);
+            reset_rows();
+            scroll_position_ = std::max(0.0f, std::min(scroll_position_, max_scroll()));
+            update_visible_elements();
+            invalidate();
+        }
+
+        /// @brief Rebinds and remeasures one item after its data changed in place
+        void item_changed(size_t index) {
+            if (index >= items_.size()) return;
+            if (height_of_) {
+                heights_.forget(index);
+            }
+            // The row is left empty so the next update rebinds it in place
+            for (auto& row : rows_) {
+                if (row.index == index) {
+                    release(row);
+                    break;
+                }
+            }
             update_visible_elements();
             invalidate();
         }
 
     private:
-        void update_visible_elements() {
-            visible_elements_.clear();
+        [[nodiscard]] bool recycling() const {
+            return factory_ && binder_;
+        }
+
+        [[nodiscard]] size_t type_of(size_t index) const {
+            return type_of_ ? type_of_(items_[index], index) : 0;
+        }
+
+        [[nodiscard]] double item_top(size_t index) const {
+            return height_of_ ? heights_.offset(index) : static_cast<double>(index) * item_height_;
+        }
+
+        [[nodiscard]] double content_height() const {
+            return height_of_ ? heights_.total() : static_cast<double>(items_.size()) * item_height_;
+        }
+
+        /// Height of a row about to be shown, measuring it on first sight
+        float show_height(size_t index) {
+            if (!height_of_) return item_height_;
+            if (!heights_.measured(index)) {
+                heights_.set(index, std::max(0.0f, height_of_(items_[index], index)));
+            }
+            return heights_.height(index);
+        }
+
+        void release(Row& row) {
+            if (!row.element) return;
+            if (recycling()) {
+                if (pools_.size() <= row.type) {
+                    pools_.resize(row.type + 1);
+                }
+                pools_[row.type].push_back(std::move(row.element));
+            }
+            row.element.reset();
+        }
+
+        std::shared_ptr<Element> acquire(size_t index, size_t type) {
+            if (!recycling()) {
+                auto element = renderer_(items_[index], index);
+                if (context) {
+                    element->mount(context);
+                }
+                return element;
+            }
+
+            std::shared_ptr<Element> element;
+            if (type < pools_.size() && !pools_[type].empty()) {
+                element = std::move(pools_[type].back());
+                pools_[type].pop_back();
+            } else {
+                element = factory_(type);
+                if (context) {
+                    element->mount(context);
+                }
+            }
+            binder_(*element, items_[index], index);
+            return element;
+        }
+
+        /// Returns every visible row to the pools, e.g. after the items or their types changed
+        void reset_rows() {
+            for (auto& row : rows_) {
+                release(row);
+            }
+            rows_.clear();
+        }
 
+        void update_visible_elements() {
             const auto& bounds = get_bounds();
-            float visible_start = scroll_position_;
-            float visible_end = visible_start + bounds.height();
+            if (items_.empty()) {
+                reset_rows();
+                return;
+            }
 
-            auto start_idx = static_cast<size_t>(visible_start / item_height_);
-            size_t end_idx = std::min(static_cast<size_t>(std::ceil(visible_end / item_height_)), items_.size());
+            const double visible_start = scroll_position_;
+            const double visible_end = visible_start + bounds.height();
+            const size_t first = height_of_
+                ? heights_.index_at(visible_start)
+                : std::min(static_cast<size_t>(visible_start / item_height_), items_.size() - 1);
 
-            for (size_t i = start_idx; i < end_idx; ++i) {
-                auto element = renderer_(items_[i], i);
-                float y = static_cast<float>(i) * item_height_ - scroll_position_ + bounds.y();
-                element->set_bounds(Rect<float>{
+            // Rows scrolled out of view go back to their pools before any new row needs one
+            const auto stays = [&](const Row& row) {
+                return row.index >= first && item_top(row.index) < visible_end;
+            };
+            for (auto& row : rows_) {
+                if (!stays(row)) {
+                    release(row);
+                }
+            }
+
+            // Rows are contiguous by index, so surviving ones are found by position
+            const size_t kept_first = rows_.empty() ? 0 : rows_.front().index;
+            next_rows_.clear();
+            double y = item_top(first);
+            for (size_t i = first; i < items_.size() && y < visible_end; ++i) {
+                const float height = show_height(i);
+                Row row{i, 0, nullptr};
+                if (i >= kept_first && i - kept_first < rows_.size() && rows_[i - kept_first].element
+                    && rows_[i - kept_first].index == i) {
+                    row = std::move(rows_[i - kept_first]);
+                } else {
+                    row.type = type_of(i);
+                    row.element = acquire(i, row.type);
+                }
+                row.element->set_bounds(Rect<float>{
                     bounds.x(),
-                    y,
+                    static_cast<float>(y - scroll_position_) + bounds.y(),
                     bounds.width(),
-                    item_height_
+                    height
                 });
+                next_rows_.push_back(std::move(row));
+                y += height;
+            }
 
-                visible_elements_[i] = element;
+            // Rows that measured taller than estimated may have pushed later survivors out
+            for (auto& row : rows_) {
+                release(row);
             }
+            std::swap(rows_, next_rows_);
+            next_rows_.clear();
         }
 
         float max_scroll() const {
-            return std::max(0.0f, static_cast<float>(items_.size()) * item_height_ - get_bounds().height());
+            return std::max(0.0f, static_cast<float>(content_height()) - get_bounds().height());
         }
     };
 }
@@ -4,8 +4,10 @@
 
 module;
 #include <raylib.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "fonts/rubik/rubik_regular.h"
 #include "fonts/rubik/rubik_medium.h"
@@ -20,6 +22,7 @@ module;
 export module plastic.font_registry;
 
 import plastic.font;
+import plastic.glyph_atlas;
 import plastic.font.key;
 import plastic.font.key.hash;
 import plastic.font.weight;
@@ -39,6 +42,10 @@ export namespace plastic
         std::unordered_map<FontKey, std::shared_ptr<Font>, FontKeyHash> fonts_;
         std::shared_ptr<Font> default_font_;
 
+        // Font files by key, in registration order, for atlases that rasterize glyphs on demand
+        std::vector<std::pair<FontKey, FontSource>> sources_;
+        std::vector<std::pair<std::pair<FontKey, int>, std::weak_ptr<GlyphAtlas>>> atlases_;
+
         static inline std::shared_ptr<Font> default_font_instance_ = nullptr;
 
 
@@ -113,9 +120,43 @@ export namespace plastic
 
             // Register the font
             register_font(family, weight, font);
+            sources_.emplace_back(FontKey{family, weight}, FontSource{data, data_size});
 
             return font;
         }
+
+        /// Atlas that rasterizes any codepoint on first use. The requested face is searched first,
+        /// then the same weight of every other family, then everything else that was loaded from
+        /// memory. Atlases are shared while someone holds them.
+        std::shared_ptr<GlyphAtlas> glyph_atlas(const std::string& family, FontWeight weight, int pixel_size) {
+            const std::pair<FontKey, int> atlas_key{FontKey{family, weight}, pixel_size};
+            for (const auto& [key, atlas] : atlases_) {
+                if (key == atlas_key) {
+                    if (auto shared = atlas.lock()) {
+                        return shared;
+                    }
+                }
+            }
+
+            std::vector<FontSource> chain;
+            const auto add = [&](auto&& predicate) {
+                for (const auto& [key, source] : sources_) {
+                    if (predicate(key)) {
+                        chain.push_back(source);
+                    }
+                }
+            };
+            // compare() rather than ==, which this namespace overloads for strings
+            const auto same_family = [&](const FontKey& key) { return key.family.compare(family) == 0; };
+            add([&](const FontKey& key) { return same_family(key) && key.weight == weight; });
+            add([&](const FontKey& key) { return !same_family(key) && key.weight == weight; });
+            add([&](const FontKey& key) { return key.weight != weight; });
+
+            auto atlas = std::make_shared<GlyphAtlas>(chain, pixel_size);
+            std::erase_if(atlases_, [](const auto& entry) { return entry.second.expired(); });
+            atlases_.emplace_back(atlas_key, atlas);
+            return atlas;
+        }
     private:
 
         void initialize_builtin_fonts() {
@@ -0,0 +1,400 @@
+//
+// Glyph atlas filled on demand from FreeType faces.
+//
+module;
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <raylib.h>
+#include <rlgl.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+export module plastic.glyph_atlas;
+
+import plastic.color;
+import plastic.point;
+import plastic.size;
+
+export namespace plastic
+{
+    /// @brief Font file bytes; the memory must outlive every atlas built from it
+    struct FontSource {
+        const unsigned char* data{nullptr};
+        int size{0};
+    };
+
+    /// @brief Glyph cache that rasterizes codepoints the first time they are drawn.
+    ///
+    /// Glyphs come from the first face of the fallback chain that has them and are packed into
+    /// fixed-size atlas pages on shelves. Once `max_pages` pages are full, the least recently used
+    /// page is cleared and reused; `stamp()` changes whenever that happens, so anything that
+    /// cached atlas coordinates knows to rebuild.
+    class GlyphAtlas {
+    public:
+        struct Glyph {
+            int page{-1};               ///< -1 for glyphs without ink, e.g. spaces
+            Rectangle rec{};            ///< Pixels in the page, padding included
+            float offset_x{0.0f};       ///< From the pen position to the left of `rec`
+            float offset_y{0.0f};       ///< From the top of the line to the top of `rec`
+            float advance{0.0f};
+        };
+
+    private:
+        static constexpr int padding_ = 1;
+
+        struct Page {
+            Texture2D texture{};
+            int shelf_x{0};
+            int shelf_y{0};
+            int shelf_height{0};
+            std::uint64_t last_used{0};
+            std::vector<char32_t> codepoints{};
+        };
+
+        std::vector<FT_Face> faces_{};
+        std::vector<Page> pages_{};
+        std::unordered_map<char32_t, Glyph> glyphs_{};
+        std::vector<Glyph> scratch_{};
+        /// @brief Glyph that found no room this time; handed out without caching so a later draw retries
+        Glyph uncached_{};
+        std::vector<unsigned char> pixels_{};
+        int pixel_size_;
+        int page_size_;
+        int max_pages_;
+        int open_page_{-1};
+        float ascender_{0.0f};
+        float line_height_{0.0f};
+        std::uint64_t tick_{0};
+        std::uint32_t generation_{0};
+        std::uint32_t id_;
+
+        static FT_Library library() {
+            static FT_Library library = [] {
+                FT_Library lib = nullptr;
+                if (FT_Init_FreeType(&lib) != 0) {
+                    TraceLog(LOG_ERROR, "FreeType failed to initialize");
+                }
+                return lib;
+            }();
+            return library;
+        }
+
+        static std::uint32_t next_id() {
+            static std::uint32_t id = 0;
+            return ++id;
+        }
+
+        void add_page() {
+            Image image = GenImageColor(page_size_, page_size_, ::Color{0, 0, 0, 0});
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA);
+            Page page{};
+            page.texture = LoadTextureFromImage(image);
+            SetTextureFilter(page.texture, TEXTURE_FILTER_BILINEAR);
+            UnloadImage(image);
+            pages_.push_back(std::move(page));
+            open_page_ = static_cast<int>(pages_.size()) - 1;
+        }
+
+        /// @brief Clears the least recently used page. Pages used by the current resolve() are pinned:
+        /// the glyphs already handed out for this string still point into them.
+        /// @return False when every page is pinned
+        bool evict_page() {
+            int victim = -1;
+            for (int i = 0; i < static_cast<int>(pages_.size()); ++i) {
+                if (pages_[i].last_used == tick_) {
+                    continue;
+                }
+                if (victim < 0 || pages_[i].last_used < pages_[victim].last_used) {
+                    victim = i;
+                }
+            }
+            if (victim < 0) {
+                return false;
+            }
+            // Quads already queued may still sample the page
+            rlDrawRenderBatchActive();
+
+            Page& page = pages_[victim];
+            for (const char32_t codepoint : page.codepoints) {
+                glyphs_.erase(codepoint);
+            }
+            page.codepoints.clear();
+            page.shelf_x = page.shelf_y = page.shelf_height = 0;
+            open_page_ = victim;
+            ++generation_;
+            return true;
+        }
+
+        /// @brief Finds room for a `width` x `height` cell on the open page
+        bool allocate(int width, int height, int& page_index, int& x, int& y) {
+            if (width > page_size_ || height > page_size_) {
+                return false;
+            }
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                if (open_page_ >= 0) {
+                    Page& page = pages_[open_page_];
+                    if (page.shelf_x + width > page_size_) {
+                        page.shelf_y += page.shelf_height;
+                        page.shelf_x = 0;
+                        page.shelf_height = 0;
+                    }
+                    if (page.shelf_y + height <= page_size_) {
+                        page_index = open_page_;
+                        x = page.shelf_x;
+                        y = page.shelf_y;
+                        page.shelf_x += width;
+                        page.shelf_height = std::max(page.shelf_height, height);
+                        return true;
+                    }
+                }
+                if (static_cast<int>(pages_.size()) < max_pages_) {
+                    add_page();
+                } else if (!evict_page()) {
+                    // One string needs more than max_pages; its remaining glyphs are drawn blank
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        /// @return Face and glyph index for `codepoint`, walking the fallback chain
+        std::pair<FT_Face, FT_UInt> find(char32_t codepoint) const {
+            for (FT_Face face : faces_) {
+                if (const FT_UInt index = FT_Get_Char_Index(face, codepoint); index != 0) {
+                    return {face, index};
+                }
+            }
+            return {nullptr, 0};
+        }
+
+        /// @brief Rasterizes `codepoint`; only called for codepoints some face has, and for U+FFFD
+        /// @param cached Cleared when every page is pinned, so the glyph must not be remembered
+        Glyph rasterize(char32_t codepoint, bool& cached) {
+            auto [face, index] = find(codepoint);
+            if (!face) {
+                // Not even the replacement character exists; use the primary face's .notdef
+                face = faces_.front();
+                index = 0;
+            }
+
+            Glyph glyph{};
+            if (FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL) != 0) {
+                return glyph;
+            }
+            const FT_GlyphSlot slot = face->glyph;
+            const FT_Bitmap& bitmap = slot->bitmap;
+            glyph.advance = static_cast<float>(slot->advance.x) / 64.0f;
+            if (bitmap.width == 0 || bitmap.rows == 0) {
+                return glyph;
+            }
+
+            const int width = static_cast<int>(bitmap.width) + 2 * padding_;
+            const int height = static_cast<int>(bitmap.rows) + 2 * padding_;
+            int page = 0;
+            int x = 0;
+            int y = 0;
+            if (!allocate(width, height, page, x, y)) {
+                // Oversized glyphs never fit and stay blank; a full atlas may have room next time
+                cached = width > page_size_ || height > page_size_;
+                return glyph;
+            }
+
+            // White with coverage as alpha, the layout raylib's own font atlases use
+            pixels_.assign(static_cast<std::size_t>(width * height) * 2, 0);
+            for (unsigned int row = 0; row < bitmap.rows; ++row) {
+                const unsigned char* source = bitmap.buffer + static_cast<std::ptrdiff_t>(row) * bitmap.pitch;
+                unsigned char* target = pixels_.data() + (static_cast<std::size_t>(row + padding_) * width + padding_) * 2;
+                for (unsigned int column = 0; column < bitmap.width; ++column) {
+                    target[column * 2 + 1] = source[column];
+                }
+            }
+            for (int i = 0; i < width * height; ++i) {
+                pixels_[static_cast<std::size_t>(i) * 2] = 255;
+            }
+            glyph.page = page;
+            glyph.rec = {static_cast<float>(x), static_cast<float>(y), static_cast<float>(width), static_cast<float>(height)};
+            glyph.offset_x = static_cast<float>(slot->bitmap_left - padding_);
+            glyph.offset_y = ascender_ - static_cast<float>(slot->bitmap_top + padding_);
+            UpdateTextureRec(pages_[page].texture, glyph.rec, pixels_.data());
+            pages_[page].codepoints.push_back(codepoint);
+            return glyph;
+        }
+
+        static char32_t next_codepoint(std::string_view text, std::size_t& i) {
+            const auto byte = static_cast<unsigned char>(text[i]);
+            int length = byte < 0x80 ? 1 : (byte >> 5) == 0x6 ? 2 : (byte >> 4) == 0xE ? 3 : (byte >> 3) == 0x1E ? 4 : 0;
+            if (length == 0 || i + length > text.size()) {
+                ++i;
+                return U'\uFFFD';
+            }
+            char32_t codepoint = length == 1 ? byte : byte & (0x7F >> length);
+            for (int k = 1; k < length; ++k) {
+                codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+            }
+            i += length;
+            return codepoint;
+        }
+
+    public:
+        /// @param chain Faces to search in order; the first one sets the line metrics
+        /// @param pixel_size Size glyphs are rasterized at; drawing at other sizes scales them
+        GlyphAtlas(const std::vector<FontSource>& chain, int pixel_size, int page_size = 1024, int max_pages = 4)
+            : pixel_size_(pixel_size), page_size_(page_size), max_pages_(std::max(1, max_pages)), id_(next_id()) {
+            for (const auto& source : chain) {
+                FT_Face face = nullptr;
+                if (!library() || FT_New_Memory_Face(library(), source.data, source.size, 0, &face) != 0) {
+                    TraceLog(LOG_WARNING, "Glyph atlas skipped a font it could not open");
+                    continue;
+                }
+                FT_Set_Pixel_Sizes(face, 0, static_cast<FT_UInt>(pixel_size));
+                faces_.push_back(face);
+            }
+            if (!faces_.empty()) {
+                const FT_Size_Metrics& metrics = faces_.front()->size->metrics;
+                ascender_ = static_cast<float>(metrics.ascender) / 64.0f;
+                line_height_ = static_cast<float>(metrics.height) / 64.0f;
+            }
+        }
+
+        GlyphAtlas(const GlyphAtlas&) = delete;
+        GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+        ~GlyphAtlas() {
+            for (auto& page : pages_) {
+                UnloadTexture(page.texture);
+            }
+            for (FT_Face face : faces_) {
+                FT_Done_Face(face);
+            }
+        }
+
+        [[nodiscard]] bool is_valid() const {
+            return !faces_.empty();
+        }
+
+        [[nodiscard]] int pixel_size() const {
+            return pixel_size_;
+        }
+
+        [[nodiscard]] float line_height() const {
+            return line_height_;
+        }
+
+        /// @brief Unique per atlas and per eviction; cached glyph coordinates are valid while it holds
+        [[nodiscard]] std::uint64_t stamp() const {
+            return (static_cast<std::uint64_t>(id_) << 32) | generation_;
+        }
+
+        [[nodiscard]] std::size_t glyph_count() const {
+            return glyphs_.size();
+        }
+
+        [[nodiscard]] std::size_t page_count() const {
+            return pages_.size();
+        }
+
+        [[nodiscard]] const Texture2D& page_texture(int page) const {
+            return pages_[page].texture;
+        }
+
+        /// @brief Looks up `codepoint`, rasterizing it on a miss.
+        /// Codepoints no face has share the single U+FFFD glyph instead of each rasterizing a copy.
+        const Glyph& glyph(char32_t codepoint) {
+            auto it = glyphs_.find(codepoint);
+            if (it == glyphs_.end()) {
+                if (codepoint != U'\uFFFD' && !find(codepoint).first) {
+                    const Glyph fallback = glyph(U'\uFFFD');
+                    if (!glyphs_.contains(U'\uFFFD')) {
+                        return uncached_;
+                    }
+                    if (fallback.page >= 0) {
+                        // Dropped together with the replacement glyph when its page is evicted
+                        pages_[fallback.page].codepoints.push_back(codepoint);
+                    }
+                    it = glyphs_.emplace(codepoint, fallback).first;
+                } else {
+                    bool cached = true;
+                    Glyph rasterized = rasterize(codepoint, cached);
+                    if (!cached) {
+                        uncached_ = rasterized;
+                        return uncached_;
+                    }
+                    it = glyphs_.emplace(codepoint, rasterized).first;
+                }
+            }
+            if (it->second.page >= 0) {
+                pages_[it->second.page].last_used = tick_;
+            }
+            return it->second;
+        }
+
+        /// @brief Resolves every glyph of `text` in one go. Every page touched here is stamped with
+        /// the current tick, which evict_page() treats as pinned, so a later glyph of the string
+        /// cannot evict a page an earlier one points into.
+        const std::vector<Glyph>& resolve(std::string_view text) {
+            ++tick_;
+            scratch_.clear();
+            for (std::size_t i = 0; i < text.size();) {
+                scratch_.push_back(glyph(next_codepoint(text, i)));
+            }
+            return scratch_;
+        }
+
+        Size<float> measure_text(std::string_view text, float font_size, float spacing) {
+            const float scale = font_size / static_cast<float>(pixel_size_);
+            float width = 0.0f;
+            for (const auto& g : resolve(text)) {
+                width += g.advance * scale + spacing;
+            }
+            return {text.empty() ? 0.0f : width - spacing, line_height_ * scale};
+        }
+
+        void draw_text(std::string_view text, const Point<float>& position, float font_size, float spacing, const Color& color) {
+            if (!is_valid()) {
+                return;
+            }
+            const float scale = font_size / static_cast<float>(pixel_size_);
+            const auto& glyphs = resolve(text);
+            rlCheckRenderBatchLimit(static_cast<int>(glyphs.size()) * 4);
+            float x = position.x;
+            unsigned int texture = 0;
+            for (const auto& g : glyphs) {
+                if (g.page >= 0) {
+                    const unsigned int id = pages_[g.page].texture.id;
+                    if (id != texture) {
+                        if (texture != 0) {
+                            rlEnd();
+                        }
+                        texture = id;
+                        rlSetTexture(texture);
+                        rlBegin(RL_QUADS);
+                        rlColor4ub(color.r, color.g, color.b, color.a);
+                        rlNormal3f(0.0f, 0.0f, 1.0f);
+                    }
+                    const float x0 = x + g.offset_x * scale;
+                    const float y0 = position.y + g.offset_y * scale;
+                    const float x1 = x0 + g.rec.width * scale;
+                    const float y1 = y0 + g.rec.height * scale;
+                    const float size = static_cast<float>(page_size_);
+                    rlTexCoord2f(g.rec.x / size, g.rec.y / size);
+                    rlVertex2f(x0, y0);
+                    rlTexCoord2f(g.rec.x / size, (g.rec.y + g.rec.height) / size);
+                    rlVertex2f(x0, y1);
+                    rlTexCoord2f((g.rec.x + g.rec.width) / size, (g.rec.y + g.rec.height) / size);
+                    rlVertex2f(x1, y1);
+                    rlTexCoord2f((g.rec.x + g.rec.width) / size, g.rec.y / size);
+                    rlVertex2f(x1, y0);
+                }
+                x += g.advance * scale + spacing;
+            }
+            if (texture != 0) {
+                rlEnd();
+                rlSetTexture(0);
+            }
+        }
+    };
+}
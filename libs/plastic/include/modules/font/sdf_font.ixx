@@ -0,0 +1,210 @@
+//
+// Signed distance field fonts: one atlas for every size, outline and shadow.
+//
+module;
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <raylib.h>
+#include <rlgl.h>
+export module plastic.sdf_font;
+
+import plastic.font;
+import plastic.color;
+import plastic.point;
+import plastic.size;
+
+export namespace plastic
+{
+    /// @brief How SDF text is shaded; sizes are in screen pixels
+    struct TextEffects {
+        Color color{Color::white()};
+        std::optional<Color> outline_color{};
+        float outline_width{0.0f};
+        std::optional<Color> shadow_color{};
+        Point<float> shadow_offset{1.0f, 1.0f};
+        float shadow_blur{0.0f};
+    };
+
+    /// @brief Font rasterized once as a distance field and drawn through a shader.
+    ///
+    /// The edge is reconstructed per pixel, so text stays sharp at any size or zoom without
+    /// reloading, and outline and drop shadow are evaluated in the same fragment: one quad per
+    /// glyph whatever the effects. The field reaches `field_range_` atlas pixels past the edge,
+    /// which bounds outline width and shadow offset at the base size.
+    class SdfFont {
+        // raylib's FONT_SDF_CHAR_PADDING; the shader's 255/64 mirrors FONT_SDF_PIXEL_DIST_SCALE
+        static constexpr float field_range_ = 4.0f;
+
+        static constexpr const char* fragment_shader_ = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec4 outlineColor;
+uniform float outlineWidth;
+uniform vec4 shadowColor;
+uniform vec2 shadowOffset;
+uniform float shadowSoftness;
+out vec4 finalColor;
+
+// Signed distance to the edge in atlas pixels, positive inside
+float field(vec2 uv) {
+    return (texture(texture0, uv).a - 0.5) * (255.0 / 64.0);
+}
+
+void main() {
+    float d = field(fragTexCoord);
+    float aa = max(fwidth(d) * 0.5, 0.001);
+    vec4 text = fragColor * colDiffuse;
+
+    float fill = smoothstep(-aa, aa, d);
+    vec4 front = vec4(text.rgb, text.a * fill);
+    if (outlineWidth > 0.0) {
+        float edge = smoothstep(-aa, aa, d + outlineWidth);
+        front = vec4(mix(outlineColor.rgb, text.rgb, fill), mix(outlineColor.a * edge, text.a, fill));
+    }
+
+    vec4 back = vec4(0.0);
+    if (shadowColor.a > 0.0) {
+        float s = field(fragTexCoord - shadowOffset) + outlineWidth;
+        back = vec4(shadowColor.rgb, shadowColor.a * smoothstep(-aa - shadowSoftness, aa, s));
+    }
+
+    float alpha = front.a + back.a * (1.0 - front.a);
+    vec3 rgb = (front.rgb * front.a + back.rgb * back.a * (1.0 - front.a)) / max(alpha, 0.0001);
+    finalColor = vec4(rgb, alpha);
+}
+)";
+
+        struct Uniforms {
+            float outline_color[4]{};
+            float outline_width{0.0f};
+            float shadow_color[4]{};
+            float shadow_offset[2]{};
+            float shadow_softness{0.0f};
+
+            bool operator==(const Uniforms&) const = default;
+        };
+
+        std::shared_ptr<Font> font_{};
+        Shader shader_{};
+        int outline_color_loc_{-1};
+        int outline_width_loc_{-1};
+        int shadow_color_loc_{-1};
+        int shadow_offset_loc_{-1};
+        int shadow_softness_loc_{-1};
+        // Uniforms are program state, so the batch is only flushed when they actually change
+        mutable std::optional<Uniforms> applied_{};
+
+        static void to_vec4(const Color& color, float (&out)[4]) {
+            out[0] = static_cast<float>(color.r) / 255.0f;
+            out[1] = static_cast<float>(color.g) / 255.0f;
+            out[2] = static_cast<float>(color.b) / 255.0f;
+            out[3] = static_cast<float>(color.a) / 255.0f;
+        }
+
+    public:
+        explicit SdfFont(const ::Font& font) : font_(std::make_shared<Font>(font)) {
+            shader_ = LoadShaderFromMemory(nullptr, fragment_shader_);
+            outline_color_loc_ = GetShaderLocation(shader_, "outlineColor");
+            outline_width_loc_ = GetShaderLocation(shader_, "outlineWidth");
+            shadow_color_loc_ = GetShaderLocation(shader_, "shadowColor");
+            shadow_offset_loc_ = GetShaderLocation(shader_, "shadowOffset");
+            shadow_softness_loc_ = GetShaderLocation(shader_, "shadowSoftness");
+        }
+
+        SdfFont(const SdfFont&) = delete;
+        SdfFont& operator=(const SdfFont&) = delete;
+
+        ~SdfFont() {
+            UnloadShader(shader_);
+            font_->unload();
+        }
+
+        /// @param base_size Size the field is generated at; 48 is plenty for UI and code text
+        /// @param codepoints Glyphs to include, ASCII when null
+        static std::shared_ptr<SdfFont> load_from_memory(const unsigned char* data, int data_size, int base_size = 48,
+                                                         int* codepoints = nullptr, int codepoint_count = 0) {
+            ::Font font{};
+            font.baseSize = base_size;
+            font.glyphCount = codepoint_count > 0 ? codepoint_count : 95;
+            font.glyphPadding = 0;
+            font.glyphs = LoadFontData(data, data_size, base_size, codepoints, codepoint_count, FONT_SDF);
+            if (!font.glyphs) {
+                TraceLog(LOG_ERROR, "Failed to generate SDF font data");
+                return nullptr;
+            }
+            // Empty gaps between glyphs, so shadow lookups never sample a neighbour
+            ::Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, font.glyphCount, base_size, 2, 1);
+            font.texture = LoadTextureFromImage(atlas);
+            UnloadImage(atlas);
+            SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+            return std::make_shared<SdfFont>(font);
+        }
+
+        static std::shared_ptr<SdfFont> load_from_file(const std::string& filename, int base_size = 48,
+                                                       int* codepoints = nullptr, int codepoint_count = 0) {
+            int size = 0;
+            unsigned char* data = LoadFileData(filename.c_str(), &size);
+            if (!data) {
+                return nullptr;
+            }
+            auto font = load_from_memory(data, size, base_size, codepoints, codepoint_count);
+            UnloadFileData(data);
+            return font;
+        }
+
+        /// @brief The underlying font, for measuring and for code that lays glyphs out itself
+        [[nodiscard]] const std::shared_ptr<Font>& font() const {
+            return font_;
+        }
+
+        [[nodiscard]] bool is_valid() const {
+            return font_->is_valid() && shader_.id != 0;
+        }
+
+        [[nodiscard]] Size<float> measure_text(const std::string& text, float font_size, float spacing) const {
+            return font_->measure_text(text, font_size, spacing);
+        }
+
+        /// @brief Starts shading SDF glyphs at `font_size` with `effects`; pair with end()
+        void begin(const TextEffects& effects, float font_size) const {
+            const float to_atlas = static_cast<float>(font_->font_.baseSize) / std::max(font_size, 1.0f);
+            Uniforms uniforms{};
+            if (effects.outline_color && effects.outline_width > 0.0f) {
+                to_vec4(*effects.outline_color, uniforms.outline_color);
+                uniforms.outline_width = std::min(effects.outline_width * to_atlas, field_range_ - 0.5f);
+            }
+            if (effects.shadow_color) {
+                to_vec4(*effects.shadow_color, uniforms.shadow_color);
+                uniforms.shadow_offset[0] = effects.shadow_offset.x * to_atlas / static_cast<float>(font_->font_.texture.width);
+                uniforms.shadow_offset[1] = effects.shadow_offset.y * to_atlas / static_cast<float>(font_->font_.texture.height);
+                uniforms.shadow_softness = std::min(effects.shadow_blur * to_atlas, field_range_);
+            }
+
+            BeginShaderMode(shader_);
+            if (applied_ != uniforms) {
+                rlDrawRenderBatchActive();
+                SetShaderValue(shader_, outline_color_loc_, uniforms.outline_color, SHADER_UNIFORM_VEC4);
+                SetShaderValue(shader_, outline_width_loc_, &uniforms.outline_width, SHADER_UNIFORM_FLOAT);
+                SetShaderValue(shader_, shadow_color_loc_, uniforms.shadow_color, SHADER_UNIFORM_VEC4);
+                SetShaderValue(shader_, shadow_offset_loc_, uniforms.shadow_offset, SHADER_UNIFORM_VEC2);
+                SetShaderValue(shader_, shadow_softness_loc_, &uniforms.shadow_softness, SHADER_UNIFORM_FLOAT);
+                applied_ = uniforms;
+            }
+        }
+
+        void end() const {
+            EndShaderMode();
+        }
+
+        void draw_text(const std::string& text, const Point<float>& position, float font_size, float spacing,
+                       const TextEffects& effects) const {
+            begin(effects, font_size);
+            DrawTextEx(font_->font_, text.c_str(), {position.x, position.y}, font_size, spacing, effects.color.rl());
+            end();
+        }
+    };
+}
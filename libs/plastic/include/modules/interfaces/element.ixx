@@ -7,9 +7,15 @@ module;
 #include <ranges>
 #include <vector>
 #include <any>
-#include <iostream>
-#include <unordered_map>
+#include <string>
 #include <variant>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <raylib.h>
+#include <rlgl.h>
 export module plastic.element;
 
 import plastic.style;
@@ -19,6 +25,10 @@ import plastic.layout_properties;
 import plastic.rect;
 import plastic.events;
 import plastic.point;
+import plastic.render_state;
+import plastic.render_batch;
+import plastic.spatial_index;
+import plastic.property;
 export namespace plastic
 {
     struct Element : std::enable_shared_from_this<Element>
@@ -29,13 +39,90 @@ export namespace plastic
         std::weak_ptr<Element> parent;
         Rect<float> bounds;
         LayoutProperties layout_properties;
-        std::unordered_map<std::string, std::any> properties_;
+        PropertyMap properties_;
+        ElementState states_{ElementState::None};
 
 
         std::vector<std::shared_ptr<Element>> children;
 
         Context* context{nullptr};
 
+    private:
+        /// Offscreen copy of the subtree's drawing; copies of an element start without one
+        struct Layer {
+            bool enabled_{false};
+            mutable bool stale_{true};
+            mutable RenderTexture2D texture_{};
+
+            Layer() = default;
+            Layer(const Layer& other) : enabled_(other.enabled_) {}
+            Layer& operator=(const Layer& other) {
+                enabled_ = other.enabled_;
+                stale_ = true;
+                return *this;
+            }
+            ~Layer() { release(); }
+
+            void release() const {
+                if (texture_.id != 0) {
+                    UnloadRenderTexture(texture_);
+                    texture_ = {};
+                }
+                stale_ = true;
+            }
+        };
+        Layer layer_{};
+
+        /// Below this many children a direct scan beats the index
+        static constexpr std::size_t spatial_index_threshold = 16;
+
+        /// Position in the parent's children, the key of this element in the parent's index
+        std::uint32_t slot_{0};
+        mutable SpatialIndex child_index_{};
+        mutable bool child_index_stale_{true};
+        mutable std::vector<std::uint32_t> hits_{};
+        /// Children under the pointer, reused by every pointer event instead of allocating per event
+        std::vector<std::shared_ptr<Element>> under_{};
+        /// Child that took the last button press; it keeps getting moves and drags until release
+        std::weak_ptr<Element> pointer_capture_{};
+
+        /// Builds the child index on first use after the child list changed
+        [[nodiscard]] bool use_child_index() const {
+             if (children.size() < spatial_index_threshold) {
+                 return false;
+             }
+             if (child_index_stale_) {
+                 child_index_.clear();
+                 for (const auto& child : children) {
+                     child_index_.insert(child->slot_, child->bounds);
+                 }
+                 child_index_stale_ = false;
+             }
+             return true;
+         }
+
+        /// Children were added or removed: renumber them and rebuild the index lazily
+        void children_changed() {
+             for (std::size_t i = 0; i < children.size(); ++i) {
+                 children[i]->slot_ = static_cast<std::uint32_t>(i);
+             }
+             child_index_stale_ = true;
+         }
+
+        void child_bounds_changed(const Element& child) const {
+             if (!child_index_stale_ && child.slot_ < children.size() && children[child.slot_].get() == &child) {
+                 child_index_.update(child.slot_, child.bounds);
+             }
+         }
+
+        /// The subtree changed, so this layer and every layer around it must be redrawn
+        void mark_layers_stale() const {
+             layer_.stale_ = true;
+             for (auto p = parent.lock(); p; p = p->parent.lock()) {
+                 p->layer_.stale_ = true;
+             }
+         }
+
     public:
         virtual ~Element() = default;
         virtual void mount(Context* cx) {
@@ -52,18 +139,104 @@ export namespace plastic
         };
         virtual void layout(Context* cx) = 0;
         virtual void paint(Context* cx) const = 0;
+
+        /// @brief Whether paint() records all of its own drawing into cx->batch().
+        /// Other elements draw directly, so the batch is flushed before they paint to keep painter's order.
+        [[nodiscard]] virtual bool paints_into_batch() const { return false; }
+
+        /// @brief Paints the element, through its cached layer when it has one.
+        /// Parents call this for their children rather than paint(), so layered subtrees are
+        /// composited as a single quad until something inside calls invalidate() or the size changes.
+        void composite(Context* cx) const {
+             auto* batch = cx ? cx->batch() : nullptr;
+             if (!layer_.enabled_) {
+                 if (batch && !paints_into_batch()) {
+                     batch->flush();
+                 }
+                 paint(cx);
+                 return;
+             }
+
+             const int width = static_cast<int>(std::ceil(bounds.width()));
+             const int height = static_cast<int>(std::ceil(bounds.height()));
+             if (width <= 0 || height <= 0) {
+                 return;
+             }
+             if (layer_.texture_.id == 0 || layer_.texture_.texture.width != width || layer_.texture_.texture.height != height) {
+                 layer_.release();
+                 layer_.texture_ = LoadRenderTexture(width, height);
+             }
+
+             const Vector2 origin{std::round(bounds.x()), std::round(bounds.y())};
+             if (layer_.stale_) {
+                 // Recorded draws must land on the side of the layer they were issued on
+                 if (batch) {
+                     batch->flush();
+                 }
+                 begin_render_target(layer_.texture_, origin);
+                 ClearBackground({0, 0, 0, 0});
+                 // Blending into a transparent target yields premultiplied colour with correct alpha
+                 rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA,
+                                           RL_FUNC_ADD, RL_FUNC_ADD);
+                 BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+                 paint(cx);
+                 if (batch) {
+                     batch->flush();
+                 }
+                 EndBlendMode();
+                 end_render_target();
+                 layer_.stale_ = false;
+             } else if (batch) {
+                 // The layer quad is drawn directly, on top of everything recorded before it
+                 batch->flush();
+             }
+
+             BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+             DrawTextureRec(layer_.texture_.texture,
+                            {0, 0, static_cast<float>(width), -static_cast<float>(height)},
+                            origin, {255, 255, 255, 255});
+             EndBlendMode();
+         }
+
+        /// @brief Caches this subtree's drawing in an offscreen layer.
+        /// @note Worth it for large, rarely changing subtrees (file tree, tab bar, gutter, status bar)
+        void set_layered(bool layered) {
+             if (layer_.enabled_ == layered) return;
+             layer_.enabled_ = layered;
+             if (!layered) {
+                 layer_.release();
+             }
+             invalidate_paint();
+         }
+
+        [[nodiscard]] bool is_layered() const {
+             return layer_.enabled_;
+         }
         // virtual void handle_event(Event& event, Context* cx) {};
          void add_child(const std::shared_ptr<Element>& child) {
             child->parent = shared_from_this();
+            child->slot_ = static_cast<std::uint32_t>(children.size());
             this->children.push_back(child);
+            child_index_stale_ = true;
         }
 
+        /// @brief Marks the element's area for repaint and asks for a layout pass
         void invalidate() const {
+             mark_layers_stale();
              if (context) {
+                 context->add_damage(bounds);
                  context->request_layout();
              }
          }
 
+        /// @brief Marks the element's area for repaint without relayout, for purely visual changes
+        void invalidate_paint() const {
+             mark_layers_stale();
+             if (context) {
+                 context->add_damage(bounds);
+             }
+         }
+
 
 
 
@@ -78,7 +251,14 @@ export namespace plastic
 
         void set_bounds(const Rect<float>& new_bounds) {
              if (bounds == new_bounds) return;
+             // The area being vacated needs repainting as well
+             if (context) {
+                 context->add_damage(bounds);
+             }
              bounds = new_bounds;
+             if (auto p = parent.lock()) {
+                 p->child_bounds_changed(*this);
+             }
              invalidate();
         }
 
@@ -110,24 +290,139 @@ export namespace plastic
             return style.get_preferred_size();
         }
 
-        // Add to Element class in element.ixx
+        /// @brief The front-most child whose bounds contain `point`, or null
+        [[nodiscard]] std::shared_ptr<Element> child_at(const Point<float>& point) const {
+             if (use_child_index()) {
+                 child_index_.query(point, hits_);
+                 return hits_.empty() ? nullptr : children[hits_.front()];
+             }
+             for (const auto& child : std::ranges::reverse_view(children)) {
+                 if (child->bounds.contains(point)) {
+                     return child;
+                 }
+             }
+             return nullptr;
+         }
+
+        /// @brief Every child whose bounds contain `point`, front-most first
+        void children_at(const Point<float>& point, std::vector<std::shared_ptr<Element>>& out) const {
+             out.clear();
+             if (use_child_index()) {
+                 child_index_.query(point, hits_);
+                 for (const auto i : hits_) {
+                     out.push_back(children[i]);
+                 }
+                 return;
+             }
+             for (const auto& child : std::ranges::reverse_view(children)) {
+                 if (child->bounds.contains(point)) {
+                     out.push_back(child);
+                 }
+             }
+         }
+
+        /// @brief Calls `f` on each child whose bounds intersect `area`, in paint order
+        template <typename F>
+        void for_each_child_in(const Rect<float>& area, F&& f) const {
+             if (!use_child_index()) {
+                 for (const auto& child : children) {
+                     if (child->bounds.intersects(area)) {
+                         f(child);
+                     }
+                 }
+                 return;
+             }
+             // Taken out for the walk so `f` may query this element again
+             auto ids = std::exchange(hits_, {});
+             child_index_.query(area, ids);
+             for (const auto i : ids) {
+                 f(children[i]);
+             }
+             hits_ = std::move(ids);
+         }
+
+        /// @brief Every child whose bounds intersect `area`, in paint order
+        void children_in(const Rect<float>& area, std::vector<std::shared_ptr<Element>>& out) const {
+             out.clear();
+             for_each_child_in(area, [&](const std::shared_ptr<Element>& child) { out.push_back(child); });
+         }
+
+        /// @brief Composites the children that can show through the active clip, in paint order.
+        /// Under damage repaint the clip is the damaged region, so untouched children are skipped;
+        /// @note A child's drawing outside its own bounds is not repainted when only that overflow is damaged
+        void composite_children(Context* cx) const {
+             if (const auto clip = current_scissor()) {
+                 for_each_child_in(Rect<float>::from_rl(*clip), [cx](const std::shared_ptr<Element>& child) {
+                     child->composite(cx);
+                 });
+                 return;
+             }
+             for (const auto& child : children) {
+                 child->composite(cx);
+             }
+         }
+
+        /// @brief Pointer position of mouse events, nothing for every other event
+        [[nodiscard]] static std::optional<Point<float>> pointer_position(const events::Event& event) {
+             return std::visit([](const auto& e) -> std::optional<Point<float>> {
+                 using T = std::decay_t<decltype(e)>;
+                 if constexpr (std::is_same_v<T, events::MouseMoveEvent>) {
+                     return e.position;
+                 } else if constexpr (std::is_same_v<T, events::MouseButtonEvent> || std::is_same_v<T, events::MouseScrollEvent>) {
+                     return Point<float>{e.position.width(), e.position.height()};
+                 } else if constexpr (std::is_same_v<T, events::MouseDragEvent>) {
+                     return Point<float>{e.current.width(), e.current.height()};
+                 } else {
+                     return std::nullopt;
+                 }
+             }, event);
+         }
+
         virtual bool handle_event(const events::Event& event, Context* cx) {
-             // Check if event is within bounds for mouse events
-             if (auto* mouse_event = std::get_if<events::MouseButtonEvent>(&event)) {
-                 Point<float> pos{mouse_event->position.width(), mouse_event->position.height()};
-                 std::cout << "Element: Handling event at " << pos.x << "," << pos.y
-                           << " bounds: " << bounds.x() << "," << bounds.y()
-                           << "," << bounds.width() << "," << bounds.height() << "\n";
-
-                 if (!bounds.contains(pos)) {
-                     std::cout << "Element: Point outside bounds\n";
+             const auto* button = std::get_if<events::MouseButtonEvent>(&event);
+             if (const auto pos = pointer_position(event)) {
+                 if (button && !bounds.contains(*pos)) {
                      return false;
                  }
-             }
-             // Process children in reverse order (front to back)
-             for (auto & it : std::ranges::reverse_view(children)) {
-                 if (it->handle_event(event, cx)) {
-                     return true; // Event was handled by a child
+
+                 // A child that took the press keeps moves and drags, e.g. a scrollbar dragged off its track
+                 const bool follows_press = std::holds_alternative<events::MouseMoveEvent>(event)
+                     || std::holds_alternative<events::MouseDragEvent>(event);
+                 const auto captured = pointer_capture_.lock();
+                 if (captured && follows_press && captured->handle_event(event, cx)) {
+                     return true;
+                 }
+                 if (button && !button->pressed) {
+                     pointer_capture_.reset();
+                 }
+
+                 // Pointer events only reach the children under the pointer, front to back
+                 auto under = std::exchange(under_, {});
+                 children_at(*pos, under);
+                 bool handled = false;
+                 for (const auto& it : under) {
+                     if (it == captured && follows_press) {
+                         continue;
+                     }
+                     if (it->handle_event(event, cx)) {
+                         if (button && button->pressed) {
+                             pointer_capture_ = it;
+                         }
+                         handled = true;
+                         break;
+                     }
+                 }
+                 under.clear();
+                 under_ = std::move(under);
+                 if (handled) {
+                     return true;
+                 }
+             } else {
+                 // Process children in reverse order (front to back)
+                 for (auto & it : std::ranges::reverse_view(children)) {
+                     if (it->handle_event(event, cx)) {
+                         return true; // Event was handled by a child
+                     }
                  }
              }
 
@@ -161,6 +456,7 @@ export namespace plastic
                            [&child](const std::shared_ptr<Element>& e) {
                                return e == child;
                            });
+             children_changed();
 
              // Notify the element it's been detached if needed
              if (context) {
@@ -173,7 +469,9 @@ export namespace plastic
 
         void add(const std::shared_ptr<Element>& child) {
              child->parent = shared_from_this();
+             child->slot_ = static_cast<std::uint32_t>(children.size());
              children.push_back(child);
+             child_index_stale_ = true;
 
              // If we're already mounted, mount the child too
              if (context) {
@@ -196,6 +494,7 @@ export namespace plastic
 
                  // Remove from children vector
                  children.erase(it);
+                 children_changed();
 
                  invalidate();
              }
@@ -211,6 +510,7 @@ export namespace plastic
              }
 
              children.clear();
+             children_changed();
              invalidate();
          }
 
@@ -241,17 +541,11 @@ export namespace plastic
                  return true;
              }
 
-             // For mouse events, only propagate to children that contain the point
-             if (auto* mouse_event = std::get_if<events::MouseButtonEvent>(&event)) {
-                 Point<float> point{mouse_event->position.width(), mouse_event->position.height()};
-
-                 // Check children in reverse (front to back) order
-                 for (auto & it : std::ranges::reverse_view(children)) {
-                     if (it->get_bounds().contains(point)) {
-                         if (it->propagate_event(event, cx)) {
-                             return true;
-                         }
-                         break; // Only propagate to first containing child
+             // For mouse events, only propagate to the front-most child that contains the point
+             if (const auto point = pointer_position(event)) {
+                 if (auto hit = child_at(*point)) {
+                     if (hit->propagate_event(event, cx)) {
+                         return true;
                      }
                  }
              } else {
@@ -277,7 +571,7 @@ export namespace plastic
              // For keyboard events, follow the focus chain
              bool has_focused_child = false;
              for (const auto& child : children) {
-                 if (child->has_property("focused") && std::any_cast<bool>(child->get_property("focused"))) {
+                 if (child->is_focused()) {
                      child->build_focus_path(event, path);
                      has_focused_child = true;
                      break;
@@ -285,7 +579,7 @@ export namespace plastic
              }
 
              // If no focused child and this element itself is focused, stop here
-             if (!has_focused_child && has_property("focused") && std::any_cast<bool>(get_property("focused"))) {
+             if (!has_focused_child && is_focused()) {
                  return;
              }
          }
@@ -294,30 +588,16 @@ export namespace plastic
              path.push_back(shared_from_this());
 
              // Extract position from event
-             Point<float> position;
-             std::visit([&position](const auto& e) {
-                 using T = std::decay_t<decltype(e)>;
-                 if constexpr (std::is_same_v<T, events::MouseButtonEvent>) {
-                     position = Point<float>{e.position.width(), e.position.height()};
-                 } else if constexpr (std::is_same_v<T, events::MouseMoveEvent>) {
-                     position = e.position;
-                 } else if constexpr (std::is_same_v<T, events::MouseScrollEvent>) {
-                     position = Point<float>{e.position.width(), e.position.height()};
-                 }
-             }, event);
+             const Point<float> position = pointer_position(event).value_or(Point<float>{});
 
              // If point is outside bounds, don't check children
              if (!bounds.contains(position)) {
                  return;
              }
 
-             // Find the child that contains the point (in reverse order - front to back)
-             for (auto & it : std::ranges::reverse_view(children)) {
-                 if (it->get_bounds().contains(position)) {
-                     // Recursively build the path through this child
-                     it->build_hit_test_path(event, path);
-                     break;
-                 }
+             // Recursively build the path through the front-most child under the point
+             if (auto hit = child_at(position)) {
+                 hit->build_hit_test_path(event, path);
              }
          }
 
@@ -338,53 +618,86 @@ export namespace plastic
                     return;
                 }
 
-                // Check children in reverse (front to back) order
-                const auto& children = element->get_children();
-                for (const auto & it : std::ranges::reverse_view(children)) {
-                    if (it->get_bounds().contains(point)) {
-                        find_event_path(it, point, path);
-                        break;
-                    }
+                // Continue through the front-most child under the point
+                if (auto hit = element->child_at(point)) {
+                    find_event_path(hit, point, path);
                 }
             }
+        /// @brief Whether every bit of `state` is set
+        [[nodiscard]] bool has_state(ElementState state) const {
+             return (states_ & state) == state;
+         }
+
+        void set_state(ElementState state, bool on) {
+             states_ = on ? (states_ | state) : (states_ & ~state);
+         }
+
+        [[nodiscard]] ElementState states() const {
+             return states_;
+         }
+
+        /// @brief Typed property access; the key is interned once, so lookups compare integers
+        template <typename T>
+        void set(const Property<T>& property, T value) {
+             properties_.set(property, std::move(value));
+         }
+
+        template <typename T>
+        [[nodiscard]] std::optional<T> get(const Property<T>& property) const {
+             return properties_.get(property);
+         }
+
+        template <typename T>
+        [[nodiscard]] T get_or(const Property<T>& property, T fallback) const {
+             return properties_.get(property).value_or(std::move(fallback));
+         }
+
+        /// @brief String-keyed access, kept for existing callers; setting interns `key`, reading only looks it up.
+        /// State names ("focused", "hovered", ...) with bool values map onto the state bits.
         void set_property(const std::string& key, std::any value) {
-             properties_[key] = std::move(value);
+             if (const auto state = state_named(key); state != ElementState::None) {
+                 if (const bool* on = std::any_cast<bool>(&value)) {
+                     set_state(state, *on);
+                     return;
+                 }
+             }
+             properties_.set_any(PropertyKey::intern(key), std::move(value));
          }
 
         std::any get_property(const std::string& key) const {
-             auto it = properties_.find(key);
-             if (it != properties_.end()) {
-                 return it->second;
+             if (const auto interned = PropertyKey::find(key); interned && properties_.contains(*interned)) {
+                 return properties_.get_any(*interned);
+             }
+             if (const auto state = state_named(key); state != ElementState::None) {
+                 return has_state(state);
              }
              return {};
          }
 
+        /// @brief Whether `key` is stored, or names a state bit that is set
         bool has_property(const std::string& key) const {
-             return properties_.contains(key);
+             if (const auto state = state_named(key); state != ElementState::None && has_state(state)) {
+                 return true;
+             }
+             const auto interned = PropertyKey::find(key);
+             return interned && properties_.contains(*interned);
          }
 
-        const std::unordered_map<std::string, std::any>* get_properties() const {
+        const PropertyMap* get_properties() const {
              return &properties_;
          }
 
         // Helper for focusability
         void set_focusable(bool focusable) {
-             set_property("focusable", focusable);
+             set_state(ElementState::Focusable, focusable);
          }
 
         bool is_focusable() const {
-             if (has_property("focusable")) {
-                 try {
-                     return std::any_cast<bool>(get_property("focusable"));
-                 } catch (const std::bad_any_cast&) {
-                     return false;
-                 }
-             }
-             return false;
+             return has_state(ElementState::Focusable);
          }
 
         virtual void set_focused(bool focused) {
-             set_property("focused", focused);
+             set_state(ElementState::Focused, focused);
              invalidate(); // Redraw the component when focus changes
 
              // Notify parent of focus change
@@ -395,14 +708,7 @@ export namespace plastic
          }
 
         bool is_focused() const {
-             if (has_property("focused")) {
-                 try {
-                     return std::any_cast<bool>(get_property("focused"));
-                 } catch (const std::bad_any_cast&) {
-                     return false;
-                 }
-             }
-             return false;
+             return has_state(ElementState::Focused);
          }
 
         // Method for parent containers to handle when a child's focus changes
@@ -10,6 +10,9 @@ module;
 #include <queue>
 #include <mutex>
 #include <functional>
+#include <chrono>
+#include <optional>
+#include <algorithm>
 #if defined(__APPLE__)
 #define PLASTIC_PLATFORM_MACOS (TARGET_OS_MAC && !TARGET_OS_IOS && !TARGET_OS_TV && !TARGET_OS_WATCH)
 #define PLASTIC_OS_NAME "macOS"
@@ -68,6 +71,11 @@ export namespace plastic
 
         World world_{}; // Entity Component System
 
+    private:
+        std::mutex posted_mutex_;
+        std::vector<std::function<void()>> posted_{};
+        std::optional<std::chrono::steady_clock::time_point> deadline_{};
+
     public:
         explicit Platform(std::shared_ptr<context::AppContext> app_context)
             : app_context_(std::move(app_context)) {}
@@ -120,6 +128,60 @@ export namespace plastic
         virtual float get_primary_display_height() const = 0;
         virtual void dispatch_event(const events::Event& event) {};
 
+        void post(std::function<void()> task) override {
+            {
+                std::lock_guard<std::mutex> lock(posted_mutex_);
+                posted_.push_back(std::move(task));
+            }
+            wake();
+        }
+
+        /// @brief Queues `event` for the next update and wakes the loop; safe to call from any thread
+        void post_event(events::Event event) {
+            event_handler_.queue_event(std::move(event));
+            wake();
+        }
+
+        void wake_after(double seconds) override {
+            const auto when = std::chrono::steady_clock::now()
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+            std::lock_guard<std::mutex> lock(posted_mutex_);
+            if (!deadline_ || when < *deadline_) {
+                deadline_ = when;
+            }
+        }
+
+        /// @brief Runs the tasks posted since the last call, in order
+        /// @return Whether any ran, in which case the next frame should not wait
+        bool run_posted() {
+            std::vector<std::function<void()>> tasks;
+            {
+                std::lock_guard<std::mutex> lock(posted_mutex_);
+                tasks.swap(posted_);
+            }
+            for (auto& task : tasks) {
+                task();
+            }
+            return !tasks.empty();
+        }
+
+        /// @brief How long an idle loop may block: until the earliest wake_after() deadline, at most `limit`
+        double idle_timeout(double limit) {
+            std::lock_guard<std::mutex> lock(posted_mutex_);
+            if (!posted_.empty()) {
+                return 0.0;
+            }
+            if (!deadline_) {
+                return limit;
+            }
+            const double remaining = std::chrono::duration<double>(*deadline_ - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0.0) {
+                deadline_.reset();
+                return 0.0;
+            }
+            return std::min(remaining, limit);
+        }
+
     protected:
         class EventHandler {
             std::unordered_map<std::type_index, std::vector<std::function<void(const events::Event&)>>> handlers_;
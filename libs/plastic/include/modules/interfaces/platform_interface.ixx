@@ -4,6 +4,7 @@
 
 
 module;
+#include <functional>
 export module plastic.platform_interface;
 
 import plastic.events;
@@ -16,5 +17,17 @@ export namespace plastic {
         virtual void update() = 0;
         virtual void dispatch_event(const events::Event& event) = 0;
 
+        /// @brief Blocks until input arrives, wake() is called, or `timeout` seconds pass
+        virtual void wait_events(double timeout) {}
+
+        /// @brief Interrupts wait_events(); safe to call from any thread
+        virtual void wake() {}
+
+        /// @brief Runs `task` on the main loop's thread and wakes the loop; safe to call from any thread
+        virtual void post(std::function<void()> task) = 0;
+
+        /// @brief Makes sure the loop wakes within `seconds`, for timers that must fire while idle
+        virtual void wake_after(double seconds) = 0;
+
     };
 }
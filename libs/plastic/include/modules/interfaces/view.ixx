@@ -89,6 +89,7 @@ export namespace plastic
             needs_layout_ = true;
             if (cx_) {
                 cx_->request_layout();
+                cx_->request_paint();
             }
         }
 
@@ -3,50 +3,217 @@
 //
 
 module;
-
-#if defined(_WIN32)
-#include <bits/stdc++.h>
-#elif defined(__APPLE__)
-#include <__algorithm/ranges_max.h>
-#include <__algorithm/ranges_min.h>
-#endif
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 #include <raylib.h>
+#include <rlgl.h>
 export module plastic.optimized_renderer;
-import plastic.element;
-import plastic.context;
 import plastic.rect;
+import plastic.size;
+import plastic.color;
+import plastic.render_state;
 
 export namespace plastic
 {
-    bool needs_redraw{false};
-    Rect<float> dirty_region;
-
-    void mark_dirty(const Rect<float>& region) {
-        if (!needs_redraw) {
-            dirty_region = region;
-        } else {
-            // Union operation to expand dirty region
-            float x1 = std::ranges::min(dirty_region.x(), region.x());
-            float y1 = std::ranges::min(dirty_region.y(), region.y());
-            float x2 = std::ranges::max(dirty_region.x() + dirty_region.width(), region.x() + region.width());
-            float y2 = std::ranges::max(dirty_region.y() + dirty_region.height(), region.y() + region.height());
-            dirty_region = Rect<float>(x1, y1, x2, y2);
-        }
-        needs_redraw = true;
-    }
-
-    void render(const Element& element, Context* cx) {
-        if (!needs_redraw) return;
-
-        BeginScissorMode(
-            static_cast<int>(dirty_region.x()),
-            static_cast<int>(dirty_region.y()),
-            static_cast<int>(dirty_region.width()),
-            static_cast<int>(dirty_region.height())
-            );
-        element.paint(cx);
-        EndScissorMode();
-        needs_redraw = false;
-
-    }
+    /// @brief Screen areas that changed since the last repaint, kept as a few merged rectangles.
+    ///
+    /// Regions are snapped outward to whole pixels. A region that overlaps or touches one already
+    /// recorded is folded into it; past `max_regions` the pair whose union wastes the least area
+    /// is merged, so the set stays small however many elements invalidate in a frame.
+    class DamageTracker {
+        std::vector<Rect<float>> regions_{};
+        std::size_t max_regions_;
+        bool full_{false};
+
+        static float right(const Rect<float>& r) { return r.x() + r.width(); }
+        static float bottom(const Rect<float>& r) { return r.y() + r.height(); }
+        static float area(const Rect<float>& r) { return r.width() * r.height(); }
+
+        static Rect<float> unite(const Rect<float>& a, const Rect<float>& b) {
+            const float x1 = std::min(a.x(), b.x());
+            const float y1 = std::min(a.y(), b.y());
+            const float x2 = std::max(right(a), right(b));
+            const float y2 = std::max(bottom(a), bottom(b));
+            return Rect<float>(x1, y1, x2 - x1, y2 - y1);
+        }
+
+        /// Overlapping or sharing an edge: cheaper to repaint as one region
+        static bool touches(const Rect<float>& a, const Rect<float>& b) {
+            return a.x() <= right(b) && b.x() <= right(a) && a.y() <= bottom(b) && b.y() <= bottom(a);
+        }
+
+        static Rect<float> snap(const Rect<float>& r) {
+            const float x1 = std::floor(r.x());
+            const float y1 = std::floor(r.y());
+            return Rect<float>(x1, y1, std::ceil(right(r)) - x1, std::ceil(bottom(r)) - y1);
+        }
+
+        void merge_cheapest_pair() {
+            std::size_t best_i = 0;
+            std::size_t best_j = 1;
+            float best_waste = std::numeric_limits<float>::max();
+            for (std::size_t i = 0; i < regions_.size(); ++i) {
+                for (std::size_t j = i + 1; j < regions_.size(); ++j) {
+                    const float waste = area(unite(regions_[i], regions_[j])) - area(regions_[i]) - area(regions_[j]);
+                    if (waste < best_waste) {
+                        best_waste = waste;
+                        best_i = i;
+                        best_j = j;
+                    }
+                }
+            }
+            Rect<float> merged = unite(regions_[best_i], regions_[best_j]);
+            regions_.erase(regions_.begin() + static_cast<std::ptrdiff_t>(best_j));
+            regions_.erase(regions_.begin() + static_cast<std::ptrdiff_t>(best_i));
+            add(merged);
+        }
+
+    public:
+        explicit DamageTracker(std::size_t max_regions = 8) : max_regions_(std::max<std::size_t>(max_regions, 1)) {}
+
+        void add(const Rect<float>& region) {
+            if (full_ || region.width() <= 0 || region.height() <= 0) {
+                return;
+            }
+
+            // Absorb every region the new one touches, repeating as it grows
+            Rect<float> merged = snap(region);
+            for (bool grew = true; grew;) {
+                grew = false;
+                for (auto it = regions_.begin(); it != regions_.end(); ++it) {
+                    if (touches(*it, merged)) {
+                        merged = unite(*it, merged);
+                        regions_.erase(it);
+                        grew = true;
+                        break;
+                    }
+                }
+            }
+            regions_.push_back(merged);
+
+            if (regions_.size() > max_regions_) {
+                merge_cheapest_pair();
+            }
+        }
+
+        /// @brief Damages everything, e.g. after a resize or when a view rebuilt its element tree
+        void add_all() {
+            full_ = true;
+            regions_.clear();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return !full_ && regions_.empty();
+        }
+
+        [[nodiscard]] bool full() const {
+            return full_;
+        }
+
+        /// @brief The regions to repaint, clipped to `screen`
+        /// @note Collapses to the whole screen once the regions cover more than half of it
+        [[nodiscard]] std::vector<Rect<float>> regions(const Size<float>& screen) const {
+            const Rect<float> whole(0, 0, screen.width(), screen.height());
+            if (full_) {
+                return {whole};
+            }
+
+            std::vector<Rect<float>> clipped;
+            clipped.reserve(regions_.size());
+            float covered = 0;
+            for (const auto& r : regions_) {
+                const float x1 = std::max(r.x(), 0.0f);
+                const float y1 = std::max(r.y(), 0.0f);
+                const float x2 = std::min(right(r), screen.width());
+                const float y2 = std::min(bottom(r), screen.height());
+                if (x2 > x1 && y2 > y1) {
+                    clipped.emplace_back(x1, y1, x2 - x1, y2 - y1);
+                    covered += (x2 - x1) * (y2 - y1);
+                }
+            }
+            if (covered * 2 > area(whole)) {
+                return {whole};
+            }
+            return clipped;
+        }
+
+        void clear() {
+            regions_.clear();
+            full_ = false;
+        }
+    };
+
+    /// @brief Persistent back buffer that is repainted only where damaged.
+    ///
+    /// Each frame the damaged regions are cleared and repainted under a scissor into an
+    /// offscreen target, then the whole target is copied to the screen. Frames without damage
+    /// cost a single textured quad, so a blinking cursor repaints a few pixels, not the window.
+    class DamageRenderer {
+        RenderTexture2D target_{};
+        Color background_;
+
+    public:
+        explicit DamageRenderer(const Color& background = Color::rgb(30, 30, 30)) : background_(background) {}
+
+        DamageRenderer(const DamageRenderer&) = delete;
+        DamageRenderer& operator=(const DamageRenderer&) = delete;
+
+        ~DamageRenderer() {
+            if (target_.id != 0) {
+                UnloadRenderTexture(target_);
+            }
+        }
+
+        void set_background(const Color& background) {
+            background_ = background;
+        }
+
+        /// @brief Repaints the damaged regions into the back buffer and clears `damage`
+        /// @param paint Called once per region with the scissor already set; draws in screen coordinates.
+        /// It should skip whatever lies outside the region it is given: the scissor discards those
+        /// pixels, but not the work. current_scissor() is the region, so composite_children() culls by it.
+        /// @return Whether anything was repainted
+        template <typename F>
+        bool repaint(DamageTracker& damage, const Size<float>& screen, F&& paint) {
+            const int width = std::max(1, static_cast<int>(screen.width()));
+            const int height = std::max(1, static_cast<int>(screen.height()));
+            if (target_.id == 0 || target_.texture.width != width || target_.texture.height != height) {
+                if (target_.id != 0) {
+                    UnloadRenderTexture(target_);
+                }
+                target_ = LoadRenderTexture(width, height);
+                damage.add_all();
+            }
+            if (damage.empty()) {
+                return false;
+            }
+
+            begin_render_target(target_);
+            for (const auto& region : damage.regions(screen)) {
+                region.apply_scissor();
+                ClearBackground(background_.rl());
+                paint(region);
+                Rect<float>::stop_scissor();
+            }
+            end_render_target();
+            damage.clear();
+            return true;
+        }
+
+        /// @brief Copies the back buffer to the screen; call between BeginDrawing and EndDrawing
+        void present() const {
+            if (target_.id == 0) {
+                return;
+            }
+            // Straight copy: blending would apply the target's accumulated alpha a second time
+            rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM);
+            DrawTextureRec(target_.texture,
+                           {0, 0, static_cast<float>(target_.texture.width), -static_cast<float>(target_.texture.height)},
+                           {0, 0}, ::Color{255, 255, 255, 255});
+            EndBlendMode();
+        }
+    };
 }
@@ -12,6 +12,7 @@ export import plastic.edge;
 export import plastic.style;
 export import plastic.context;
 export import plastic.element;
+export import plastic.property;
 export import plastic.model;
 export import plastic.view;
 export import plastic.window;
@@ -36,12 +37,21 @@ export import plastic.theme;
 export import plastic.text.fmt;
 export import plastic.rich_text;
 export import plastic.object_pool;
+export import plastic.element_pool;
+export import plastic.element_arena;
 export import plastic.ui;
 export import plastic.view_context;
 export import plastic.components;
 export import plastic.element_builder;
 export import plastic.font;
+export import plastic.glyph_run;
 export import plastic.font_registry;
+export import plastic.glyph_atlas;
+export import plastic.sdf_font;
+export import plastic.render_batch;
+export import plastic.optimized_renderer;
+export import plastic.render_state;
+export import plastic.spatial_index;
 export import plastic.elements.basic;
 export import plastic.elements.containers;
 export import plastic.elements.styled_text;
@@ -3,78 +3,304 @@
 //
 
 module;
-#include <memory>
-#include <vector>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <string_view>
+#include <type_traits>
 #include <variant>
+#include <vector>
 #include <raylib.h>
-export module render_batch;
+#include <rlgl.h>
+export module plastic.render_batch;
 
 import plastic.rect;
+import plastic.color;
+import plastic.point;
+import plastic.font;
+import plastic.render_state;
 
 export namespace plastic
 {
+    /// @brief Retained draw list, replayed once per frame in as few rlgl draw calls as possible.
+    ///
+    /// Commands are recorded in painter's order. On flush they are grouped by layer, then by
+    /// texture: a command moves back to join an earlier run with the same texture only when it
+    /// overlaps nothing drawn in between, so the picture is identical to drawing in order.
+    /// Each command keeps the scissor that was active when it was recorded and is replayed under
+    /// it; commands under different clips never share a run.
+    /// Anything drawn directly must flush the batch first, or it ends up beneath recorded commands;
+    /// Element::composite() does this for elements that do not paint into the batch.
+    /// Rectangles and lines are emitted as quads on raylib's shapes texture, which is also the
+    /// default font's texture, so UI chrome and default-font text share draw calls.
+    /// Text is copied into a frame arena; every buffer keeps its capacity between frames.
     class RenderBatch {
+    public:
+        struct Stats {
+            std::size_t commands{0};
+            std::size_t runs{0};    ///< Texture runs after sorting, an upper bound on draw calls
+        };
+
     private:
-        struct DrawCommand {
-            enum Type { Rectangle, Text, Line, Image };
-            Type type;
-            std::variant<
-                std::tuple<Rect<float>, Color>, // Rectangle
-                std::tuple<std::string, Vector2, float, float, Color>, // Text
-                std::tuple<Vector2, Vector2, float, Color>, // Line
-                std::tuple<Texture2D, Rect<float>, Rect<float>, Vector2, float, Color> // Image
-            > params;
+        /// How far back a command looks for a run to join; keeps sorting linear in practice
+        static constexpr std::size_t lookback_ = 32;
+
+        struct RectShape {
+            Rectangle rect;
+        };
+        struct LineShape {
+            Vector2 from;
+            Vector2 to;
+            float thickness;
+        };
+        struct TextShape {
+            ::Font font;
+            std::uint32_t offset;   ///< NUL-terminated text in the arena
+            Vector2 position;
+            float size;
+            float spacing;
         };
+        struct ImageShape {
+            Texture2D texture;
+            Rectangle source;
+            Rectangle dest;
+            Vector2 origin;
+            float rotation;
+        };
+
+        struct Command {
+            int layer;
+            unsigned int texture;
+            Rectangle area;         ///< Conservative bounds, for the overlap test
+            std::optional<Rectangle> clip;  ///< Scissor when recorded, in screen coordinates
+            ::Color color;
+            std::variant<RectShape, LineShape, TextShape, ImageShape> shape;
+        };
+
+        struct Run {
+            unsigned int texture;
+            std::optional<Rectangle> clip;
+            Rectangle area;
+        };
+
+        std::vector<Command> commands_{};
+        std::vector<char> arena_{};
+        std::vector<std::uint32_t> order_{};
+        std::vector<std::uint32_t> run_of_{};
+        std::vector<Run> runs_{};
+        int layer_{0};
+        Stats stats_{};
+
+        static bool overlaps(const Rectangle& a, const Rectangle& b) {
+            return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+        }
+
+        static bool same_clip(const std::optional<Rectangle>& a, const std::optional<Rectangle>& b) {
+            if (!a || !b) {
+                return !a && !b;
+            }
+            return a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height;
+        }
+
+        static Rectangle unite(const Rectangle& a, const Rectangle& b) {
+            const float x0 = std::min(a.x, b.x);
+            const float y0 = std::min(a.y, b.y);
+            const float x1 = std::max(a.x + a.width, b.x + b.width);
+            const float y1 = std::max(a.y + a.height, b.y + b.height);
+            return {x0, y0, x1 - x0, y1 - y0};
+        }
+
+        /// @brief Assigns each command to a run; run ids increase with layer and draw order
+        void build_runs() {
+            const auto count = static_cast<std::uint32_t>(commands_.size());
+            order_.resize(count);
+            std::iota(order_.begin(), order_.end(), 0u);
+            std::ranges::stable_sort(order_, {}, [this](std::uint32_t i) { return commands_[i].layer; });
+
+            run_of_.assign(count, 0);
+            runs_.clear();
+            std::size_t layer_start = 0;
+            for (std::size_t k = 0; k < order_.size(); ++k) {
+                const Command& command = commands_[order_[k]];
+                if (k > 0 && command.layer != commands_[order_[k - 1]].layer) {
+                    layer_start = runs_.size();
+                }
+
+                std::size_t target = runs_.size();
+                const std::size_t stop = std::max(layer_start, runs_.size() > lookback_ ? runs_.size() - lookback_ : 0);
+                for (std::size_t r = runs_.size(); r > stop; --r) {
+                    const Run& run = runs_[r - 1];
+                    if (run.texture == command.texture && same_clip(run.clip, command.clip)) {
+                        target = r - 1;
+                        break;
+                    }
+                    if (overlaps(run.area, command.area)) {
+                        break;
+                    }
+                }
+
+                if (target == runs_.size()) {
+                    runs_.push_back({command.texture, command.clip, command.area});
+                } else {
+                    runs_[target].area = unite(runs_[target].area, command.area);
+                }
+                run_of_[order_[k]] = static_cast<std::uint32_t>(target);
+            }
+            std::ranges::stable_sort(order_, {}, [this](std::uint32_t i) { return run_of_[i]; });
+        }
+
+        static void shape_quad(const Vector2 (&corners)[4], const ::Color& color) {
+            const Texture2D shapes = GetShapesTexture();
+            const Rectangle source = GetShapesTextureRectangle();
+            const float u = (source.x + source.width / 2.0f) / static_cast<float>(shapes.width);
+            const float v = (source.y + source.height / 2.0f) / static_cast<float>(shapes.height);
 
-        std::vector<DrawCommand> commands;
+            rlSetTexture(shapes.id);
+            rlBegin(RL_QUADS);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+            rlColor4ub(color.r, color.g, color.b, color.a);
+            for (const auto& corner : corners) {
+                rlTexCoord2f(u, v);
+                rlVertex2f(corner.x, corner.y);
+            }
+            rlEnd();
+            rlSetTexture(0);
+        }
+
+        void execute(const Command& command) const {
+            std::visit([&]<typename T>(const T& shape) {
+                if constexpr (std::is_same_v<T, RectShape>) {
+                    const Rectangle& r = shape.rect;
+                    shape_quad({{r.x, r.y}, {r.x, r.y + r.height}, {r.x + r.width, r.y + r.height}, {r.x + r.width, r.y}},
+                               command.color);
+                } else if constexpr (std::is_same_v<T, LineShape>) {
+                    const float dx = shape.to.x - shape.from.x;
+                    const float dy = shape.to.y - shape.from.y;
+                    const float length = std::sqrt(dx * dx + dy * dy);
+                    if (length <= 0.0f) {
+                        return;
+                    }
+                    const float nx = -dy / length * shape.thickness / 2.0f;
+                    const float ny = dx / length * shape.thickness / 2.0f;
+                    shape_quad({
+                        {shape.from.x + nx, shape.from.y + ny}, {shape.from.x - nx, shape.from.y - ny},
+                        {shape.to.x - nx, shape.to.y - ny}, {shape.to.x + nx, shape.to.y + ny}
+                    }, command.color);
+                } else if constexpr (std::is_same_v<T, TextShape>) {
+                    DrawTextEx(shape.font, arena_.data() + shape.offset, shape.position, shape.size, shape.spacing, command.color);
+                } else {
+                    DrawTexturePro(shape.texture, shape.source, shape.dest, shape.origin, shape.rotation, command.color);
+                }
+            }, command.shape);
+        }
 
     public:
+        /// @brief Commands recorded after this go to `layer`; higher layers draw on top of
+        /// lower ones recorded since the last flush
+        void set_layer(int layer) {
+            layer_ = layer;
+        }
+
+        [[nodiscard]] int layer() const {
+            return layer_;
+        }
+
         void draw_rectangle(const Rect<float>& rect, const Color& color) {
-            commands.push_back({
-                DrawCommand::Rectangle,
-                std::make_tuple(rect, color)
-            });
+            const Rectangle r = rect.to_rl();
+            commands_.push_back({layer_, GetShapesTexture().id, r, current_scissor(), color.rl(), RectShape{r}});
+        }
+
+        void draw_line(const Point<float>& from, const Point<float>& to, float thickness, const Color& color) {
+            const float pad = thickness / 2.0f;
+            const Rectangle area{
+                std::min(from.x, to.x) - pad, std::min(from.y, to.y) - pad,
+                std::abs(to.x - from.x) + thickness, std::abs(to.y - from.y) + thickness
+            };
+            commands_.push_back({layer_, GetShapesTexture().id, area, current_scissor(), color.rl(),
+                                 LineShape{{from.x, from.y}, {to.x, to.y}, thickness}});
         }
 
-        void draw_text(const std::string& text, Vector2 pos,
+        void draw_text(const Font& font, std::string_view text, const Point<float>& position,
                        float font_size, float spacing, const Color& color) {
-            commands.push_back({
-                DrawCommand::Text,
-                std::make_tuple(text, pos, font_size, spacing, color)
-            });
+            const auto offset = static_cast<std::uint32_t>(arena_.size());
+            arena_.insert(arena_.end(), text.begin(), text.end());
+            arena_.push_back('\0');
+
+            const Vector2 size = measure_text_cached(font.font_, arena_.data() + offset, font_size, spacing);
+            commands_.push_back({layer_, font.font_.texture.id, {position.x, position.y, size.x, size.y}, current_scissor(), color.rl(),
+                                 TextShape{font.font_, offset, {position.x, position.y}, font_size, spacing}});
+        }
+
+        /// @brief Text in raylib's default font
+        void draw_text(std::string_view text, Vector2 position, float font_size, float spacing, const Color& color) {
+            draw_text(Font{GetFontDefault()}, text, {position.x, position.y}, font_size, spacing, color);
         }
 
-        // TODO - Add other drawing methods
+        void draw_texture(const Texture2D& texture, const Rect<float>& source, const Rect<float>& dest,
+                          Vector2 origin, float rotation, const Color& tint) {
+            Rectangle area = dest.to_rl();
+            if (rotation != 0.0f) {
+                // Any rotation stays inside the circle through the farthest corner
+                const float reach = std::sqrt(area.width * area.width + area.height * area.height);
+                area = {area.x - reach, area.y - reach, 2.0f * reach, 2.0f * reach};
+            } else {
+                area.x -= origin.x;
+                area.y -= origin.y;
+            }
+            commands_.push_back({layer_, texture.id, area, current_scissor(), tint.rl(),
+                                 ImageShape{texture, source.to_rl(), dest.to_rl(), origin, rotation}});
+        }
 
+        /// @brief Replays the recorded commands grouped by layer and texture, then clears them.
+        /// Flushing an empty batch is free, so callers may flush whenever they are unsure.
         void flush() {
-            // Sort commands by type for better performance
-            std::ranges::sort(commands,
-                              [](const DrawCommand& a, const DrawCommand& b) {
-                                  return a.type < b.type;
-                              });
-
-            // Execute all batched commands
-            for (const auto& cmd : commands) {
-                switch (cmd.type) {
-                    case DrawCommand::Rectangle: {
-                        auto [rect, color] = std::get<0>(cmd.params);
-                        DrawRectangleRec(rect.to_rl(), color);
-                        break;
+            if (commands_.empty()) {
+                return;
+            }
+            build_runs();
+            stats_ = {commands_.size(), runs_.size()};
+            rlCheckRenderBatchLimit(static_cast<int>(commands_.size()) * 4);
+
+            // Recorded clips are replayed inside whatever clip is active now
+            const std::optional<Rectangle> outer = current_scissor();
+            std::optional<Rectangle> applied = outer;
+            for (const std::uint32_t i : order_) {
+                const Command& command = commands_[i];
+                if (!same_clip(applied, command.clip)) {
+                    if (!same_clip(applied, outer)) {
+                        pop_scissor();
                     }
-                    case DrawCommand::Text: {
-                        auto [text, pos, font_size, spacing, color] =
-                            std::get<1>(cmd.params);
-                        DrawTextEx(GetFontDefault(), text.c_str(),
-                                  pos, font_size, spacing, color);
-                        break;
+                    if (command.clip && !same_clip(command.clip, outer)) {
+                        push_scissor(*command.clip);
                     }
-                    default: ;
-                    // Handle other types
+                    applied = command.clip ? command.clip : outer;
                 }
+                execute(command);
+            }
+            if (!same_clip(applied, outer)) {
+                pop_scissor();
             }
+            // The layer stays set: flushes also happen mid-frame, before direct draws
+            commands_.clear();
+            arena_.clear();
+        }
+
+        /// @brief Drops recorded commands without drawing them
+        void clear() {
+            commands_.clear();
+            arena_.clear();
+            layer_ = 0;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return commands_.size();
+        }
 
-            commands.clear();
+        /// @brief Counts from the last flush
+        [[nodiscard]] Stats stats() const {
+            return stats_;
         }
     };
-}
\ No newline at end of file
+}
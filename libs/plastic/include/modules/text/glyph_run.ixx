@@ -0,0 +1,161 @@
+//
+// Cached glyph geometry for text that is drawn every frame.
+//
+module;
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <raylib.h>
+#include <rlgl.h>
+export module plastic.glyph_run;
+
+import plastic.font;
+import plastic.glyph_atlas;
+import plastic.color;
+import plastic.point;
+
+export namespace plastic
+{
+    /// @brief Positioned glyph quads for one run of text, ready to submit to the rlgl batch.
+    ///
+    /// Building a run decodes the UTF-8 and looks up every glyph once, the way DrawTextEx does.
+    /// Drawing it again only offsets the cached quads by the origin, so text that did not change
+    /// costs four vertices per glyph and no decoding.
+    struct GlyphRun {
+        /// @brief Identifies what a run was built from; a run is reused while its key matches
+        struct Key {
+            std::uint64_t version{0};   ///< Owner's version of the text, bumped on every change
+            std::uint64_t font{0};      ///< Font texture id, or GlyphAtlas::stamp()
+            float size{0.0f};
+            float spacing{0.0f};
+            std::size_t first{0};       ///< Sub-range of the text the run covers
+            std::size_t last{0};
+
+            bool operator==(const Key&) const = default;
+        };
+
+        struct Quad {
+            float x0, y0, x1, y1;       ///< Offsets from the run origin
+            float u0, v0, u1, v1;       ///< Texture coordinates in the font atlas
+            unsigned int texture;
+        };
+
+        Key key{};
+        std::vector<Quad> quads{};
+        float width{0.0f};
+        bool built{false};
+
+        [[nodiscard]] bool matches(const Key& other) const {
+            return built && key == other;
+        }
+
+        /// @brief Lays out `text` the way DrawTextEx would at the origin.
+        void build(const Font& font, std::string_view text, float font_size, float spacing, const Key& new_key) {
+            const ::Font& rl = font.font_;
+            quads.clear();
+            key = new_key;
+            width = 0.0f;
+            built = true;
+            if (rl.texture.id == 0 || rl.baseSize == 0) {
+                return;
+            }
+
+            const float scale = font_size / static_cast<float>(rl.baseSize);
+            const auto padding = static_cast<float>(rl.glyphPadding);
+            const auto tex_width = static_cast<float>(rl.texture.width);
+            const auto tex_height = static_cast<float>(rl.texture.height);
+            quads.reserve(text.size());
+
+            // GetCodepointNext wants a NUL-terminated string; copy short views into a stack buffer
+            for (std::size_t i = 0; i < text.size();) {
+                int bytes = 1;
+                char buffer[5] = {};
+                for (std::size_t j = 0; j < 4 && i + j < text.size(); ++j) {
+                    buffer[j] = text[i + j];
+                }
+                const int codepoint = GetCodepointNext(buffer, &bytes);
+                const int index = GetGlyphIndex(rl, codepoint);
+                const Rectangle& rec = rl.recs[index];
+                const GlyphInfo& glyph = rl.glyphs[index];
+
+                if (codepoint != ' ' && codepoint != '\t') {
+                    const float x = width + (static_cast<float>(glyph.offsetX) - padding) * scale;
+                    const float y = (static_cast<float>(glyph.offsetY) - padding) * scale;
+                    quads.push_back({
+                        x, y,
+                        x + (rec.width + 2.0f * padding) * scale, y + (rec.height + 2.0f * padding) * scale,
+                        (rec.x - padding) / tex_width, (rec.y - padding) / tex_height,
+                        (rec.x + rec.width + padding) / tex_width, (rec.y + rec.height + padding) / tex_height,
+                        rl.texture.id
+                    });
+                }
+
+                width += (glyph.advanceX == 0 ? rec.width : static_cast<float>(glyph.advanceX)) * scale + spacing;
+                i += static_cast<std::size_t>(bytes > 0 ? bytes : 1);
+            }
+        }
+
+        /// @brief Lays out `text` from an on-demand atlas; glyphs may span several atlas pages.
+        /// The key's `font` should be the atlas stamp, so evictions invalidate the run.
+        void build(GlyphAtlas& atlas, std::string_view text, float font_size, float spacing, const Key& new_key) {
+            quads.clear();
+            key = new_key;
+            width = 0.0f;
+            built = true;
+
+            const float scale = font_size / static_cast<float>(atlas.pixel_size());
+            const auto& glyphs = atlas.resolve(text);
+            quads.reserve(glyphs.size());
+            for (const auto& glyph : glyphs) {
+                if (glyph.page >= 0) {
+                    const Texture2D& page = atlas.page_texture(glyph.page);
+                    const auto page_width = static_cast<float>(page.width);
+                    const auto page_height = static_cast<float>(page.height);
+                    const float x = width + glyph.offset_x * scale;
+                    const float y = glyph.offset_y * scale;
+                    quads.push_back({
+                        x, y, x + glyph.rec.width * scale, y + glyph.rec.height * scale,
+                        glyph.rec.x / page_width, glyph.rec.y / page_height,
+                        (glyph.rec.x + glyph.rec.width) / page_width, (glyph.rec.y + glyph.rec.height) / page_height,
+                        page.id
+                    });
+                }
+                width += glyph.advance * scale + spacing;
+            }
+        }
+
+        /// @brief Submits the cached quads translated to `origin`.
+        void draw(const Point<float>& origin, const Color& color) const {
+            if (quads.empty()) {
+                return;
+            }
+            rlCheckRenderBatchLimit(static_cast<int>(quads.size()) * 4);
+            unsigned int texture = quads.front().texture;
+            rlSetTexture(texture);
+            rlBegin(RL_QUADS);
+            rlColor4ub(color.r, color.g, color.b, color.a);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+            for (const auto& q : quads) {
+                if (q.texture != texture) {
+                    // Atlas pages are separate textures; runs usually stay on one
+                    rlEnd();
+                    texture = q.texture;
+                    rlSetTexture(texture);
+                    rlBegin(RL_QUADS);
+                    rlColor4ub(color.r, color.g, color.b, color.a);
+                    rlNormal3f(0.0f, 0.0f, 1.0f);
+                }
+                rlTexCoord2f(q.u0, q.v0);
+                rlVertex2f(origin.x + q.x0, origin.y + q.y0);
+                rlTexCoord2f(q.u0, q.v1);
+                rlVertex2f(origin.x + q.x0, origin.y + q.y1);
+                rlTexCoord2f(q.u1, q.v1);
+                rlVertex2f(origin.x + q.x1, origin.y + q.y1);
+                rlTexCoord2f(q.u1, q.v0);
+                rlVertex2f(origin.x + q.x1, origin.y + q.y0);
+            }
+            rlEnd();
+            rlSetTexture(0);
+        }
+    };
+}
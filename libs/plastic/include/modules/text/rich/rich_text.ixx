@@ -38,7 +38,7 @@ export namespace plastic
 
                 DrawTextEx(used_font.rl(), span.text.c_str(), {x, y}, font_size, spacing, span.color.rl());
 
-                x += MeasureTextEx(used_font.rl(), span.text.c_str(), font_size, spacing).x;
+                x += measure_text_cached(used_font.rl(), span.text.c_str(), font_size, spacing).x;
 
                 if (span.underline) {
                     DrawLineEx({bounds.x(), y + font_size}, {bounds.x() + x, y + font_size}, 1.0f, span.color.rl());
@@ -2,6 +2,7 @@
 // Created by Aidan Jost on 3/7/25.
 //
 module;
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
@@ -14,6 +15,7 @@ export module plastic.text.fmt;
 
 import plastic.color;
 import plastic.font;
+import plastic.sdf_font;
 import plastic.point;
 import plastic.rect;
 
@@ -57,6 +59,8 @@ export namespace plastic
 
     struct TextStyle {
         std::optional<Font> font;
+        /// Takes over from `font` when set: crisp at any size, outline and shadow in the same draw
+        std::shared_ptr<SdfFont> sdf_font;
         float font_size{16.0f};
         Color color = Color::white();
 
@@ -101,6 +105,11 @@ export namespace plastic
             return *this;
         }
 
+        TextStyle& with_sdf_font(std::shared_ptr<SdfFont> font) {
+            sdf_font = std::move(font);
+            return *this;
+        }
+
         TextStyle& with_size(float size) {
             font_size = size;
             return *this;
@@ -11,6 +11,7 @@ export module plastic.text.layout;
 import plastic.text.fmt;
 import plastic.color;
 import plastic.font;
+import plastic.sdf_font;
 import plastic.size;
 import plastic.rect;
 
@@ -59,6 +60,13 @@ export namespace plastic
         float total_height_{0};
         float max_width_{0};
 
+        [[nodiscard]] Font layout_font() const {
+            if (style_.sdf_font) {
+                return *style_.sdf_font->font();
+            }
+            return style_.font.value_or(Font::from(GetFontDefault()));
+        }
+
     public:
         TextLayout(std::string  text, const TextStyle& style, float max_width)
             : style_(style), text_(std::move(text)), max_width_(max_width) {
@@ -89,7 +97,7 @@ export namespace plastic
 
             if (text_.empty()) return;
 
-            Font font = style_.font.value_or(Font::from(GetFontDefault()));
+            Font font = layout_font();
 
             std::string processed_text = style_.apply_transforms(text_);
 
@@ -129,65 +137,77 @@ export namespace plastic
                 }
             }
 
-            Font font = style_.font.value_or(Font::from(GetFontDefault()));
-
-            for (const auto& line : lines_) {
-                float x = rect.x();
-                float line_y = y + line.baseline;
+            Font font = layout_font();
 
-                switch (style_.alignment) {
-                    case TextAlign::Center:
-                        x += (rect.width() - line.width) / 2;
-                        break;
-                    case TextAlign::Right:
-                        x += rect.width() - line.width;
-                        break;
-                    case TextAlign::Justify:
-                        // Words are already positioned for justified text
-                            break;
-                    case TextAlign::Left:
-                        default:
-                    // No adjustment needed
-                    break;
-                }
+            TextEffects effects{style_.color};
+            if (style_.sdf_font) {
+                effects.outline_color = style_.outline_color;
+                effects.outline_width = style_.outline_thickness;
+                effects.shadow_color = style_.shadow_color;
+                effects.shadow_offset = {style_.shadow_offset_x, style_.shadow_offset_y};
+                effects.shadow_blur = style_.shadow_blur;
+            }
 
-                for (const auto& word : line.words) {
-                    Vector2 position {x, line_y - line.baseline * 0.8f}; // Adjust for baseline
+            // Visits every word with its pen position and baseline
+            const auto for_each_word = [&](auto&& fn) {
+                float line_top = y;
+                for (const auto& line : lines_) {
+                    float x = rect.x();
+                    float line_y = line_top + line.baseline;
 
-                    // Draw shadow if configured
-                    if (style_.selection_color) {
-                        Vector2 shadow_pos{position.x + style_.shadow_offset_x, position.y + style_.shadow_offset_y};
-                        DrawTextEx(font.rl(), word.text.c_str(), shadow_pos, style_.font_size, style_.letter_spacing, style_.shadow_color->rl());
+                    switch (style_.alignment) {
+                        case TextAlign::Center:
+                            x += (rect.width() - line.width) / 2;
+                            break;
+                        case TextAlign::Right:
+                            x += rect.width() - line.width;
+                            break;
+                        case TextAlign::Justify:
+                            // Words are already positioned for justified text
+                                break;
+                        case TextAlign::Left:
+                            default:
+                        // No adjustment needed
+                        break;
                     }
 
-                    if (style_.outline_color && style_.outline_thickness > 0) {
-                        Color outline = style_.outline_color.value();
-                        float thickness = style_.outline_thickness;
+                    for (const auto& word : line.words) {
+                        fn(word, x, line_y, line);
 
-                        for (float dx = -thickness; dx <= thickness; dx += thickness) {
-                            for (float dy = -thickness; dy <= thickness; dy += thickness) {
-                                if (dx != 0 || dy != 0) {
-                                    Vector2 outline_pos{position.x + dx, position.y + dy};
-                                    DrawTextEx(font.rl(), word.text.c_str(), outline_pos, style_.font_size, style_.letter_spacing, outline.rl());
-                                }
-                            }
+                        x += word.width;
+
+                        if (style_.alignment == TextAlign::Justify && line.space_count > 0) {
+                            x += line.total_extra_space / static_cast<float>(line.space_count);
+                        } else {
+                            x += line.space_width;
                         }
                     }
-
+                    line_top += line.height + line.spacing_before;
+                }
+            };
+
+            if (style_.sdf_font) {
+                // The distance field shades outline, shadow and fill in one pass; one shader
+                // pass covers every word, and decorations are drawn after it without the shader
+                style_.sdf_font->begin(effects, style_.font_size);
+                for_each_word([&](const Word& word, float x, float line_y, const auto& line) {
+                    const Vector2 position{x, line_y - line.baseline * 0.8f}; // Adjust for baseline
                     DrawTextEx(font.rl(), word.text.c_str(), position, style_.font_size, style_.letter_spacing, style_.color.rl());
-                    draw_text_decorations(word, x, line_y);
-
-                    x += word.width;
-
-                    if (style_.alignment == TextAlign::Justify && line.space_count > 0) {
-                        x += line.total_extra_space / static_cast<float>(line.space_count);
-                    } else {
-                        x += line.space_width;
-                    }
-
+                });
+                style_.sdf_font->end();
+                if (style_.decoration != TextDecoration::None) {
+                    for_each_word([&](const Word& word, float x, float line_y, const auto&) {
+                        draw_text_decorations(word, x, line_y);
+                    });
                 }
-                y += line.height + line.spacing_before;
+                return;
             }
+
+            for_each_word([&](const Word& word, float x, float line_y, const auto& line) {
+                const Vector2 position{x, line_y - line.baseline * 0.8f}; // Adjust for baseline
+                draw_word_layers(font, word, position);
+                draw_text_decorations(word, x, line_y);
+            });
         }
 
         [[nodiscard]] Size<float> get_size() const {
@@ -215,10 +235,10 @@ export namespace plastic
 
             if (words.empty()) return;
 
-            Font font = style_.font.value_or(Font::from(GetFontDefault()));
+            Font font = layout_font();
             float font_size = style_.font_size;
             float line_height = font_size * style_.line_height;
-            float space_width = MeasureTextEx(font.rl(), " ", font_size, style_.letter_spacing).x + style_.word_spacing;
+            float space_width = measure_text_cached(font.rl(), " ", font_size, style_.letter_spacing).x + style_.word_spacing;
 
             text::Line current_line;
             current_line.height = line_height;
@@ -267,7 +287,7 @@ export namespace plastic
         }
 
         void split_into_words(const std::string& paragraph, std::vector<Word>& words) const {
-            Font font = this->style_.font.value_or(Font::from(GetFontDefault()));
+            Font font = layout_font();
             float font_size = style_.font_size;
 
             // This is a simple word splitter that doesn't handle all cases
@@ -290,7 +310,7 @@ export namespace plastic
                     }
 
                     if (c == '\t') {
-                        float tab_width = style_.tab_width + MeasureTextEx(font.rl(), " ", font_size, style_.letter_spacing).x;
+                        float tab_width = style_.tab_width + measure_text_cached(font.rl(), " ", font_size, style_.letter_spacing).x;
                         Word tab;
                         tab.text = "\t";
                         tab.width = tab_width;
@@ -299,7 +319,7 @@ export namespace plastic
                 } else {
                     std::string char_str(1, c);
                     current_word += c;
-                    current_word_width += MeasureTextEx(font.rl(), char_str.c_str(), font_size, style_.letter_spacing).x;
+                    current_word_width += measure_text_cached(font.rl(), char_str.c_str(), font_size, style_.letter_spacing).x;
                 }
             }
 
@@ -312,7 +332,7 @@ export namespace plastic
         }
 
         void apply_text_alignment() const {
-            Font font = style_.font.value_or(Font::from(GetFontDefault()));
+            Font font = layout_font();
 
             if (style_.alignment == TextAlign::Left) {
                 return;
@@ -344,10 +364,34 @@ export namespace plastic
             }
         }
 
+        /// Bitmap fonts fake shadow and outline with extra copies of the word
+        void draw_word_layers(const Font& font, const Word& word, Vector2 position) const {
+            if (style_.shadow_color) {
+                Vector2 shadow_pos{position.x + style_.shadow_offset_x, position.y + style_.shadow_offset_y};
+                DrawTextEx(font.rl(), word.text.c_str(), shadow_pos, style_.font_size, style_.letter_spacing, style_.shadow_color->rl());
+            }
+
+            if (style_.outline_color && style_.outline_thickness > 0) {
+                Color outline = style_.outline_color.value();
+                float thickness = style_.outline_thickness;
+
+                for (float dx = -thickness; dx <= thickness; dx += thickness) {
+                    for (float dy = -thickness; dy <= thickness; dy += thickness) {
+                        if (dx != 0 || dy != 0) {
+                            Vector2 outline_pos{position.x + dx, position.y + dy};
+                            DrawTextEx(font.rl(), word.text.c_str(), outline_pos, style_.font_size, style_.letter_spacing, outline.rl());
+                        }
+                    }
+                }
+            }
+
+            DrawTextEx(font.rl(), word.text.c_str(), position, style_.font_size, style_.letter_spacing, style_.color.rl());
+        }
+
         void draw_text_decorations(const Word& word, float x, float baseline_y) const {
             if (style_.decoration == TextDecoration::None) return;
 
-            Font font = this->style_.font.value_or(Font::from(GetFontDefault()));
+            Font font = layout_font();
             float font_size = style_.font_size;
             float thick = std::max(1.0f, font_size / 20.0f);
             Color color = style_.color;
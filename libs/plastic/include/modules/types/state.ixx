@@ -106,7 +106,7 @@ export namespace plastic
 
             void paint(Context* cx) const override {
                 if (current_element_) {
-                    current_element_->paint(cx);
+                    current_element_->composite(cx);
                 }
             }
 
@@ -3,6 +3,7 @@
 //
 module;
 #include <algorithm>
+#include <cstdint>
 
 export module plastic.stateful_view;
 
@@ -15,17 +16,26 @@ export namespace plastic
     struct StatefulView : public View {
     protected:
         State state;
+        std::uint64_t state_version_{0};
     public:
         explicit StatefulView(State initial_state) : state(std::move(initial_state)) {}
 
         template <typename F>
         void set_state(F&& updater) {
             updater(state);
+            ++state_version_;
             if (Context* cx = get_context()) {
+                // The view rebuilds its elements, so nothing narrower than a full repaint is known
                 cx->request_layout();
+                cx->request_paint();
             }
         }
 
+        /// @brief Bumped by every set_state(), so views can keep elements built from an unchanged state
+        [[nodiscard]] std::uint64_t state_version() const {
+            return state_version_;
+        }
+
         [[nodiscard]] const State& get_state() const {
             return state;
         }
@@ -10,6 +10,7 @@ export module plastic.components;
 
 
 import plastic.element;
+import plastic.element_arena;
 import plastic.color;
 import plastic.size;
 import plastic.context;
@@ -64,7 +65,7 @@ export namespace plastic::components
         }
 
         // Style the card container
-        auto card_container = std::make_shared<FlexBox>();
+        auto card_container = make_element<FlexBox>();
         card_container->add_child(container);
 
         // Apply card styling
@@ -157,7 +158,7 @@ export namespace plastic::components
         const std::vector<T>& items,
         std::function<std::shared_ptr<Element>(const T&)> item_renderer
     ) {
-        auto list_container = std::make_shared<VStack>();
+        auto list_container = make_element<VStack>();
         list_container->with_spacing(5);
 
         for (const auto& item : items) {
@@ -206,7 +207,7 @@ export namespace plastic::components
         std::function<std::string(const T&)> item_to_string
     ) {
         // This implementation would be more complex, but here's the API interface
-        auto container = std::make_shared<VStack>();
+        auto container = make_element<VStack>();
         // Implementation details would be hidden inside
         return container;
     }
@@ -10,6 +10,7 @@ export module plastic.ui;
 
 
 import plastic.element;
+import plastic.element_arena;
 import plastic.elements.basic;
 import plastic.elements.containers;
 import plastic.color;
@@ -32,12 +33,12 @@ export namespace plastic::ui
     using FontWeight = plastic::font::Weight;
     // Factory functions for basic elements
     inline std::shared_ptr<Text> text(std::string content, float size = 16.0f, Color color = Color::white()) {
-        return std::make_shared<Text>(std::move(content), size, color);
+        return make_element<Text>(std::move(content), size, color);
     }
 
 
     inline std::shared_ptr<Button> button(std::string label, std::function<void()> on_click = nullptr) {
-        auto btn = std::make_shared<Button>(std::move(label));
+        auto btn = make_element<Button>(std::move(label));
         if (on_click) {
             btn->on_click(std::move(on_click));
         }
@@ -45,21 +46,21 @@ export namespace plastic::ui
     }
 
     inline std::shared_ptr<TextField> textfield(std::string placeholder, std::string initial_value = "") {
-        return std::make_shared<TextField>(std::move(placeholder), std::move(initial_value));
+        return make_element<TextField>(std::move(placeholder), std::move(initial_value));
     }
 
     inline std::shared_ptr<Checkbox> checkbox(std::string label, bool checked = false) {
-        return std::make_shared<Checkbox>(std::move(label), checked);
+        return make_element<Checkbox>(std::move(label), checked);
     }
 
     inline std::shared_ptr<Spacer> spacer(float width = 0, float height = 0) {
-        return std::make_shared<Spacer>(width, height);
+        return make_element<Spacer>(width, height);
     }
 
     // Layout containers with variadic templates for children
     template<typename... Children>
     inline std::shared_ptr<VStack> v_stack(float spacing, Children... children) {
-        auto stack = std::make_shared<VStack>();
+        auto stack = make_element<VStack>();
         stack->with_spacing(spacing);
         (stack->add_child(children), ...);
         return stack;
@@ -67,7 +68,7 @@ export namespace plastic::ui
 
     template<typename... Children>
     inline std::shared_ptr<HStack> h_stack(float spacing, Children... children) {
-        auto stack = std::make_shared<HStack>();
+        auto stack = make_element<HStack>();
         stack->with_spacing(spacing);
         (stack->add_child(children), ...);
         return stack;
@@ -75,14 +76,14 @@ export namespace plastic::ui
 
     template<typename... Children>
     inline std::shared_ptr<FlexBox> flex(Children... children) {
-        auto flex = std::make_shared<FlexBox>();
+        auto flex = make_element<FlexBox>();
         (flex->add_child(children), ...);
         return flex;
     }
 
     // Helper for centering content
     inline std::shared_ptr<FlexBox> center(const std::shared_ptr<Element>& child) {
-        auto container = std::make_shared<FlexBox>();
+        auto container = make_element<FlexBox>();
         container->with_align_items(FlexAlign::Center);
         container->with_justify_content(FlexAlign::Center);
         container->add_child(child);
@@ -91,7 +92,7 @@ export namespace plastic::ui
 
     // Helper for padding content
     inline std::shared_ptr<Element> padding(const std::shared_ptr<Element>& child, float padding) {
-        auto container = std::make_shared<FlexBox>();
+        auto container = make_element<FlexBox>();
         container->add_child(child);
         container->set_layout_properties(LayoutProperties().with_padding(padding));
         return container;
@@ -245,7 +246,7 @@ export namespace plastic::ui
         const std::string& message,
         std::function<void(bool)> on_result
     ) {
-        auto container = std::make_shared<FlexBox>();
+        auto container = make_element<FlexBox>();
         container->with_direction(FlexDirection::Column)
                  .with_align_items(FlexAlign::Center)
                  .with_gap(16);
@@ -257,7 +258,7 @@ export namespace plastic::ui
         container->add_child(text(message, 16, colors::text_secondary));
 
         // Add buttons
-        auto buttons = std::make_shared<FlexBox>();
+        auto buttons = make_element<FlexBox>();
         buttons->with_direction(FlexDirection::Row)
                .with_gap(8)
                .with_justify_content(FlexAlign::Center);
@@ -279,7 +280,7 @@ export namespace plastic::ui
         const std::string& title,
         std::shared_ptr<Element> content
     ) {
-        auto container = std::make_shared<FlexBox>();
+        auto container = make_element<FlexBox>();
         container->with_direction(FlexDirection::Column)
                  .with_gap(8);
 
@@ -326,14 +327,14 @@ export namespace plastic::ui
 export namespace plastic::layout
 {
     inline auto centered_column() {
-        return std::move(std::make_shared<FlexBox>()
+        return std::move(make_element<FlexBox>()
                          ->with_direction(FlexDirection::Column)
                          .with_align_items(FlexAlign::Center)
                          .with_justify_content(FlexAlign::Center));
     }
 
     inline auto form_layout() {
-        return std::move(std::make_shared<FlexBox>()
+        return std::move(make_element<FlexBox>()
                          ->with_direction(FlexDirection::Column)
                          .with_gap(12));
     }
@@ -51,6 +51,16 @@ export namespace plastic
             }
         }
 
+        /// @brief The container's children inside the viewport, in paint order, through its spatial index
+        void cull_children(const Element& container, std::vector<std::shared_ptr<Element>>& visible) const {
+            if (!enabled_) {
+                const auto& children = container.get_children();
+                visible.assign(children.begin(), children.end());
+                return;
+            }
+            container.children_in(viewport_, visible);
+        }
+
     private:
         static bool elements_intersect(const Rect<float>& a, const Rect<float>& b) {
             return !(a.x() + a.width() <= b.x() ||
@@ -71,7 +81,7 @@ export namespace plastic
 
         void paint(Context* cx) const {
             if (culling_.should_render(*element_)) {
-                element_->paint(cx);
+                element_->composite(cx);
             }
         }
 
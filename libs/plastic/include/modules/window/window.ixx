@@ -25,6 +25,9 @@ import plastic.context;
 import plastic.events;
 import plastic.color;
 import plastic.theme;
+import plastic.render_batch;
+import plastic.optimized_renderer;
+import plastic.element_arena;
 
 
 export namespace plastic
@@ -36,6 +39,9 @@ export namespace plastic
     private:
         std::shared_ptr<View> root_{};
         std::shared_ptr<Element> current_element_{};
+        std::shared_ptr<Element> painted_element_{};
+        DamageRenderer back_buffer_{Color::rgb(30, 30, 30)};   // Default background
+        std::unique_ptr<ElementArena> element_arena_{};         // Set when trees are built in arena storage
         std::shared_ptr<plastic::context::WindowContext> context_{};
         Size<float> size{0,0};
         window::WindowOptions options_;
@@ -129,16 +135,34 @@ export namespace plastic
             renderers_.clear();
             renderers_.push_back([this]() {
                 if (context_ && root_) {
-                    context_->begin_render();
-                    context_->clear_background(Color::rgb(30, 30, 30)); // Default background
-
-                    auto element = root_->render(context_.get());
+                    auto element = render_tree();
+                    if (element != painted_element_) {
+                        // A new tree: mount it so its elements report their own damage from now on
+                        if (painted_element_) {
+                            painted_element_->unmount(context_.get());
+                        }
+                        painted_element_ = element;
+                        if (element) {
+                            element->mount(context_.get());
+                        }
+                        context_->request_paint();
+                    }
                     if (element) {
                         element->set_bounds(Rect<float>{0, 0, size.width(), size.height()});
                         element->layout(context_.get());
-                        element->paint(context_.get());
                     }
 
+                    context_->begin_render();
+                    back_buffer_.repaint(context_->damage(), size, [&](const Rect<float>& region) {
+                        // Containers cull their children against the region's scissor
+                        if (element && element->get_bounds().intersects(region)) {
+                            element->composite(context_.get());
+                        }
+                        if (auto* batch = context_->batch()) {
+                            batch->flush();
+                        }
+                    });
+                    back_buffer_.present();
                     context_->end_render();
                 }
             });
@@ -158,6 +182,17 @@ export namespace plastic
         }
 
         [[nodiscard]] int id() const override { return window_id_; }
+
+    private:
+        std::shared_ptr<Element> render_tree() {
+            ArenaScope scope(element_arena_.get());
+            return root_->render(context_.get());
+        }
+
+    public:
+        [[nodiscard]] bool needs_frame() const override {
+            return context_ && !context_->damage().empty();
+        }
         [[nodiscard]] bool should_close() const override {
             return should_close_ || (context_ && context_->should_close());
         }
@@ -167,15 +202,35 @@ export namespace plastic
 
         void handle_resize( Size<float>& new_size) override {
             size = new_size;
+            if (context_) {
+                context_->request_paint();
+            }
             if (root_) {
-                root_->render(context_.get())->layout(context_.get());
-                root_->render(context_.get())->paint(context_.get());
+                auto element = render_tree();
+                element->layout(context_.get());
+                element->composite(context_.get());
             }
         }
 
 
 
 
+        /// @brief Builds the view's element trees in a per-window arena.
+        /// Elements made with make_element() then share slabs instead of one allocation each,
+        /// trees rebuilt every frame reuse the blocks of the last one, and closing the window
+        /// frees the storage slab by slab.
+        void set_arena_storage(bool enabled) {
+            if (enabled && !element_arena_) {
+                element_arena_ = std::make_unique<ElementArena>();
+            } else if (!enabled) {
+                element_arena_.reset();
+            }
+        }
+
+        [[nodiscard]] ElementArena* element_arena() const {
+            return element_arena_.get();
+        }
+
         void set_title(const std::string& title) {
             title_ = title;
             if (context_) {
@@ -20,6 +20,8 @@ export namespace plastic
         virtual void request_close() = 0;
         virtual void update() = 0;
         virtual void render() = 0;
+        /// @brief Whether the window has something to draw; idle loops wait while no window does
+        [[nodiscard]] virtual bool needs_frame() const { return true; }
         virtual Context& context() = 0;
         [[nodiscard]] virtual bool should_close() const = 0;
         [[nodiscard]] virtual const window::WindowOptions& options() const = 0;
@@ -15,6 +15,9 @@ import plastic.events;
 import plastic.point;
 import plastic.size;
 import plastic.color;
+import plastic.render_batch;
+import plastic.rect;
+import plastic.optimized_renderer;
 
 
 export namespace plastic::context
@@ -25,6 +28,9 @@ export namespace plastic::context
     private:
         std::weak_ptr<WindowBase> window_{};
         bool layout_requested_{false};
+        RenderBatch batch_{};
+        DamageTracker damage_{};
+        bool batching_{false};
 
     public:
         std::weak_ptr<AppContext> app_context_;
@@ -91,13 +97,26 @@ export namespace plastic::context
         static void focus(View* view);
         static void focus(Element* view);
 
-        void request_paint() override {
-            // implement paint request
-            if (const auto window = window_.lock()) {
-                window->context().request_paint();
+        /// @brief Repaints the whole window on the next frame
+        void request_paint() override { damage_.add_all(); }
+
+        void add_damage(const Rect<float>& region) override { damage_.add(region); }
+
+        bool post(std::function<void()> task) override {
+            const auto app = app_context_.lock();
+            return app && app->post(std::move(task));
+        }
+
+        void wake_after(double seconds) override {
+            if (const auto app = app_context_.lock()) {
+                app->wake_after(seconds);
             }
         }
 
+        /// @brief Areas to repaint on the next frame
+        DamageTracker& damage() { return damage_; }
+        [[nodiscard]] const DamageTracker& damage() const { return damage_; }
+
         void dispatch_event(const events::Event& event) override {
             // implement event dispatch
             if (const auto window = window_.lock()) {
@@ -105,6 +124,20 @@ export namespace plastic::context
             }
         }
 
+        /// @brief The window's frame draw list, when batching is enabled
+        RenderBatch* batch() override { return batching_ ? &batch_ : nullptr; }
+
+        /// @brief Records element drawing into one draw list flushed at the end of the frame.
+        /// @note Off by default: elements that still draw directly end up beneath batched ones
+        void set_batching(bool enabled) {
+            if (!enabled) {
+                batch_.clear();
+            }
+            batching_ = enabled;
+        }
+
+        [[nodiscard]] bool batching() const { return batching_; }
+
         virtual void make_current() = 0;
         virtual void process_events() = 0;
         virtual bool should_close() const = 0;
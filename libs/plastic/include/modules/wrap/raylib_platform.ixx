@@ -362,6 +362,27 @@ export namespace plastic
             Platform::dispatch_event(event);
         }
 
+        void wait_events(double timeout) override {
+            wait_for_input(timeout);
+        }
+
+        void wake() override {
+            wake_main_loop();
+        }
+
+        /// @brief Sleeps until input or wake_main_loop(), at most `timeout` seconds.
+        /// Events are handled by raylib's callbacks, so the next frame sees them as usual.
+        static void wait_for_input(double timeout) {
+            if (timeout > 0.0) {
+                glfwWaitEventsTimeout(timeout);
+            }
+        }
+
+        /// @brief Ends a wait_for_input() early; safe to call from any thread
+        static void wake_main_loop() {
+            glfwPostEmptyEvent();
+        }
+
     protected:
         void process_events() {
             // Convert platform events to our event types
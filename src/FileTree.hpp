@@ -7,6 +7,7 @@
 #include <vector>
 #include <raylib.h>
 #include "view.hpp"
+import plastic.render_state;
 
 
 
@@ -247,18 +248,14 @@ public:
     }
 
     void render() override {
-        BeginScissorMode(
-            static_cast<int>(position.x),
-            static_cast<int>(position.y),
-            static_cast<int>(width), static_cast<int>(visible_height - space_below)
-        );
+        plastic::push_scissor({position.x, position.y, width, visible_height - space_below});
 
         float y_offset = position.y;
         for (const auto& node : nodes) {
             render_node(node, y_offset, 0);
         }
 
-        EndScissorMode();
+        plastic::pop_scissor();
     }
 
     void update(float delta_time) override {
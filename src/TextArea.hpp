@@ -5,16 +5,18 @@
 #ifndef TEXTAREA_HPP
 #define TEXTAREA_HPP
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <functional>
-#include <sstream>
 #include <stack>
 #include <string>
 #include <vector>
-#include <iostream>
+#include "line_index.hpp"
 #include "piece_table.hpp"
 #include <raylib.h>
 #include "scroll_bar.hpp"
+import plastic.font;
+import plastic.render_state;
 
 typedef std::string string;
 
@@ -50,6 +52,7 @@ struct  TextArea {
     ScrollBar horizontal_scrollbar{false};
 
     PieceTable text_buffer;
+    LineIndex line_index;
     bool is_composing{false};
     float compose_timer = 0.0f;        // Timer for composition
     const float COMPOSE_TIMEOUT = 0.5f; // Half second timeout (adjust as needed)
@@ -62,44 +65,28 @@ struct  TextArea {
     }
 
     void move_cursor_right(){
-        if (cursor.index < text_buffer.get_text().length()){
+        if (cursor.index < text_buffer.length()){
             cursor.index ++;
             update_cursor_position();
         }
     }
 
     void move_cursor_up(){
-
-        const std::string text = text_buffer.get_text();
-        if (const size_t line_start = text.rfind('\n', cursor.index - 1); line_start == std::string::npos){
+        const auto [line, column] = line_index.locate(cursor.index);
+        if (line == 0){
             cursor.index = 0;
         } else{
-            const size_t prev_line_start = text.rfind('\n', line_start - 1);
-            const size_t offset = cursor.index - line_start;
-            if (prev_line_start == std::string::npos){
-                cursor.index = std::min(offset - 1, line_start);;
-            } else{
-                cursor.index = std::min(prev_line_start + offset, line_start);
-            }
+            // Same column on the previous line, or its end if it is shorter
+            cursor.index = line_index.line_start(line - 1) + std::min(column, line_index.line_length(line - 1));
         }
         update_cursor_position();
     }
 
     void move_cursor_down(){
-        std::string text = text_buffer.get_text();
-        size_t line_end = text.find('\n', cursor.index);
-        if (line_end != std::string::npos){
-            size_t curr_line_start = text.rfind('\n', cursor.index);
-            curr_line_start = (curr_line_start == std::string::npos) ? 0 : curr_line_start + 1;
-            size_t column = cursor.index - curr_line_start;
-
-            // Find the start of the next line
-            size_t next_line_start = line_end + 1;
-            size_t next_line_end = text.find('\n', next_line_start);
-            if (next_line_end == std::string::npos) next_line_end = text.length();
-
+        const auto [line, column] = line_index.locate(cursor.index);
+        if (line + 1 < line_index.line_count()){
             // Position cursor at the same column in next line, or end of line is shorter
-            cursor.index = std::min(next_line_start + column, next_line_end);
+            cursor.index = line_index.line_start(line + 1) + std::min(column, line_index.line_length(line + 1));
             update_cursor_position();
         }
     }
@@ -114,24 +101,32 @@ struct  TextArea {
         );
     }
 
-    float calculate_max_width() const {
-        float width = 0;
-        for (const auto& line : text_vec()) {
-            float line_width = MeasureTextEx(
-                font,
-                line.c_str(),
-                font_size,
-                spacing
-            ).x;
-            width = std::max(width, line_width);
-        }
-        return width;
+    // Re-measures `count` lines starting at `first`; the widest line is tracked by the line index
+    void measure_lines(size_t first, size_t count) {
+        const size_t last = std::min(first + count, line_index.line_count());
+        for (size_t line = first; line < last; line++) {
+            const size_t start = line_index.line_start(line);
+            const std::string text = text_buffer.get_text_in_range(start, start + line_index.line_length(line));
+            line_index.set_width(line, plastic::measure_text_cached(font, text.c_str(), font_size, spacing).x);
+        }
+        max_width = line_index.max_width();
+    }
+
+    // Measures every line from one copy of the document, for loads; edits use measure_lines
+    void measure_all_lines() {
+        const std::string text = text_buffer.get_text();
+        for (size_t line = 0; line < line_index.line_count(); line++) {
+            const size_t start = line_index.line_start(line);
+            const std::string row = text.substr(start, line_index.line_length(line));
+            line_index.set_width(line, plastic::measure_text_cached(font, row.c_str(), font_size, spacing).x);
+        }
+        max_width = line_index.max_width();
     }
 
     void update_dimensions() {
-        // Update content bounds
-        max_width = calculate_max_width();
-        total_height = static_cast<float>(text_vec().size()) * (font_size + spacing);
+        // Content bounds are O(1): widths are kept per line, the height follows the line count
+        max_width = line_index.max_width();
+        total_height = static_cast<float>(line_index.line_count()) * (font_size + spacing);
 
         // Update visible area
         visible_height = static_cast<float>(GetScreenHeight()) - pos_y - space_below;
@@ -169,35 +164,17 @@ struct  TextArea {
         }
     }
 
-    // Add line index cache for faster line-based operations
-    struct LineCache{
-        std::vector<size_t> line_starts;
-        bool is_dirty{true};
-
-        void invalidate(){ is_dirty = true; }
-        void update(const std::string& text){
-            if (is_dirty) return;
-            line_starts.clear();
-            line_starts.push_back(0);
-            for(size_t i = 0; i < text.length(); i++){
-                if (text[i] == '\n') line_starts.push_back(i + 1);
-            }
-            is_dirty = false;
-        }
-    } line_cache;
-
     struct CursorState {
         size_t index{0};
         size_t line{0};
         size_t column{0};
         char symbol{'|'};
 
-        void update(const PieceTable& buffer){
+        void update(const LineIndex& lines){
             //update line/column based on index
-            std::string text = buffer.get_text().substr(0,index);
-            line = std::ranges::count(text, '\n');
-            auto last_new_line = text.find_last_of('\n');
-            column = last_new_line == std::string::npos ? index : index - last_new_line - 1;
+            const auto location = lines.locate(index);
+            line = location.line;
+            column = location.column;
         }
     } cursor;
 
@@ -216,28 +193,50 @@ struct  TextArea {
         }
     } composition;
 
+    // Displayed text of the lines in view only; edits just mark it dirty and the next
+    // render refetches the visible lines, so no path copies or splits the whole document
     struct RenderCache{
-        struct Line{
-            string text;
-            Vector2 position;
-            bool is_dirty{true};
-        };
-        mutable std::vector<Line> lines;
+        mutable std::vector<string> lines;
+        mutable size_t first_line{0};
+        mutable bool is_dirty{true};
         void invalidate() const {
-            for (auto& [text, position, is_dirty] : lines) is_dirty = true;
+            is_dirty = true;
         }
     } render_cache;
 
     struct CursorCommand {
         size_t old_pos;
         size_t new_pos;
+        // The edit itself, so undo/redo can patch the line index like insert/remove do
+        size_t edit_pos{0};
+        std::string inserted{};
+        std::string removed{};
 
         CursorCommand(size_t old_pos, size_t new_pos)
             : old_pos(old_pos), new_pos(new_pos) {}
+
+        CursorCommand(size_t old_pos, size_t new_pos, size_t edit_pos, std::string inserted, std::string removed)
+            : old_pos(old_pos), new_pos(new_pos), edit_pos(edit_pos),
+              inserted(std::move(inserted)), removed(std::move(removed)) {}
     };
 
+    // Patches the line index for text that appeared at `pos`, measuring only the lines it spans
+    void index_inserted(size_t pos, const std::string& text) {
+        if (text.empty()) return;
+        line_index.insert(pos, text);
+        const size_t first_line = line_index.locate(pos).line;
+        measure_lines(first_line, line_index.locate(pos + text.length()).line - first_line + 1);
+    }
+
+    // Patches the line index for the range [start, end) that was removed
+    void index_removed(size_t start, size_t end) {
+        if (start >= end) return;
+        line_index.remove(start, end);
+        measure_lines(line_index.locate(start).line, 1);
+    }
+
     explicit TextArea(const std::string& initial = "")
-        : text_buffer(initial)
+        : text_buffer(initial), line_index(initial)
     {
 //        L = luaL_newstate();
 //        luaL_openlibs(L);
@@ -249,17 +248,17 @@ struct  TextArea {
     void insert(const std::string& text) {
         if (text.empty()) return;
 
-        size_t text_length = text_buffer.get_text().length();
+        size_t text_length = text_buffer.length();
         if (cursor.index > text_length) {
             cursor.index = text_length;
         }
 
         size_t old_pos = cursor.index;
         text_buffer.insert(cursor.index, text);
+        index_inserted(cursor.index, text);
         cursor.index += text.length();
 
-        CursorCommand cmd = {old_pos, cursor.index};
-        cursor_undo_stack.push(cmd);
+        cursor_undo_stack.emplace(old_pos, cursor.index, old_pos, text, std::string{});
 
         // Clear redo stack
         while (!cursor_redo_stack.empty()) {
@@ -267,18 +266,19 @@ struct  TextArea {
         }
         update_cursor_position();
         render_cache.invalidate();
-        update_render_cache();
     }
 
     void remove(size_t start, size_t end) {
-        if (start >= end || start >= text_buffer.get_text().length()) return;
+        if (start >= end || start >= text_buffer.length()) return;
 
+        end = std::min(end, text_buffer.length());
         size_t old_pos = cursor.index;
+        std::string removed = text_buffer.get_text_in_range(start, end);
         text_buffer.remove(start, end);
+        index_removed(start, end);
         cursor.index = std::min(cursor.index, start);
 
-        CursorCommand cmd = {old_pos, cursor.index};
-        cursor_undo_stack.push(cmd);
+        cursor_undo_stack.emplace(old_pos, cursor.index, start, std::string{}, std::move(removed));
 
         // Clear redo stack
         while (!cursor_redo_stack.empty()) {
@@ -286,7 +286,6 @@ struct  TextArea {
         }
         update_cursor_position();
         render_cache.invalidate();
-        update_render_cache();
     }
 
     void remove(size_t length) {
@@ -298,16 +297,17 @@ struct  TextArea {
         size_t old_pos = cursor.index;
         const size_t remove_start = cursor.index - length;
 
+        std::string removed = text_buffer.get_text_in_range(remove_start, cursor.index);
         text_buffer.remove(remove_start, cursor.index);
+        index_removed(remove_start, cursor.index);
         cursor.index = remove_start;
-        cursor_undo_stack.emplace(old_pos, cursor.index);
+        cursor_undo_stack.emplace(old_pos, cursor.index, remove_start, std::string{}, std::move(removed));
 
         while (!cursor_redo_stack.empty()) {
             cursor_redo_stack.pop();
         }
         update_cursor_position();
         render_cache.invalidate();
-        update_render_cache();
     }
 
 
@@ -321,11 +321,13 @@ struct  TextArea {
             auto cursor_cmd = cursor_undo_stack.top();
             cursor_undo_stack.pop();
             text_buffer.undo();
+            // Reverse the recorded edit: drop what it inserted, then put back what it removed
+            index_removed(cursor_cmd.edit_pos, cursor_cmd.edit_pos + cursor_cmd.inserted.length());
+            index_inserted(cursor_cmd.edit_pos, cursor_cmd.removed);
             cursor.index = cursor_cmd.old_pos;
             update_cursor_position();
             cursor_redo_stack.push(cursor_cmd);
             render_cache.invalidate();
-            update_render_cache();
         }
 
         void redo() {
@@ -334,13 +336,14 @@ struct  TextArea {
             auto cursor_cmd = cursor_redo_stack.top();
             cursor_redo_stack.pop();
             text_buffer.redo();
+            index_removed(cursor_cmd.edit_pos, cursor_cmd.edit_pos + cursor_cmd.removed.length());
+            index_inserted(cursor_cmd.edit_pos, cursor_cmd.inserted);
 
             cursor.index = cursor_cmd.new_pos;
             update_cursor_position();
             cursor_undo_stack.push(cursor_cmd);
 
             render_cache.invalidate();
-            update_render_cache();
         }
 
 
@@ -370,50 +373,15 @@ struct  TextArea {
 
     [[nodiscard]] float get_pos_y() const { return this->pos_y; };
 
-    [[nodiscard]] std::vector<std::string> text_vec() const
-    {
-        std::string display_text = text_buffer.get_text();
-
-        // Insert the input buffer at the cursor_old_struct position
-        if (!input_buffer.empty()) {
-            display_text.insert(cursor.index, input_buffer);
-        }
-
-        std::vector<std::string> v;
-        std::stringstream ss(display_text);
-        std::string s;
-
-        while (getline(ss, s, '\n')) {
-            v.push_back(s);
-        }
-        if (display_text.empty() || display_text.back() == '\n'){
-            v.emplace_back("");
-        }
-        return v;
-    }
-
     float cursor_blink_timer = 0.0f;
     float cursor_blink_rate = 0.53f;
     bool cursor_visible = true;
 
     void update_cursor_position(){
-        std::string text = text_buffer.get_text();
-        size_t text_length = text.length();
-
-        if (cursor.index > text_length){
-            cursor.index = text_length;
-        }
-
-        if(cursor.index == 0){
-            cursor.line = 0;
-            cursor.column = 0;
-        } else {
-            std::string text_before_cursor = text.substr(0, cursor.index);
-            // ReSharper disable once CppUseRangeAlgorithm
-            cursor.line  = std::count(text_before_cursor.begin(), text_before_cursor.end(),'\n');
-            size_t last_newline = text_before_cursor.rfind('\n');
-            cursor.column = (last_newline == std::string::npos) ? cursor.index : cursor.index - last_newline - 1;
+        if (cursor.index > text_buffer.length()){
+            cursor.index = text_buffer.length();
         }
+        cursor.update(line_index);
 
         // adjust visible cursor position for scrolling
         float cursor_screen_x = pos_x + (static_cast<float>(cursor.column) * font_size) - scroll_offset_x;
@@ -438,7 +406,7 @@ protected:
         if (!input_buffer.empty()){
 
             // Get current text length for bounds checking
-            if (const size_t text_length = text_buffer.get_text().length(); cursor.index > text_length){
+            if (const size_t text_length = text_buffer.length(); cursor.index > text_length){
                 cursor.index = text_length;
             }
 
@@ -450,7 +418,6 @@ protected:
             is_composing = false;
             compose_timer = 0.0f;
             render_cache.invalidate();
-            update_render_cache();
         }
     }
 
@@ -473,39 +440,64 @@ protected:
         is_composing = false;
         compose_timer = 0.0f;
         render_cache.invalidate();
-        update_render_cache();
     }
 
 public:
 
+    [[nodiscard]] float line_height() const {
+        return static_cast<float>(font.baseSize) * scale;
+    }
+
+    [[nodiscard]] string line_text(size_t line) const {
+        const size_t start = line_index.line_start(line);
+        return text_buffer.get_text_in_range(start, start + line_index.line_length(line));
+    }
+
+    // Lines in view as displayed: pending input appears at the cursor, pending deletions are gone
     void update_render_cache() const{
-        const_cast<TextArea*>(this)->update_dimensions();
-        string display_text = text_buffer.get_text();
-        if(!this->input_buffer.empty()){
-            display_text.insert(cursor.index, input_buffer);
+        const float height = std::max(line_height(), 1.0f);
+        const size_t first = static_cast<size_t>(std::max(0.0f, scroll_offset_y) / height);
+        const size_t count = static_cast<size_t>(std::ceil(visible_height / height)) + 1;
+
+        // A pending deletion may join lines: [delete_line, cursor.line] show as one
+        size_t delete_line = cursor.line;
+        size_t delete_start = cursor.index;
+        if (composition.delete_counter > 0 && cursor.index >= composition.delete_counter) {
+            delete_start = cursor.index - composition.delete_counter;
+            delete_line = line_index.locate(delete_start).line;
         }
+        const size_t joined = cursor.line - delete_line;
+        const size_t display_lines = line_index.line_count() - joined;
 
-        if (composition.delete_counter > 0) {
-            if(cursor.index >= composition.delete_counter) {
-                size_t delete_start = cursor.index - composition.delete_counter;
-                display_text.erase(delete_start, composition.delete_counter);
+        render_cache.lines.clear();
+        render_cache.first_line = first;
+        for (size_t row = first; row < display_lines && row < first + count; row++) {
+            if (row < delete_line) {
+                render_cache.lines.push_back(line_text(row));
+            } else if (row == delete_line) {
+                const size_t head = line_index.line_start(delete_line);
+                const size_t tail_end = line_index.line_start(cursor.line) + line_index.line_length(cursor.line);
+                string text = text_buffer.get_text_in_range(head, delete_start)
+                    + text_buffer.get_text_in_range(cursor.index, tail_end);
+                if (!input_buffer.empty()) {
+                    text.insert(std::min(delete_start - head, text.length()), input_buffer);
+                }
+                render_cache.lines.push_back(std::move(text));
+            } else {
+                render_cache.lines.push_back(line_text(row + joined));
             }
-
         }
+        render_cache.is_dirty = false;
 
-        render_cache.lines.clear();
-        float y = pos_y;
-
-        std::stringstream ss(display_text);
-        std::string line;
-        while (std::getline(ss, line, '\n')){
-            RenderCache::Line cached_line{
-                line,
-                {pos_x, y},
-                false
-            };
-            render_cache.lines.push_back(cached_line);
-            y += static_cast<float>(font.baseSize) * scale;
+        const_cast<TextArea*>(this)->update_dimensions();
+    }
+
+    // Refetches the visible lines when an edit or a scroll changed them
+    void refresh_render_cache() const {
+        const float height = std::max(line_height(), 1.0f);
+        const size_t first = static_cast<size_t>(std::max(0.0f, scroll_offset_y) / height);
+        if (render_cache.is_dirty || first != render_cache.first_line) {
+            update_render_cache();
         }
     }
 
@@ -575,7 +567,7 @@ public:
                 const char new_char = static_cast<char>(char_key);
 
                 // Ensure cursor is within bounds before adding to input buffer
-                if (const size_t text_length = text_buffer.get_text().length(); cursor.index > text_length){
+                if (const size_t text_length = text_buffer.length(); cursor.index > text_length){
                     cursor.index = text_length;
                 }
 
@@ -583,7 +575,7 @@ public:
                 is_composing = true;
                 compose_timer = 0.0f; // Reset timer on new input
 
-                update_render_cache();
+                render_cache.invalidate();
             }
             char_key = GetCharPressed();
         }
@@ -608,7 +600,7 @@ public:
                 // If we're composing, just remove from buffer
                 input_buffer.pop_back();
                 compose_timer = 0.0f;
-                update_render_cache();
+                render_cache.invalidate();
             } else if (this->cursor.index > 0) {
 
                 compose_timer = 0.0f;
@@ -621,11 +613,9 @@ public:
                     composition.delete_counter = 1;
                     is_composing = true;
                 }
-                update_render_cache();
+                render_cache.invalidate();
                 // update_cursor_position();
             }
-            std::cout << "Backspace pressed" << std::endl;
-            std::cout << text_buffer.get_text().length() << std::endl;
         }
 
         if (IsKeyPressed(KEY_ENTER))
@@ -642,7 +632,6 @@ public:
             is_composing = false;
             compose_timer = 0.0f;
             render_cache.invalidate();
-            update_render_cache();
         };
 
         // update cursor blink
@@ -669,6 +658,8 @@ public:
 
 
         if (first_render) {
+            // The font may have been assigned after construction, so take the initial measurements now
+            measure_all_lines();
             update_dimensions();
             update_cursor_position();
             update_render_cache();
@@ -676,27 +667,21 @@ public:
             scroll_offset_y = 0;
             first_render = false;
         }
-        if(render_cache.lines.empty()){
-            update_render_cache();
-        }
+        refresh_render_cache();
 
-        BeginScissorMode(
-            static_cast<int>(pos_x),
-            static_cast<int>(pos_y),
-            static_cast<int>(visible_width),
-            static_cast<int>(visible_height));
+        plastic::push_scissor({pos_x, pos_y, visible_width, visible_height});
 
         // Apply scroll offsets when rendering
-        for (const auto& line : render_cache.lines){
+        for (size_t i = 0; i < render_cache.lines.size(); i++){
             Vector2 pos = {
-                line.position.x - scroll_offset_x,
-                line.position.y - scroll_offset_y
+                pos_x - scroll_offset_x,
+                pos_y + static_cast<float>(render_cache.first_line + i) * line_height() - scroll_offset_y
             };
 
             // Only render if line is visible
             if (pos.y + font_size >= pos_y && pos.y <= pos_y + visible_height){
                 DrawTextEx(
-                    font, line.text.c_str(),
+                    font, render_cache.lines[i].c_str(),
                     pos,
                     font_size,
                     spacing,
@@ -704,7 +689,7 @@ public:
                 );
             }
         }
-        EndScissorMode();
+        plastic::pop_scissor();
 
         // Render scrollbars
         const Rectangle v_bounds = {
@@ -724,7 +709,8 @@ public:
         horizontal_scrollbar.render(h_bounds, max_width, visible_width, scroll_offset_x);
     };
     [[nodiscard]] std::string get_current_line() const {
-        return this->text_vec().at(this->cursor.line);
+        const size_t start = line_index.line_start(cursor.line);
+        return text_buffer.get_text_in_range(start, start + line_index.line_length(cursor.line));
     }
 
     [[nodiscard]] Font get_font() const { return this->font; }
@@ -763,6 +749,8 @@ public:
 
     void load_content(const std::string& content){
         text_buffer = PieceTable(content);
+        line_index.reset(content);
+        measure_all_lines();
         cursor.index = 0;
         input_buffer.clear();
         is_composing = false;
@@ -775,7 +763,6 @@ public:
 
         update_cursor_position();
         render_cache.invalidate();
-        update_render_cache();
 
         update_dimensions();
     }
@@ -793,27 +780,21 @@ public:
         float x = pos_x;
         float y =  pos_y;
 
-        // get text up tp cursor
+        // locate the cursor, ignoring characters pending deletion
         const size_t n_del = (composition.delete_counter > 0) ? composition.delete_counter : 0;
-        string text = text_buffer.get_text().substr(0, cursor.index - n_del);
+        const size_t index = cursor.index - std::min(n_del, cursor.index);
+        const auto [line, column] = line_index.locate(index);
 
-        // count newlines for y position
-        const size_t newlines = std::ranges::count(text, '\n');
-        y += static_cast<float>(newlines) * font_size;
+        y += static_cast<float>(line) * font_size;
 
-        // get x position
-        if (const size_t last_newline = text.rfind('\n'); last_newline != std::string::npos){
-            // If we're not on the first line, measure from the last newline
-            const string current_line = text.substr(last_newline + 1);
-            x += MeasureTextEx(font,current_line.c_str(), font_size, spacing).x;
-        } else {
-            // If we're on the first line, measure from the start
-            x += MeasureTextEx(font,text.c_str(), font_size, spacing).x;
-        }
+        // get x position by measuring only the current line up to the cursor
+        const size_t line_start = index - column;
+        const string current_line = text_buffer.get_text_in_range(line_start, index);
+        x += plastic::measure_text_cached(font, current_line.c_str(), font_size, spacing).x;
 
         // add composition buffer offset if composing
         if (is_composing && !input_buffer.empty()) {
-            x += MeasureTextEx(font,input_buffer.c_str(), font_size, spacing).x;
+            x += plastic::measure_text_cached(font, input_buffer.c_str(), font_size, spacing).x;
         }
 
         return {x, y};
@@ -14,6 +14,7 @@
 #include <vector>
 #include "TextArea.hpp"
 #include "view.hpp"
+import plastic.font;
 
 using std::string;
 using std::vector;
@@ -234,7 +235,7 @@ struct TextEditor : View<TextEditor> {
             // Draw tab background
             Color tab_color = is_current ? DARKGRAY : GRAY;
             DrawRectangle(static_cast<int>(tab_x), static_cast<int>(tab_y),
-                static_cast<int>((MeasureTextEx(font, tab->name.c_str(),
+                static_cast<int>((plastic::measure_text_cached(font, tab->name.c_str(),
                 font_size/2, spacing).x) +
                 tab_padding*2), static_cast<int>(tab_height), tab_color);
 
@@ -244,7 +245,7 @@ struct TextEditor : View<TextEditor> {
                 font_size/2, spacing,
                 is_current ? WHITE : LIGHTGRAY);
 
-            tab_x += MeasureTextEx(font, tab->name.c_str(),
+            tab_x += plastic::measure_text_cached(font, tab->name.c_str(),
                 font_size/2, spacing).x + tab_padding*3;
         }
 
@@ -260,7 +261,7 @@ struct TextEditor : View<TextEditor> {
             if (auto [x, y] = GetMousePosition(); y < tab_height) { // Click in tab area
                 float tab_x = content_start.x;
                 for (size_t i = 0; i < tabs.size(); i++) {
-                    const float tab_width = MeasureTextEx(font,
+                    const float tab_width = plastic::measure_text_cached(font,
                         tabs[i]->name.c_str(), font_size/2,
                         spacing).x + tab_padding*3;
 
@@ -97,12 +97,7 @@ namespace kup
 
         // Render views
         if (file_tree) {
-            BeginScissorMode(
-                static_cast<int>(file_tree_bounds.x()),
-                static_cast<int>(file_tree_bounds.y()),
-                static_cast<int>(file_tree_bounds.width()),
-                static_cast<int>(file_tree_bounds.height())
-            );
+            file_tree_bounds.apply_scissor();
 
             // Debug output
             std::cout << "Rendering file tree" << std::endl;
@@ -110,32 +105,27 @@ namespace kup
             if (const auto element = file_tree->render(context_.get())) {
                 std::cout << "File tree element rendered" << std::endl;
                 element->set_bounds(file_tree_bounds);
-                element->paint(context_.get());
+                element->composite(context_.get());
             }else {
                 std::cout << "File tree element is null" << std::endl;
 
             }
 
-            EndScissorMode();
+            plastic::Rect<float>::stop_scissor();
         }
 
 
 
         if (editor_view) {
             if (const EditorState& editor_state = editor_view->get_state(); editor_state.buffer != nullptr) {
-                BeginScissorMode(
-                   static_cast<int>(editor_bounds.x()),
-                   static_cast<int>(editor_bounds.y()),
-                   static_cast<int>(editor_bounds.width()),
-                   static_cast<int>(editor_bounds.height())
-               );
+                editor_bounds.apply_scissor();
 
                 if (const auto element = editor_view->render(context_.get())) {
                     element->set_bounds(editor_bounds);
-                    element->paint(context_.get());
+                    element->composite(context_.get());
                 }
 
-                EndScissorMode();
+                plastic::Rect<float>::stop_scissor();
             }
         }
 
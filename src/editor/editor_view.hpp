@@ -20,6 +20,9 @@ namespace kup
 {
     struct EditorView : public plastic::StatefulView<EditorState> {
     private:
+        // The gutter view outlives the frame so its element and measured digits are reused
+        std::shared_ptr<LineNumberView> line_numbers_{};
+
     public:
 
 
@@ -45,12 +48,14 @@ namespace kup
             // Create and confgiure the line numbers
             if ( state.show_line_numbers )
             {
-                auto line_numbers = TextView::create()
-                   .with_buffer(state.buffer)
-                   .with_font(state.font, state.font_size, state.spacing)
-                   .build();
-                line_numbers->set_style(create_line_number_style());
-                container->add_child(line_numbers->render(cx));
+                if (!line_numbers_) {
+                    line_numbers_ = std::make_shared<LineNumberView>(state.buffer, state.font, state.font_size, state.spacing);
+                    line_numbers_->set_style(create_line_number_style());
+                }
+                line_numbers_->set_font(state.font, state.font_size, state.spacing);
+                line_numbers_->set_scroll_y(state.scroll_y);
+                line_numbers_->set_relative(false, state.cursor.row);
+                container->add_child(line_numbers_->render(cx));
             }
 
             auto main_text = TextView::create()
@@ -7,7 +7,9 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <raylib.h>
 #if defined(_WIN32)
@@ -67,7 +69,7 @@ namespace kup
 
             [[nodiscard]] float calculate_node_width(const Node& node) const {
                 // Base width calculation (indent + icon + name)
-                float width = MeasureTextEx(font, node.name.c_str(), font_size, spacing).x + 40;
+                float width = plastic::measure_text_cached(font, node.name.c_str(), font_size, spacing).x + 40;
 
                 if (node.is_directory && node.is_expanded) {
                     for (const auto& child : node.children) {
@@ -88,24 +90,29 @@ namespace kup
             float item_height;
 
         public:
-            explicit TreeElement(const FileTreeState& state) : state(state), item_height(state.font_size + state.spacing) {}
+            explicit TreeElement(const FileTreeState& state) : state(state), item_height(state.font_size + state.spacing) {
+                // The tree only changes on clicks, scrolling and reloads, so it is drawn from a cached layer
+                set_layered(true);
+            }
+
+            /// Takes over a newer view state, e.g. after a directory was loaded
+            void sync(const FileTreeState& new_state) {
+                state = new_state;
+                item_height = state.font_size + state.spacing;
+                invalidate();
+            }
 
             void paint(plastic::Context* cx) const override {
                 const auto& bounds = get_bounds();
 
-                BeginScissorMode(
-                    static_cast<int>(bounds.x()),
-                    static_cast<int>(bounds.y()),
-                    static_cast<int>(bounds.width()),
-                    static_cast<int>(bounds.height())
-                    );
+                bounds.apply_scissor();
 
                 float y = bounds.y() - state.scroll_y;
                 for (const auto& node : state.nodes) {
                     render_node(node, y, bounds.x(), 0);
                 }
 
-                EndScissorMode();
+                plastic::Rect<float>::stop_scissor();
             };
 
             float estimate_subtree_height(const FileTreeState::Node& node) const {
@@ -217,6 +224,7 @@ namespace kup
                 int index = 0;
                 for (FileTreeState::Node& node : state.nodes) {
                     if (handle_node_click(node, mouse_x, mouse_y, y, 0, index)) {
+                        invalidate();
                         break;
                     }
                 }
@@ -280,16 +288,30 @@ namespace kup
                     }
                 }
 
+                if (changed) {
+                    invalidate_paint();
+                }
                 return changed;
             }
         };
+
+        /// Kept across frames so its layer survives; rebuilt only when the view state changes
+        std::shared_ptr<TreeElement> element_{};
+        std::uint64_t element_version_{0};
+
     public:
         explicit FileTreeView(const FileTreeState& initial_state) : plastic::StatefulView<FileTreeState>(initial_state){}
 
         std::shared_ptr<plastic::Element> render(plastic::Context* cx)  override {
-            auto element = std::make_shared<TreeElement>(get_state());
-            element->set_style(create_tree_style());
-            return element;
+            if (!element_) {
+                element_ = std::make_shared<TreeElement>(get_state());
+                element_->set_style(create_tree_style());
+                element_version_ = state_version();
+            } else if (element_version_ != state_version()) {
+                element_->sync(get_state());
+                element_version_ = state_version();
+            }
+            return element_;
         }
 
         template<typename EventT>
@@ -1,14 +1,16 @@
 #pragma once
 
 #include "buffer.hpp"
+#include <array>
 #include <cmath>
 #include <memory>
 #include <raylib.h>
 import plastic;
 import plastic.style;
+import keditor;
 
 namespace kup {
-    struct LineNumberView : plastic::Element, public plastic::View {
+    struct LineNumberView : public plastic::View {
     private:
 
         struct State {
@@ -19,54 +21,125 @@ namespace kup {
             float line_spacing;
             plastic::Color color{plastic::Color::from_rl(GRAY)};
             plastic::style::Style style;
+            // show distances from current_line instead of absolute numbers
+            bool relative{false};
+            size_t current_line{0};
+            // when set, folded lines get no row and each row shows the line it maps to
+            std::shared_ptr<const keditor::FoldMap> folds;
         } state;
 
         struct LineNumberElement : plastic::Element {
         protected:
             State state;
+
+            // Advance of each digit, measured once per font and size so numbers are laid out
+            // without building strings or measuring text every frame
+            mutable std::array<float, 10> digit_advance{};
+            mutable unsigned int measured_font{0};
+            mutable float measured_size{0};
+
+            // Preferred width only changes when the line count gains or loses a digit, or the digits change size
+            size_t digits{0};
+            float width_advance{0};
+
+            static size_t count_digits(size_t value) {
+                size_t count = 1;
+                while (value >= 10) {
+                    value /= 10;
+                    ++count;
+                }
+                return count;
+            }
+
+            void measure_digits() const {
+                if (measured_font == state.font.texture.id && measured_size == state.font_size) return;
+                for (int d = 0; d < 10; ++d) {
+                    const char digit[2] = {static_cast<char>('0' + d), '\0'};
+                    digit_advance[d] = MeasureTextEx(state.font, digit, state.font_size, 0).x;
+                }
+                measured_font = state.font.texture.id;
+                measured_size = state.font_size;
+            }
+
+            [[nodiscard]] size_t row_count() const {
+                return state.folds ? state.folds->row_count() : state.buffer->line_count();
+            }
+
+            [[nodiscard]] size_t line_of_row(size_t row) const {
+                return state.folds ? state.folds->line_of(row) : row;
+            }
+
+            [[nodiscard]] size_t row_of_line(size_t line) const {
+                return state.folds ? state.folds->row_of(line) : line;
+            }
+
+            // Right-aligns `number` at `right` with one glyph quad per digit; the quads share the
+            // font texture, so raylib batches the whole gutter into a single draw
+            void draw_number(size_t number, float right, float y, const plastic::Color& color) const {
+                std::array<unsigned char, 20> reversed{};
+                size_t count = 0;
+                float width = 0;
+                do {
+                    reversed[count] = static_cast<unsigned char>(number % 10);
+                    width += digit_advance[reversed[count]] + state.line_spacing;
+                    ++count;
+                    number /= 10;
+                } while (number > 0);
+
+                float x = right - width;
+                while (count > 0) {
+                    const unsigned char d = reversed[--count];
+                    DrawTextCodepoint(state.font, '0' + d, {x, y}, state.font_size, color.rl());
+                    x += digit_advance[d] + state.line_spacing;
+                }
+            }
         public:
             explicit LineNumberElement(State initial_state) : state(std::move(initial_state)) {}
             explicit LineNumberElement(const State& initial_state) : state(initial_state) {}
 
+            // Takes over a newer view state, e.g. after scrolling or a font change
+            void sync(const State& new_state) {
+                state = new_state;
+                invalidate();
+            }
+
             void paint(plastic::Context* cx) const override {
                 const auto& bounds = get_bounds();
                 const float line_height = state.font_size + state.line_spacing;
 
-                BeginScissorMode(
-                    static_cast<int>(bounds.x()),
-                    static_cast<int>(bounds.y()),
-                    static_cast<int>(bounds.width()),
-                    static_cast<int>(bounds.height())
-                );
+                bounds.apply_scissor();
 
-                const size_t start_line = static_cast<size_t>(state.scroll_y / line_height);
-                const size_t visible_lines = static_cast<size_t>(bounds.height() / line_height) + 1;
-                const size_t end_line = std::min(start_line + visible_lines, state.buffer->line_count());
+                // Rows, not lines: a folded region takes a single row
+                const size_t start_row = static_cast<size_t>(state.scroll_y / line_height);
+                const size_t visible_rows = static_cast<size_t>(bounds.height() / line_height) + 1;
+                const size_t end_row = std::min(start_row + visible_rows, row_count());
+                const size_t current_row = row_of_line(state.current_line);
 
                 float y = bounds.y() - std::fmod(state.scroll_y, line_height);
 
-                for (size_t i = start_line; i < end_line; ++i) {
-                    const std::string line_num = std::to_string(i + 1);
-                    const float x = bounds.right() -
-                        MeasureTextEx(state.font, line_num.c_str(), state.font_size, 0).x - 5;
-
-                    DrawTextEx(state.font, line_num.c_str(),
-                        {x, y}, state.font_size, state.line_spacing, state.color.rl());
+                measure_digits();
+                for (size_t row = start_row; row < end_row; ++row) {
+                    const size_t number = state.relative && row != current_row
+                        ? (row > current_row ? row - current_row : current_row - row)
+                        : line_of_row(row) + 1;
+                    draw_number(number, bounds.right() - 5, y, state.color);
                     y += line_height;
                 }
 
-                EndScissorMode();
+                plastic::Rect<float>::stop_scissor();
             }
 
             void layout(plastic::Context* cx)  override {
-                // update preferred width based on the number of digits
-                const size_t max_lines = state.buffer->line_count();
-                const size_t digits = std::to_string(max_lines).length();
-                const float char_width = MeasureTextEx(state.font, "0", state.font_size, 0).x;
+                // update preferred width only when the number of digits or their advance changes
+                measure_digits();
+                const size_t line_digits = count_digits(state.buffer->line_count());
+                if (line_digits == digits && digit_advance[0] == width_advance) return;
+                digits = line_digits;
+                width_advance = digit_advance[0];
 
                 auto style = get_style();
                 style.set_preferred_size( plastic::Size<float>{
-                    char_width * static_cast<float>(digits + 1), // +1 for padding
+                    width_advance * static_cast<float>(digits + 1), // +1 for padding
                     style.preferred_size ? style.preferred_size->height() : 0
                 });
                 set_style(style);
@@ -75,20 +148,70 @@ namespace kup {
 
         };
 
+        // Kept across frames so the measured digits survive; synced when the view state changes
+        std::shared_ptr<LineNumberElement> element_{};
+        bool element_stale_{false};
+
     public:
-        LineNumberView(std::shared_ptr<Buffer>, const Font&, float, float)
+        LineNumberView(std::shared_ptr<Buffer> buffer, const Font& font, float font_size, float line_spacing)
             :   state() {
+            state.buffer = std::move(buffer);
+            state.font = font;
+            state.font_size = font_size;
+            state.line_spacing = line_spacing;
+            state.style = create_default_style();
         }
 
         explicit LineNumberView(State initial_state)
             :   state(std::move(initial_state)) {
         }
 
-
-
+        std::shared_ptr<plastic::Element> render(plastic::Context* cx) override {
+            if (!element_) {
+                element_ = std::make_shared<LineNumberElement>(state);
+                element_->set_style(state.style);
+            } else if (element_stale_) {
+                element_->sync(state);
+            }
+            element_stale_ = false;
+            return element_;
+        }
 
         void set_scroll_y(float y) {
+            if (state.scroll_y == y) return;
             state.scroll_y = y;
+            element_stale_ = true;
+        }
+
+        void set_font(const Font& font, float font_size, float line_spacing) {
+            if (state.font.texture.id == font.texture.id && state.font_size == font_size
+                && state.line_spacing == line_spacing) return;
+            state.font = font;
+            state.font_size = font_size;
+            state.line_spacing = line_spacing;
+            element_stale_ = true;
+        }
+
+        void set_relative(bool relative, size_t current_line) {
+            if (state.relative == relative && (!relative || state.current_line == current_line)) {
+                state.current_line = current_line;
+                return;
+            }
+            state.relative = relative;
+            state.current_line = current_line;
+            element_stale_ = true;
+        }
+
+        void set_folds(std::shared_ptr<const keditor::FoldMap> folds) {
+            state.folds = std::move(folds);
+            element_stale_ = true;
+        }
+
+        void set_style(const plastic::style::Style& style) {
+            state.style = style;
+            if (element_) {
+                element_->set_style(style);
+            }
         }
 
         static plastic::style::Style create_default_style() {
@@ -166,19 +166,14 @@ namespace kup {
             void paint(plastic::Context* cx) const override {
                 const auto& bounds = get_style().padding.bounds();
 
-                BeginScissorMode(
-                    static_cast<int>(bounds.x()),
-                    static_cast<int>(bounds.y()),
-                    static_cast<int>(bounds.width()),
-                    static_cast<int>(bounds.height())
-                );
+                bounds.apply_scissor();
 
                 render_text(bounds);
                 if (state.has_focus) {
                     render_cursor(bounds);
                 }
 
-                EndScissorMode();
+                plastic::Rect<float>::stop_scissor();
             }
 
             void layout(plastic::Context* cx) override {
@@ -0,0 +1,307 @@
+//
+// Incrementally maintained line index for the legacy TextArea.
+//
+
+#ifndef LINE_INDEX_HPP
+#define LINE_INDEX_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stores the length of every line (including its trailing '\n') in an implicit treap, so
+// line <-> index lookups and edits cost O(log n) instead of rescanning the document.
+// Each line also carries its measured width; the widest line is kept at the root.
+struct LineIndex {
+private:
+    static constexpr std::uint32_t NIL = 0xFFFFFFFFu;
+
+    struct Node {
+        size_t length{0};        // line length, including the trailing newline
+        size_t sum{0};           // total length of the subtree
+        size_t count{1};         // number of lines in the subtree
+        float width{0};          // measured width of the line
+        float max_width{0};      // widest line in the subtree
+        std::uint32_t priority{0};
+        std::uint32_t left{NIL};
+        std::uint32_t right{NIL};
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> free_nodes;
+    std::uint32_t root{NIL};
+    std::uint32_t seed{0x9E3779B9u};
+
+    std::uint32_t next_priority() {
+        // xorshift32 - only needs to be cheap and well spread
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    [[nodiscard]] size_t sum_of(std::uint32_t n) const { return n == NIL ? 0 : nodes[n].sum; }
+    [[nodiscard]] size_t count_of(std::uint32_t n) const { return n == NIL ? 0 : nodes[n].count; }
+    [[nodiscard]] float max_width_of(std::uint32_t n) const { return n == NIL ? 0 : nodes[n].max_width; }
+
+    void pull(std::uint32_t n) {
+        Node& node = nodes[n];
+        node.sum = node.length + sum_of(node.left) + sum_of(node.right);
+        node.count = 1 + count_of(node.left) + count_of(node.right);
+        node.max_width = std::max(node.width, std::max(max_width_of(node.left), max_width_of(node.right)));
+    }
+
+    std::uint32_t make_node(size_t length, std::uint32_t priority) {
+        std::uint32_t n;
+        if (!free_nodes.empty()) {
+            n = free_nodes.back();
+            free_nodes.pop_back();
+            nodes[n] = Node{};
+        } else {
+            n = static_cast<std::uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[n].length = length;
+        nodes[n].sum = length;
+        nodes[n].priority = priority;
+        return n;
+    }
+
+    void release(std::uint32_t n) {
+        if (n == NIL) return;
+        release(nodes[n].left);
+        release(nodes[n].right);
+        free_nodes.push_back(n);
+    }
+
+    // Splits the first `k` lines of `n` into `left`, the rest into `right`
+    void split(std::uint32_t n, size_t k, std::uint32_t& left, std::uint32_t& right) {
+        if (n == NIL) {
+            left = right = NIL;
+            return;
+        }
+        if (count_of(nodes[n].left) < k) {
+            split(nodes[n].right, k - count_of(nodes[n].left) - 1, nodes[n].right, right);
+            left = n;
+        } else {
+            split(nodes[n].left, k, left, nodes[n].left);
+            right = n;
+        }
+        pull(n);
+    }
+
+    std::uint32_t merge(std::uint32_t left, std::uint32_t right) {
+        if (left == NIL) return right;
+        if (right == NIL) return left;
+        if (nodes[left].priority > nodes[right].priority) {
+            nodes[left].right = merge(nodes[left].right, right);
+            pull(left);
+            return left;
+        }
+        nodes[right].left = merge(left, nodes[right].left);
+        pull(right);
+        return right;
+    }
+
+    // Builds a balanced subtree from `lengths[lo, hi)`; priorities shrink with depth to keep the heap order
+    std::uint32_t build(const std::vector<size_t>& lengths, size_t lo, size_t hi, std::uint32_t depth) {
+        if (lo >= hi) return NIL;
+        const size_t mid = lo + (hi - lo) / 2;
+        const std::uint32_t n = make_node(lengths[mid], 0xFFFFFFFFu - depth * (1u << 26) - (next_priority() >> 8));
+        const std::uint32_t left = build(lengths, lo, mid, depth + 1);
+        const std::uint32_t right = build(lengths, mid + 1, hi, depth + 1);
+        nodes[n].left = left;
+        nodes[n].right = right;
+        pull(n);
+        return n;
+    }
+
+    void assign_width(std::uint32_t n, size_t line, float width) {
+        const size_t left_count = count_of(nodes[n].left);
+        if (line < left_count) {
+            assign_width(nodes[n].left, line, width);
+        } else if (line > left_count) {
+            assign_width(nodes[n].right, line - left_count - 1, width);
+        } else {
+            nodes[n].width = width;
+        }
+        pull(n);
+    }
+
+    // Adds `delta` to the length of line `line`, fixing sums on the way back up
+    void adjust(std::uint32_t n, size_t line, std::ptrdiff_t delta) {
+        const size_t left_count = count_of(nodes[n].left);
+        if (line < left_count) {
+            adjust(nodes[n].left, line, delta);
+        } else if (line > left_count) {
+            adjust(nodes[n].right, line - left_count - 1, delta);
+        } else {
+            nodes[n].length = static_cast<size_t>(static_cast<std::ptrdiff_t>(nodes[n].length) + delta);
+        }
+        pull(n);
+    }
+
+    static std::vector<size_t> split_lengths(const std::string& text) {
+        std::vector<size_t> lengths;
+        size_t start = 0;
+        for (size_t i = 0; i < text.length(); i++) {
+            if (text[i] == '\n') {
+                lengths.push_back(i + 1 - start);
+                start = i + 1;
+            }
+        }
+        lengths.push_back(text.length() - start);
+        return lengths;
+    }
+
+public:
+    struct Location {
+        size_t line{0};
+        size_t column{0};
+    };
+
+    explicit LineIndex(const std::string& text = "") { reset(text); }
+
+    // Rebuilds the index from scratch; O(n), used on load and after undo/redo
+    void reset(const std::string& text) {
+        nodes.clear();
+        free_nodes.clear();
+        const auto lengths = split_lengths(text);
+        nodes.reserve(lengths.size());
+        root = build(lengths, 0, lengths.size(), 0);
+    }
+
+    [[nodiscard]] size_t line_count() const { return count_of(root); }
+
+    [[nodiscard]] size_t length() const { return sum_of(root); }
+
+    // Width of the widest line, O(1)
+    [[nodiscard]] float max_width() const { return max_width_of(root); }
+
+    // Records the measured width of `line`; new lines start at zero until measured
+    void set_width(size_t line, float width) {
+        if (line < line_count()) assign_width(root, line, width);
+    }
+
+    // Index of the first character of `line`
+    [[nodiscard]] size_t line_start(size_t line) const {
+        size_t start = 0;
+        std::uint32_t n = root;
+        while (n != NIL) {
+            const size_t left_count = count_of(nodes[n].left);
+            if (line < left_count) {
+                n = nodes[n].left;
+            } else {
+                start += sum_of(nodes[n].left);
+                if (line == left_count) return start;
+                start += nodes[n].length;
+                line -= left_count + 1;
+                n = nodes[n].right;
+            }
+        }
+        return start;
+    }
+
+    // Length of `line` without its trailing newline
+    [[nodiscard]] size_t line_length(size_t line) const {
+        // every line but the last one carries a newline
+        return line_total(line) - (line + 1 < line_count() ? 1 : 0);
+    }
+
+    // Line and column of a character index; indices past the end clamp to the end of the last line
+    [[nodiscard]] Location locate(size_t index) const {
+        if (index >= length()) {
+            const size_t last = line_count() - 1;
+            return {last, length() - line_start(last)};
+        }
+        Location location;
+        std::uint32_t n = root;
+        while (n != NIL) {
+            const size_t left_sum = sum_of(nodes[n].left);
+            if (index < left_sum) {
+                n = nodes[n].left;
+            } else if (index < left_sum + nodes[n].length) {
+                location.line += count_of(nodes[n].left);
+                location.column = index - left_sum;
+                return location;
+            } else {
+                location.line += count_of(nodes[n].left) + 1;
+                index -= left_sum + nodes[n].length;
+                n = nodes[n].right;
+            }
+        }
+        return location;
+    }
+
+    // Records `text` being inserted at `index`
+    void insert(size_t index, const std::string& text) {
+        if (text.empty()) return;
+        const Location at = locate(index);
+        const auto segments = split_lengths(text);
+
+        if (segments.size() == 1) {
+            adjust(root, at.line, static_cast<std::ptrdiff_t>(text.length()));
+            return;
+        }
+
+        // The edited line keeps its head plus the first inserted segment, the tail moves to the last new line
+        const size_t old_length = line_total(at.line);
+        const size_t head = at.column + segments.front();
+        std::vector<size_t> added(segments.begin() + 1, segments.end());
+        added.back() += old_length - at.column;
+        adjust(root, at.line, static_cast<std::ptrdiff_t>(head) - static_cast<std::ptrdiff_t>(old_length));
+
+        std::uint32_t left, right;
+        split(root, at.line + 1, left, right);
+        std::uint32_t middle = NIL;
+        for (size_t length : added) {
+            middle = merge(middle, make_node(length, next_priority()));
+        }
+        root = merge(merge(left, middle), right);
+    }
+
+    // Records the range [start, end) being removed
+    void remove(size_t start, size_t end) {
+        if (start >= end || start >= length()) return;
+        const Location first = locate(start);
+        const Location last = locate(std::min(end, length()));
+
+        if (first.line == last.line) {
+            adjust(root, first.line, -static_cast<std::ptrdiff_t>(last.column - first.column));
+            return;
+        }
+
+        // The first line absorbs whatever remains of the last one; everything in between is dropped
+        const size_t tail = line_total(last.line) - last.column;
+        const size_t old_length = line_total(first.line);
+        adjust(root, first.line,
+            static_cast<std::ptrdiff_t>(first.column + tail) - static_cast<std::ptrdiff_t>(old_length));
+
+        std::uint32_t left, middle, right;
+        split(root, first.line + 1, left, right);
+        split(right, last.line - first.line, middle, right);
+        release(middle);
+        root = merge(left, right);
+    }
+
+private:
+    // Stored length of `line`, including its newline
+    [[nodiscard]] size_t line_total(size_t line) const {
+        std::uint32_t n = root;
+        while (n != NIL) {
+            const size_t left_count = count_of(nodes[n].left);
+            if (line < left_count) {
+                n = nodes[n].left;
+            } else if (line == left_count) {
+                return nodes[n].length;
+            } else {
+                line -= left_count + 1;
+                n = nodes[n].right;
+            }
+        }
+        return 0;
+    }
+};
+
+#endif //LINE_INDEX_HPP
@@ -0,0 +1,65 @@
+// Checks LineIndex against line starts recomputed from a plain string after random edits.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "line_index.hpp"
+
+#define CHECK(cond) do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); return 1; } } while (0)
+
+static int check_against(const LineIndex& index, const std::string& text) {
+    size_t line = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        if (i == text.size() || text[i] == '\n') {
+            CHECK(index.line_start(line) == start);
+            CHECK(index.line_length(line) == i - start);
+            ++line;
+            start = i + 1;
+        }
+    }
+    CHECK(index.line_count() == line);
+    CHECK(index.length() == text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        const auto at = index.locate(i);
+        CHECK(index.line_start(at.line) + at.column == i);
+    }
+    return 0;
+}
+
+int main() {
+    std::string text = "one\ntwo\n\nfour";
+    LineIndex index(text);
+    CHECK(index.line_count() == 4);
+    CHECK(index.locate(5).line == 1 && index.locate(5).column == 1);
+    CHECK(index.locate(100).line == 3 && index.locate(100).column == 4);
+
+    index.set_width(1, 30.0f);
+    index.set_width(3, 12.0f);
+    CHECK(index.max_width() == 30.0f);
+
+    std::mt19937 rng(7);
+    const std::string alphabet = "ab\n";
+    for (int step = 0; step < 2000; ++step) {
+        if (text.empty() || rng() % 2 == 0) {
+            const size_t at = rng() % (text.size() + 1);
+            std::string inserted;
+            for (size_t n = rng() % 6 + 1; n > 0; --n) {
+                inserted += alphabet[rng() % alphabet.size()];
+            }
+            text.insert(at, inserted);
+            index.insert(at, inserted);
+        } else {
+            const size_t start = rng() % text.size();
+            const size_t end = std::min(text.size(), start + rng() % 8 + 1);
+            text.erase(start, end - start);
+            index.remove(start, end);
+        }
+        if (check_against(index, text) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <raylib.h>
+#include <algorithm>
 #include <string>
 #include <iostream>
 
@@ -81,6 +82,47 @@ int main(int argc, char *argv[])
         editor.open_file(path);
     };
 
+    // Persistent back buffer: idle frames repaint only what changed, e.g. the blinking cursor
+    plastic::DamageTracker damage;
+    plastic::DamageRenderer back_buffer{plastic::Color::black()};
+    plastic::Rect<float> painted_cursor{};
+
+    // The legacy views do not report their own changes. Keyboard input is seen through what it
+    // changed in the editor, and pointer input repaints the pane under the pointer, whose render
+    // also runs its scrollbar hover and drag
+    constexpr double IDLE_MAX_WAIT = 0.5;
+    struct EditorState {
+        size_t tabs{0};
+        size_t current_tab{0};
+        bool focused{false};
+        size_t length{0};
+        size_t cursor{0};
+        size_t edits{0};
+        size_t composing{0};
+        float scroll_x{0.0f};
+        float scroll_y{0.0f};
+        bool operator==(const EditorState&) const = default;
+    };
+    auto editor_state = [&editor] {
+        EditorState state{editor.tabs.size(), editor.current_tab, editor.is_focused};
+        if (!editor.tabs.empty() && editor.tabs.at(editor.current_tab)->text_area) {
+            const auto& text_area = *editor.tabs.at(editor.current_tab)->text_area;
+            state.length = text_area.text_buffer.length();
+            state.cursor = text_area.cursor.index;
+            state.edits = text_area.cursor_undo_stack.size() + text_area.cursor_redo_stack.size();
+            state.composing = text_area.input_buffer.size() + text_area.composition.buffer.size();
+            state.scroll_x = text_area.scroll_offset_x;
+            state.scroll_y = text_area.scroll_offset_y;
+        }
+        return state;
+    };
+    auto pointer_active = [] {
+        const Vector2 mouse_delta = GetMouseDelta();
+        return mouse_delta.x != 0.0f || mouse_delta.y != 0.0f || GetMouseWheelMove() != 0.0f
+            || IsMouseButtonDown(MOUSE_BUTTON_LEFT) || IsMouseButtonReleased(MOUSE_BUTTON_LEFT)
+            || IsMouseButtonDown(MOUSE_BUTTON_RIGHT) || IsMouseButtonReleased(MOUSE_BUTTON_RIGHT);
+    };
+
     SetTargetFPS(120);
     while (!WindowShouldClose())
     {
@@ -89,50 +131,106 @@ int main(int argc, char *argv[])
         delta_time = current_time - last_time;
         last_time = current_time;
 
+        const EditorState editor_before = editor_state();
         editor.update(delta_time);
         file_tree.update(delta_time);
 
-        BeginDrawing();
-        ClearBackground(BLACK);
+        const auto screen_width = static_cast<float>(GetScreenWidth());
+        const auto screen_height = static_cast<float>(GetScreenHeight());
+        const float pane_split = editor.content_start.x - GRIP_GAP;
+        const plastic::Rect<float> tree_pane{0, 0, pane_split, screen_height};
+        const plastic::Rect<float> editor_pane{pane_split, 0, screen_width - pane_split, screen_height};
+
+        if (IsWindowResized()) {
+            damage.add_all();
+        }
+        if (editor_state() != editor_before) {
+            damage.add(editor_pane);
+        }
+        if (pointer_active()) {
+            const Vector2 mouse = GetMousePosition();
+            damage.add(mouse.x < pane_split ? tree_pane : editor_pane);
+        }
+        // A scrollbar drag keeps following the pointer after it leaves the pane
+        if (!editor.tabs.empty() && editor.tabs.at(editor.current_tab)->text_area) {
+            const auto& text_area = *editor.tabs.at(editor.current_tab)->text_area;
+            if (text_area.vertical_scrollbar.is_dragging || text_area.horizontal_scrollbar.is_dragging) {
+                damage.add(editor_pane);
+            }
+        }
 
-        // render FileTree text
-        file_tree.render();
+        // Cursor area, empty while the cursor is hidden
+        plastic::Rect<float> cursor{};
+        if (!editor.tabs.empty() && editor.is_focused
+            && editor.tabs.at(editor.current_tab)->text_area->cursor_visible) {
+            cursor = plastic::Rect<float>{
+                editor.tabs.at(editor.current_tab)->get_cursor_x() - editor.font_size/CURSOR_OFFSET,
+                editor.tabs.at(editor.current_tab)->get_cursor_y(),
+                editor.font_size,
+                editor.font_size
+            };
+        }
+        if (cursor != painted_cursor) {
+            damage.add(painted_cursor);
+            damage.add(cursor);
+            painted_cursor = cursor;
+        }
+
+        // Something changed this frame; keep frames coming while e.g. a held arrow key repeats
+        const bool changed = !damage.empty();
+
+        BeginDrawing();
+        back_buffer.repaint(damage, {static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())},
+            [&](const plastic::Rect<float>& region) {
+            // Each pane is only redrawn when the region reaches it; a blinking cursor skips the file tree
+            int tapx = static_cast<int>(editor.content_start.x)-GRIP_GAP;
+            int tapy = static_cast<int>(editor.content_start.y);
+
+            // render FileTree text
+            if (region.x() < static_cast<float>(tapx)) {
+                file_tree.render();
+            }
 
-        // render keditor background
-        int tapx = static_cast<int>(editor.content_start.x)-GRIP_GAP;
-        int tapy = static_cast<int>(editor.content_start.y);
-        DrawRectangle(tapx, tapy, GetScreenWidth()-tapx, GetScreenHeight()-tapy, BLACK);
+            if (region.x() + region.width() > static_cast<float>(tapx)) {
+                // render keditor background
+                DrawRectangle(tapx, tapy, GetScreenWidth()-tapx, GetScreenHeight()-tapy, BLACK);
 
-        editor.render();
+                editor.render();
+            }
 
-        // Draw cursor at correct position
-        if (!editor.tabs.empty()) {
-            if (editor.is_focused){
-                Vector2 cursor_pos = {
-                    editor.tabs.at(editor.current_tab)->get_cursor_x() - editor.font_size/CURSOR_OFFSET,
-                    editor.tabs.at(editor.current_tab)->get_cursor_y()
-                };
+            // Draw cursor at correct position
+            if (cursor.width() > 0 && cursor.intersects(region)) {
                 DrawTextEx(
                     GetFontDefault(),
                     "|",
-                    cursor_pos,
+                    {cursor.x(), cursor.y()},
                     editor.font_size,
                     0,
-                    editor.tabs.at(editor.current_tab)->text_area->cursor_visible ? SKYBLUE : BLANK);
+                    SKYBLUE);
             }
-        }
-
-        auto x_start = static_cast<float>(editor.content_start.x - GRIP_GAP);
-        auto x_end = static_cast<float>(editor.content_start.x - GRIP_GAP);
-        auto y_end = static_cast<float>(GetScreenHeight() - MENU_BAR_WIDTH);
 
-        // line between file tree and buffer view
-        DrawLineEx({x_start, 0}, {x_end, y_end},GUI_LINE_WIDTH,WHITE);
+            auto x_start = static_cast<float>(editor.content_start.x - GRIP_GAP);
+            auto x_end = static_cast<float>(editor.content_start.x - GRIP_GAP);
+            auto y_end = static_cast<float>(GetScreenHeight() - MENU_BAR_WIDTH);
 
-        // line between main content and bottom bar
-        DrawLineEx({0, y_end}, {static_cast<float>(GetScreenWidth()), y_end},GUI_LINE_WIDTH,WHITE);
+            // line between file tree and buffer view
+            DrawLineEx({x_start, 0}, {x_end, y_end},GUI_LINE_WIDTH,WHITE);
 
+            // line between main content and bottom bar
+            DrawLineEx({0, y_end}, {static_cast<float>(GetScreenWidth()), y_end},GUI_LINE_WIDTH,WHITE);
+        });
+        back_buffer.present();
         EndDrawing();
+
+        // Nothing pending: sleep until input or the cursor's next blink instead of drawing at 120 FPS
+        if (!changed) {
+            double timeout = IDLE_MAX_WAIT;
+            if (!editor.tabs.empty() && editor.is_focused) {
+                const auto& text_area = editor.tabs.at(editor.current_tab)->text_area;
+                timeout = std::max(0.0f, text_area->cursor_blink_rate - text_area->cursor_blink_timer);
+            }
+            plastic::RaylibPlatform::wait_for_input(timeout);
+        }
     }
     CloseWindow();
     return 0;
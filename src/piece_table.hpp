@@ -73,6 +73,8 @@ private:
         void undo() override {
             table.add_buffer.resize(add_buffer_length_before);
             table.pieces = old_pieces;
+            table.total_length -= text.length();
+            table.line_cache.invalidate();
         }
     };
 
@@ -177,11 +179,6 @@ public:
         // Clamp end position to validate range
         end = std::min(end, total_length);
 
-
-
-        std::cout << "Removing from " << start << " to " << end << std::endl;
-        std::cout << "Text before: " << get_text() << std::endl;
-
         std::vector<Piece> new_pieces;
         size_t current_pos = 0;
 
@@ -224,11 +221,9 @@ public:
         pieces = std::move(new_pieces);
         total_length -= (end - start);
         line_cache.invalidate();
-
-        std::cout << "Text after: " << get_text() << std::endl;
     }
 
-    explicit PieceTable(const std::string& initial = "") : original_buffer(initial) {
+    explicit PieceTable(const std::string& initial = "") : total_length(initial.length()), original_buffer(initial) {
         if (!initial.empty()) {
             pieces.emplace_back(true, 0, initial.length());
         }
@@ -256,6 +251,10 @@ public:
         }
     }
 
+    [[nodiscard]] size_t length() const {
+        return total_length;
+    }
+
     [[nodiscard]] bool can_undo() const {
         return !undo_stack.empty();
     }
@@ -298,7 +297,7 @@ public:
             size_t piece_end = current_pos + piece.length;
 
             if (current_pos < end && piece_end > start) {
-                size_t pieceStart = std::max(start - current_pos, static_cast<size_t>(0));
+                size_t pieceStart = start > current_pos ? start - current_pos : 0;
                 size_t pieceLength = std::min(piece.length - pieceStart,
                                             end - (current_pos + pieceStart));
 